@@ -0,0 +1,64 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "arena.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static size_t page_size(void) {
+    long page = sysconf(_SC_PAGESIZE);
+    return (page > 0) ? (size_t)page : 4096;
+}
+
+size_t arena_round(size_t size) {
+    return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+int arena_init(Arena *a, size_t size) {
+    memset(a, 0, sizeof(Arena));
+
+    // Whole pages, so locking covers nothing outside the arena
+    size_t page = page_size();
+    size = (size + page - 1) / page * page;
+
+    void *base;
+    if (posix_memalign(&base, page, size) != 0) return -1;
+
+    // Writing every page now means the audio thread never takes the first fault
+    memset(base, 0, size);
+    a->base = base;
+    a->size = size;
+    return 0;
+}
+
+void arena_free(Arena *a) {
+    if (!a->base) return;
+    if (a->locked) munlock(a->base, a->size);
+    free(a->base);
+    memset(a, 0, sizeof(Arena));
+}
+
+int arena_lock(Arena *a) {
+    if (a->locked) return 0;
+    if (!a->base || mlock(a->base, a->size) != 0) return -1;
+    a->locked = 1;
+    return 0;
+}
+
+void *arena_alloc(Arena *a, size_t size) {
+    size = arena_round(size);
+    if (size > a->size - a->used) return NULL;
+    void *p = a->base + a->used;
+    a->used += size;
+    return p;
+}
+
+int arena_lock_region(void *p, size_t size) {
+    // mlock works on whole pages; widen the range to them
+    size_t page = page_size();
+    uintptr_t start = (uintptr_t)p / page * page;
+    uintptr_t end = ((uintptr_t)p + size + page - 1) / page * page;
+    return mlock((void *)start, end - start) == 0 ? 0 : -1;
+}
@@ -0,0 +1,39 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Memory arena for DSP state.
+// One block sized up front, zeroed (which touches every page) and locked into
+// RAM, then carved into cache-line aligned pieces. Nothing the audio thread
+// reads from it can page-fault, even after a long idle. Pieces are never
+// freed on their own; the whole arena goes at once.
+
+#define ARENA_ALIGN 64          // Cache line, and wide enough for any SIMD load
+
+typedef struct {
+    unsigned char *base;
+    size_t size;
+    size_t used;
+    int locked;                 // mlock() succeeded
+} Arena;
+
+// Reserve a zeroed block of at least `size` bytes. Returns 0 or -1.
+int arena_init(Arena *a, size_t size);
+void arena_free(Arena *a);
+
+// Lock the whole block into RAM. Returns 0, or -1 if the system refused
+// (RLIMIT_MEMLOCK); the arena still works, it is just pageable.
+int arena_lock(Arena *a);
+
+// Carve a zeroed, ARENA_ALIGN-aligned piece. NULL when the arena is full.
+void *arena_alloc(Arena *a, size_t size);
+
+// Bytes arena_alloc uses up for a piece of `size` (for sizing the arena)
+size_t arena_round(size_t size);
+
+// Fault in and lock memory the arena does not own, such as static tables.
+// Returns 0 or -1.
+int arena_lock_region(void *p, size_t size);
+
+#endif // ARENA_H
@@ -0,0 +1,34 @@
+#include "audiodev.h"
+#include <alsa/asoundlib.h>
+
+int audiodev_native_rate(void) {
+    snd_pcm_t *pcm;
+    if (snd_pcm_open(&pcm, "default", SND_PCM_STREAM_PLAYBACK, SND_PCM_NONBLOCK) < 0) {
+        return 0;
+    }
+
+    snd_pcm_hw_params_t *hw;
+    if (snd_pcm_hw_params_malloc(&hw) < 0) {
+        snd_pcm_close(pcm);
+        return 0;
+    }
+
+    unsigned int rate = 0;
+    unsigned int min_rate, max_rate;
+    int dir = 0;
+    if (snd_pcm_hw_params_any(pcm, hw) >= 0 &&
+        snd_pcm_hw_params_get_rate_min(hw, &min_rate, &dir) >= 0 &&
+        snd_pcm_hw_params_get_rate_max(hw, &max_rate, &dir) >= 0) {
+        if (min_rate == max_rate) {
+            rate = min_rate;
+        } else if (snd_pcm_hw_params_test_rate(pcm, hw, 48000, 0) == 0) {
+            rate = 48000;
+        } else if (snd_pcm_hw_params_test_rate(pcm, hw, 44100, 0) == 0) {
+            rate = 44100;
+        }
+    }
+
+    snd_pcm_hw_params_free(hw);
+    snd_pcm_close(pcm);
+    return (int)rate;
+}
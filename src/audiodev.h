@@ -0,0 +1,12 @@
+#ifndef AUDIODEV_H
+#define AUDIODEV_H
+
+// Output device queries (ALSA). Rendering at the device's own rate keeps the
+// audio path free of a resampler.
+
+// Native sample rate of the default playback device, 0 if unknown.
+// A fixed-rate device (hw, dmix) reports its rate; a device that converts
+// (plug, PulseAudio) reports 48000 or 44100, whichever it accepts first.
+int audiodev_native_rate(void);
+
+#endif // AUDIODEV_H
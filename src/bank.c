@@ -0,0 +1,220 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "bank.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static uint32_t fnv1a(uint32_t h, const void *data, size_t size) {
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Records are only meaningful for the parameter layout they were built with
+static uint32_t layout_hash(void) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < PARAM_COUNT; i++) {
+        const ParamDesc *d = param_desc((ParamId)i);
+        h = fnv1a(h, d->section, strlen(d->section) + 1);
+        h = fnv1a(h, d->key, strlen(d->key) + 1);
+    }
+    return h;
+}
+
+int bank_open(Bank *b, const char *path) {
+    memset(b, 0, sizeof(*b));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(BankHeader)) {
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    const BankHeader *h = (const BankHeader *)map;
+    size_t size = (size_t)st.st_size;
+    size_t entries_size = (size_t)h->record_count * sizeof(BankEntry);
+    size_t records_size = (size_t)h->record_count * PARAM_COUNT * sizeof(float);
+    size_t maps_size = (size_t)h->map_count * sizeof(MidiMapEntry);
+
+    const char *error = NULL;
+    if (h->magic != BANK_MAGIC) {
+        error = "not a preset bank";
+    } else if (h->version != BANK_VERSION) {
+        error = "unsupported version";
+    } else if (h->param_count != PARAM_COUNT || h->layout_hash != layout_hash()) {
+        error = "parameter layout changed, rebuild with mkbank";
+    } else if (h->entries_offset + entries_size > size ||
+               h->records_offset + records_size > size ||
+               h->maps_offset + maps_size > size ||
+               h->records_offset % sizeof(float) != 0 || h->maps_offset % sizeof(float) != 0) {
+        error = "truncated";
+    } else if (fnv1a(2166136261u, (const unsigned char *)map + sizeof(BankHeader),
+                     size - sizeof(BankHeader)) != h->checksum) {
+        error = "checksum mismatch";
+    }
+
+    if (error) {
+        fprintf(stderr, "Bank: %s: %s\n", path, error);
+        munmap(map, st.st_size);
+        return -1;
+    }
+
+    // Read the whole bank in now so recalling a slot never waits on the SD card
+    posix_madvise(map, size, POSIX_MADV_WILLNEED);
+
+    b->map = (const unsigned char *)map;
+    b->size = size;
+    b->header = h;
+    b->entries = (const BankEntry *)(b->map + h->entries_offset);
+    b->records = (const float *)(b->map + h->records_offset);
+    b->maps = (const MidiMapEntry *)(b->map + h->maps_offset);
+
+    // Map rows are indexed from the entries; keep them inside the table
+    for (uint32_t i = 0; i < h->record_count; i++) {
+        const BankEntry *e = &b->entries[i];
+        if (e->map_count > MIDIMAP_LIST_MAX ||
+            (e->map_count > 0 && (e->map_first < 0 || (uint32_t)(e->map_first + e->map_count) > h->map_count))) {
+            fprintf(stderr, "Bank: %s: bad controller map\n", path);
+            bank_close(b);
+            return -1;
+        }
+    }
+    b->mtime = (long)st.st_mtime;
+    return 0;
+}
+
+void bank_close(Bank *b) {
+    if (b->map) {
+        munmap((void *)b->map, b->size);
+    }
+    memset(b, 0, sizeof(*b));
+}
+
+int bank_count(const Bank *b) {
+    return b->map ? (int)b->header->record_count : 0;
+}
+
+int bank_find(const Bank *b, int slot) {
+    // Entries are sorted by slot: binary search
+    int lo = 0;
+    int hi = bank_count(b) - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int s = b->entries[mid].slot;
+        if (s == slot) return mid;
+        if (s < slot) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return -1;
+}
+
+int bank_find_current(const Bank *b, int slot, const char *source_path) {
+    int index = bank_find(b, slot);
+    if (index < 0) return -1;
+
+    struct stat st;
+    if (source_path && stat(source_path, &st) == 0 && (long)st.st_mtime > b->mtime) {
+        return -1;  // JSON saved after the bank was compiled
+    }
+    return index;
+}
+
+int bank_max_slot(const Bank *b) {
+    int count = bank_count(b);
+    return count > 0 ? b->entries[count - 1].slot : 0;
+}
+
+void bank_get(const Bank *b, int index, Patch *out) {
+    memcpy(out->values, b->records + (size_t)index * PARAM_COUNT, sizeof(out->values));
+    const BankEntry *e = &b->entries[index];
+    out->map.count = e->map_count;
+    if (e->map_count > 0) {
+        memcpy(out->map.entries, b->maps + e->map_first, e->map_count * sizeof(MidiMapEntry));
+    }
+}
+
+const BankEntry* bank_entry(const Bank *b, int index) {
+    return &b->entries[index];
+}
+
+int bank_write(const char *path, const Patch *patches, const BankEntry *entries, int count) {
+    // The entry table records where each preset's map rows start
+    BankEntry *table = malloc((count > 0 ? count : 1) * sizeof(BankEntry));
+    if (!table) return -1;
+    int32_t rows = 0;
+    for (int i = 0; i < count; i++) {
+        table[i] = entries[i];
+        table[i].map_first = rows;
+        table[i].map_count = patches[i].map.count;
+        if (patches[i].map.count > 0) rows += patches[i].map.count;
+    }
+
+    BankHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = BANK_MAGIC;
+    h.version = BANK_VERSION;
+    h.param_count = PARAM_COUNT;
+    h.layout_hash = layout_hash();
+    h.record_count = (uint32_t)count;
+    h.entries_offset = sizeof(BankHeader);
+    h.records_offset = h.entries_offset + count * sizeof(BankEntry);
+    h.maps_offset = h.records_offset + count * sizeof(patches[0].values);
+    h.map_count = (uint32_t)rows;
+
+    // Checksum covers the entry table, records and maps, in file order
+    uint32_t sum = 2166136261u;
+    sum = fnv1a(sum, table, count * sizeof(BankEntry));
+    for (int i = 0; i < count; i++) {
+        sum = fnv1a(sum, patches[i].values, sizeof(patches[i].values));
+    }
+    for (int i = 0; i < count; i++) {
+        if (patches[i].map.count > 0) {
+            sum = fnv1a(sum, patches[i].map.entries, patches[i].map.count * sizeof(MidiMapEntry));
+        }
+    }
+    h.checksum = sum;
+
+    // Write to a temp file and rename so a running synth never maps a partial bank
+    char tmp[256];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    if (!f) {
+        free(table);
+        return -1;
+    }
+
+    int ok = fwrite(&h, sizeof(h), 1, f) == 1;
+    if (count > 0) {
+        ok = ok && fwrite(table, sizeof(BankEntry), count, f) == (size_t)count;
+    }
+    for (int i = 0; i < count && ok; i++) {
+        ok = fwrite(patches[i].values, sizeof(patches[i].values), 1, f) == 1;
+    }
+    for (int i = 0; i < count && ok; i++) {
+        int n = patches[i].map.count;
+        if (n > 0) ok = fwrite(patches[i].map.entries, sizeof(MidiMapEntry), n, f) == (size_t)n;
+    }
+    free(table);
+
+    if (fclose(f) != 0) ok = 0;
+    if (!ok || rename(tmp, path) != 0) {
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+#ifndef BANK_H
+#define BANK_H
+
+#include "patch.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Compiled preset bank.
+// JSON presets stay the editable source; tools/mkbank.c compiles them into a
+// single binary file that is memory-mapped at startup. Every record is a
+// fixed-layout copy of Patch's values, and a preset's controller map is
+// stored as flat MidiMapEntry rows, so recalling a slot is a straight memcpy.
+//
+// File layout (native byte order, all offsets from start of file):
+//   BankHeader
+//   BankEntry[record_count]            name/tag table, sorted by slot
+//   float[record_count][param_count]   parameter records
+//   MidiMapEntry[map_count]            controller maps, in entry order
+
+#define BANK_FILE       "presets/bank.bsb"
+#define BANK_MAGIC      0x4B425342u   // "BSBK"
+#define BANK_VERSION    2
+#define BANK_NAME_LEN   32
+#define BANK_TAG_LEN    32
+#define BANK_MAX_SLOT   999           // Slot numbers share the 3-digit JSON naming
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t param_count;       // Floats per record (PARAM_COUNT when built)
+    uint32_t layout_hash;       // Hash of parameter keys in ID order
+    uint32_t record_count;
+    uint32_t entries_offset;
+    uint32_t records_offset;
+    uint32_t maps_offset;
+    uint32_t map_count;         // MidiMapEntry rows in the file
+    uint32_t checksum;          // FNV-1a of everything after the header
+} BankHeader;
+
+typedef struct {
+    int32_t slot;
+    char name[BANK_NAME_LEN];
+    char tags[BANK_TAG_LEN];
+    int32_t map_first;          // First MidiMapEntry row (filled in by bank_write)
+    int32_t map_count;          // Rows, or -1 if the preset has no midi_map
+} BankEntry;
+
+typedef struct {
+    const unsigned char *map;   // Mapped file (NULL if no bank is open)
+    size_t size;
+    const BankHeader *header;
+    const BankEntry *entries;
+    const float *records;
+    const MidiMapEntry *maps;
+    long mtime;                 // Modification time of the bank file
+} Bank;
+
+// Map and validate a bank file (returns 0 on success)
+int bank_open(Bank *b, const char *path);
+void bank_close(Bank *b);
+
+int bank_count(const Bank *b);
+
+// Find the record index for a preset slot (-1 if not in the bank)
+int bank_find(const Bank *b, int slot);
+
+// Like bank_find, but ignores the record if source_path (the JSON preset)
+// has been modified since the bank was built
+int bank_find_current(const Bank *b, int slot, const char *source_path);
+
+// Highest slot number in the bank (0 if empty)
+int bank_max_slot(const Bank *b);
+
+// Copy a record and its controller map into a patch (straight copy, no parsing)
+void bank_get(const Bank *b, int index, Patch *out);
+
+const BankEntry* bank_entry(const Bank *b, int index);
+
+// Write a bank file from patches and entries (entries must be sorted by slot)
+int bank_write(const char *path, const Patch *patches, const BankEntry *entries, int count);
+
+#endif // BANK_H
@@ -0,0 +1,31 @@
+#include "crossfade.h"
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846f
+#endif
+
+void crossfade_begin(Crossfade *xf, const Synth *s, int length) {
+    xf->synth = *s;
+    xf->length = (length > 0) ? length : 1;
+    xf->remaining = xf->length;
+}
+
+Stereo crossfade_process(Crossfade *xf, Stereo new_sample) {
+    if (xf->remaining <= 0) {
+        return new_sample;
+    }
+
+    Stereo old_sample = synth_process(&xf->synth);
+
+    // Equal-power gains: cos/sin over a quarter period
+    float t = 1.0f - (float)xf->remaining / (float)xf->length;
+    float angle = t * 0.5f * M_PI;
+    xf->remaining--;
+
+    return old_sample * cosf(angle) + new_sample * sinf(angle);
+}
+
+int crossfade_active(const Crossfade *xf) {
+    return xf->remaining > 0;
+}
@@ -0,0 +1,28 @@
+#ifndef CROSSFADE_H
+#define CROSSFADE_H
+
+#include "synth.h"
+
+// Default preset crossfade length
+#define CROSSFADE_MS 30.0f
+
+// Equal-power crossfade between the outgoing and incoming sound of a part.
+// On a preset switch the part's synth is copied here and keeps rendering with
+// the old settings while the live synth switches to the new ones, so sustained
+// notes fade instead of jumping. The shared effects are not copied: their
+// tails carry on and their mix/feedback/drive changes are already smoothed.
+typedef struct {
+    Synth synth;
+    int length;         // Fade length in samples
+    int remaining;      // Samples left (0 = inactive)
+} Crossfade;
+
+// Snapshot the outgoing synth and start a fade of the given length
+void crossfade_begin(Crossfade *xf, const Synth *s, int length);
+
+// Mix the next sample: renders the old synth and blends it with new_sample
+Stereo crossfade_process(Crossfade *xf, Stereo new_sample);
+
+int crossfade_active(const Crossfade *xf);
+
+#endif // CROSSFADE_H
@@ -1,28 +1,34 @@
 #include "effects.h"
 #include <math.h>
 #include <string.h>
+#include <pthread.h>
 
-// Comb filter delay times (in samples, tuned for ~44100Hz)
+// Comb filter delay times (in samples at TUNING_RATE, scaled to the output rate)
+#define TUNING_RATE 44100.0f
 static const int COMB_TUNINGS[NUM_COMB_FILTERS] = {1116, 1188, 1277, 1356};
 // Allpass filter delay times
 static const int ALLPASS_TUNINGS[NUM_ALLPASS_FILTERS] = {556, 441};
 
 //------------------------------------------------------------------------------
 // Tanh lookup table for distortion (avoid per-sample tanhf)
+// Built once per process and read-only after that, so every Effects
+// instance shares it.
 //------------------------------------------------------------------------------
 #define TANH_TABLE_SIZE 1024
 #define TANH_RANGE 5.0f  // table covers -5.0 to +5.0
 
 static float tanh_table[TANH_TABLE_SIZE];
-static int tanh_table_initialized = 0;
+static pthread_once_t tanh_table_once = PTHREAD_ONCE_INIT;
 
-static void init_tanh_table(void) {
-    if (tanh_table_initialized) return;
+static void build_tanh_table(void) {
     for (int i = 0; i < TANH_TABLE_SIZE; i++) {
         float x = ((float)i / (TANH_TABLE_SIZE - 1)) * 2.0f * TANH_RANGE - TANH_RANGE;
         tanh_table[i] = tanhf(x);
     }
-    tanh_table_initialized = 1;
+}
+
+static void init_tanh_table(void) {
+    pthread_once(&tanh_table_once, build_tanh_table);
 }
 
 static float fast_tanh(float x) {
@@ -45,20 +51,30 @@ static float fast_tanh(float x) {
 // Delay
 //------------------------------------------------------------------------------
 
+// Lines are allocated by effects_alloc
 static void delay_init(Delay *d) {
-    memset(d->buffer, 0, sizeof(d->buffer));
     d->write_pos = 0;
     d->time = 0.3f;
     d->feedback = 0.4f;
     d->mix = 0.3f;
+    d->pingpong = 0;
+    smoother_init(&d->feedback_smooth, d->feedback, SMOOTH_TIME_MS);
+    smoother_init(&d->mix_smooth, d->mix, SMOOTH_TIME_MS);
 }
 
 void delay_set_time(Delay *d, float time) {
+    float longest = delay_max_time(d);
     if (time < 0.01f) time = 0.01f;
-    if (time > 1.0f) time = 1.0f;
+    if (time > longest) time = longest;
     d->time = time;
 }
 
+float delay_max_time(const Delay *d) {
+    if (d->length <= 1) return DELAY_MAX_TIME;
+    float longest = (d->length - 1) / sample_rate;
+    return (longest < DELAY_MAX_TIME) ? longest : DELAY_MAX_TIME;
+}
+
 void delay_set_feedback(Delay *d, float feedback) {
     if (feedback < 0.0f) feedback = 0.0f;
     if (feedback > 0.9f) feedback = 0.9f;
@@ -71,80 +87,106 @@ void delay_set_mix(Delay *d, float mix) {
     d->mix = mix;
 }
 
-static float delay_process(Delay *d, float input) {
-    int delay_samples = (int)(d->time * SAMPLE_RATE);
-    if (delay_samples >= DELAY_BUFFER_SIZE) {
-        delay_samples = DELAY_BUFFER_SIZE - 1;
+void delay_set_pingpong(Delay *d, int pingpong) {
+    d->pingpong = pingpong ? 1 : 0;
+}
+
+static Stereo delay_process(Delay *d, Stereo input) {
+    int delay_samples = (int)(d->time * sample_rate);
+    if (delay_samples >= d->length) {
+        delay_samples = d->length - 1;
     }
 
     int read_pos = d->write_pos - delay_samples;
     if (read_pos < 0) {
-        read_pos += DELAY_BUFFER_SIZE;
+        read_pos += d->length;
     }
 
-    float delayed = d->buffer[read_pos];
-    float output = input + delayed * d->feedback;
+    Stereo delayed = d->buffer[read_pos];
+    Stereo repeat = delayed * d->feedback_smooth.value;
 
-    d->buffer[d->write_pos] = output;
-    d->write_pos = (d->write_pos + 1) % DELAY_BUFFER_SIZE;
+    // Ping-pong: the input enters on the left and each repeat crosses over
+    if (d->pingpong) {
+        d->buffer[d->write_pos] = stereo(0.5f * (input[0] + input[1]), 0.0f) + stereo_swap(repeat);
+    } else {
+        d->buffer[d->write_pos] = input + repeat;
+    }
+    if (++d->write_pos == d->length) d->write_pos = 0;
 
-    return input * (1.0f - d->mix) + delayed * d->mix;
+    float mix = d->mix_smooth.value;
+    return input * (1.0f - mix) + delayed * mix;
 }
 
 //------------------------------------------------------------------------------
 // Reverb (Schroeder style)
 //------------------------------------------------------------------------------
 
-static void comb_init(CombFilter *c, int size, float feedback) {
-    memset(c->buffer, 0, sizeof(c->buffer));
-    c->size = (size < COMB_BUFFER_SIZE) ? size : COMB_BUFFER_SIZE - 1;
+// Left and right taps of a line: size and size + spread samples back
+#define LINE_READ(line, mask, size, spread, pos) \
+    stereo((line)[((pos) - (size)) & (mask)][0], (line)[((pos) - (size) - (spread)) & (mask)][1])
+
+// Power-of-two ring long enough to read `reach` samples back
+static int line_length(int reach) {
+    int length = 1;
+    while (length <= reach) length <<= 1;
+    return length;
+}
+
+static int tuned(int samples) {
+    return (int)(samples * sample_rate / TUNING_RATE);
+}
+
+static int delay_length(float max_delay) {
+    if (max_delay < 0.01f) max_delay = 0.01f;
+    return (int)(max_delay * sample_rate) + 1;
+}
+
+static void comb_init(CombFilter *c, int size, int spread, float feedback) {
+    c->size = size;
+    c->spread = spread;
     c->pos = 0;
     c->feedback = feedback;
 }
 
-static float comb_process(CombFilter *c, float input) {
-    float output = c->buffer[c->pos];
+static Stereo comb_process(CombFilter *c, Stereo input) {
+    Stereo output = LINE_READ(c->buffer, c->mask, c->size, c->spread, c->pos);
     c->buffer[c->pos] = input + output * c->feedback;
-    c->pos = (c->pos + 1) % c->size;
+    c->pos = (c->pos + 1) & c->mask;
     return output;
 }
 
-static void allpass_init(AllpassFilter *a, int size, float feedback) {
-    memset(a->buffer, 0, sizeof(a->buffer));
-    a->size = (size < ALLPASS_BUFFER_SIZE) ? size : ALLPASS_BUFFER_SIZE - 1;
+static void allpass_init(AllpassFilter *a, int size, int spread, float feedback) {
+    a->size = size;
+    a->spread = spread;
     a->pos = 0;
     a->feedback = feedback;
 }
 
-static float allpass_process(AllpassFilter *a, float input) {
-    float buffered = a->buffer[a->pos];
-    float output = -input + buffered;
+static Stereo allpass_process(AllpassFilter *a, Stereo input) {
+    Stereo buffered = LINE_READ(a->buffer, a->mask, a->size, a->spread, a->pos);
+    Stereo output = buffered - input;
     a->buffer[a->pos] = input + buffered * a->feedback;
-    a->pos = (a->pos + 1) % a->size;
+    a->pos = (a->pos + 1) & a->mask;
     return output;
 }
 
 static void reverb_init(Reverb *r) {
+    int spread = tuned(STEREO_SPREAD);
     for (int i = 0; i < NUM_COMB_FILTERS; i++) {
-        comb_init(&r->combs[i], COMB_TUNINGS[i], 0.84f);
+        comb_init(&r->combs[i], tuned(COMB_TUNINGS[i]), spread, 0.84f);
     }
     for (int i = 0; i < NUM_ALLPASS_FILTERS; i++) {
-        allpass_init(&r->allpasses[i], ALLPASS_TUNINGS[i], 0.5f);
+        allpass_init(&r->allpasses[i], tuned(ALLPASS_TUNINGS[i]), spread, 0.5f);
     }
     r->mix = 0.2f;
     r->roomsize = 0.5f;
+    smoother_init(&r->mix_smooth, r->mix, SMOOTH_TIME_MS);
 }
 
 void reverb_set_roomsize(Reverb *r, float size) {
     if (size < 0.0f) size = 0.0f;
     if (size > 1.0f) size = 1.0f;
     r->roomsize = size;
-
-    // Adjust comb filter feedback based on room size
-    float feedback = 0.7f + size * 0.28f;  // 0.7 to 0.98
-    for (int i = 0; i < NUM_COMB_FILTERS; i++) {
-        r->combs[i].feedback = feedback;
-    }
 }
 
 void reverb_set_mix(Reverb *r, float mix) {
@@ -153,21 +195,22 @@ void reverb_set_mix(Reverb *r, float mix) {
     r->mix = mix;
 }
 
-static float reverb_process(Reverb *r, float input) {
+static Stereo reverb_process(Reverb *r, Stereo input) {
     // Sum of parallel comb filters
-    float comb_sum = 0.0f;
+    Stereo comb_sum = stereo_mono(0.0f);
     for (int i = 0; i < NUM_COMB_FILTERS; i++) {
         comb_sum += comb_process(&r->combs[i], input);
     }
-    comb_sum /= NUM_COMB_FILTERS;
+    comb_sum *= 1.0f / NUM_COMB_FILTERS;
 
     // Series allpass filters
-    float output = comb_sum;
+    Stereo output = comb_sum;
     for (int i = 0; i < NUM_ALLPASS_FILTERS; i++) {
         output = allpass_process(&r->allpasses[i], output);
     }
 
-    return input * (1.0f - r->mix) + output * r->mix;
+    float mix = r->mix_smooth.value;
+    return input * (1.0f - mix) + output * mix;
 }
 
 //------------------------------------------------------------------------------
@@ -178,6 +221,10 @@ static void distortion_init(Distortion *d) {
     init_tanh_table();
     d->drive = 1.0f;
     d->mix = 0.0f;
+    smoother_init(&d->drive_smooth, d->drive, SMOOTH_TIME_MS);
+    smoother_init(&d->mix_smooth, d->mix, SMOOTH_TIME_MS);
+    d->norm_drive = d->drive;
+    d->drive_norm = fast_tanh(d->drive);
 }
 
 void distortion_set_drive(Distortion *d, float drive) {
@@ -192,37 +239,137 @@ void distortion_set_mix(Distortion *d, float mix) {
     d->mix = mix;
 }
 
-static float distortion_process(Distortion *d, float input) {
+static Stereo distortion_process(Distortion *d, Stereo input) {
     // Apply drive
-    float driven = input * d->drive;
+    float drive = d->drive_smooth.value;
+    Stereo driven = input * drive;
 
-    // Soft clip using fast tanh lookup
-    float distorted = fast_tanh(driven);
+    // Soft clip using fast tanh lookup (a table read per channel)
+    Stereo distorted = stereo(fast_tanh(driven[0]), fast_tanh(driven[1]));
 
     // Normalize output (compensate for drive) - use cached value
-    static float last_drive = 0.0f;
-    static float drive_norm = 1.0f;
-    if (d->drive != last_drive) {
-        last_drive = d->drive;
-        drive_norm = fast_tanh(d->drive);
+    if (drive != d->norm_drive) {
+        d->norm_drive = drive;
+        d->drive_norm = fast_tanh(drive);
     }
-    distorted /= drive_norm;
+    distorted *= 1.0f / d->drive_norm;
 
-    return input * (1.0f - d->mix) + distorted * d->mix;
+    float mix = d->mix_smooth.value;
+    return input * (1.0f - mix) + distorted * mix;
 }
 
 //------------------------------------------------------------------------------
 // Effects Chain
 //------------------------------------------------------------------------------
 
+void effects_clear(Effects *fx) {
+    memset(fx->delay.buffer, 0, fx->delay.length * sizeof(Stereo));
+    for (int i = 0; i < NUM_COMB_FILTERS; i++) {
+        memset(fx->reverb.combs[i].buffer, 0, (fx->reverb.combs[i].mask + 1) * sizeof(Stereo));
+    }
+    for (int i = 0; i < NUM_ALLPASS_FILTERS; i++) {
+        memset(fx->reverb.allpasses[i].buffer, 0, (fx->reverb.allpasses[i].mask + 1) * sizeof(Stereo));
+    }
+}
+
 void effects_init(Effects *fx) {
+    memset(fx, 0, sizeof(Effects));
     delay_init(&fx->delay);
     reverb_init(&fx->reverb);
     distortion_init(&fx->distortion);
 }
 
-float effects_process(Effects *fx, float input) {
-    float signal = input;
+float effects_silent_gap(float max_delay) {
+    int spread = tuned(STEREO_SPREAD);
+    int comb = 0;
+    for (int i = 0; i < NUM_COMB_FILTERS; i++) {
+        if (tuned(COMB_TUNINGS[i]) > comb) comb = tuned(COMB_TUNINGS[i]);
+    }
+    int reverb = comb + spread;
+    for (int i = 0; i < NUM_ALLPASS_FILTERS; i++) {
+        reverb += tuned(ALLPASS_TUNINGS[i]) + spread;
+    }
+    return delay_length(max_delay) / sample_rate + reverb / sample_rate;
+}
+
+size_t effects_memory(float max_delay) {
+    int spread = tuned(STEREO_SPREAD);
+    size_t bytes = arena_round(delay_length(max_delay) * sizeof(Stereo));
+    for (int i = 0; i < NUM_COMB_FILTERS; i++) {
+        bytes += arena_round(line_length(tuned(COMB_TUNINGS[i]) + spread) * sizeof(Stereo));
+    }
+    for (int i = 0; i < NUM_ALLPASS_FILTERS; i++) {
+        bytes += arena_round(line_length(tuned(ALLPASS_TUNINGS[i]) + spread) * sizeof(Stereo));
+    }
+    return bytes;
+}
+
+// One zeroed line from the arena (NULL if it is full)
+static Stereo *alloc_line(Arena *arena, int length) {
+    return (Stereo *)arena_alloc(arena, length * sizeof(Stereo));
+}
+
+int effects_alloc(Effects *fx, Arena *arena, float max_delay) {
+    Delay *d = &fx->delay;
+    d->length = delay_length(max_delay);
+    d->buffer = alloc_line(arena, d->length);
+    if (!d->buffer) return -1;
+    delay_set_time(d, d->time);
+
+    for (int i = 0; i < NUM_COMB_FILTERS; i++) {
+        CombFilter *c = &fx->reverb.combs[i];
+        c->mask = line_length(c->size + c->spread) - 1;
+        c->buffer = alloc_line(arena, c->mask + 1);
+        if (!c->buffer) return -1;
+    }
+    for (int i = 0; i < NUM_ALLPASS_FILTERS; i++) {
+        AllpassFilter *a = &fx->reverb.allpasses[i];
+        a->mask = line_length(a->size + a->spread) - 1;
+        a->buffer = alloc_line(arena, a->mask + 1);
+        if (!a->buffer) return -1;
+    }
+    return 0;
+}
+
+void effects_copy(Effects *dst, const Effects *src) {
+    Stereo *delay_line = dst->delay.buffer;
+    Stereo *comb_lines[NUM_COMB_FILTERS];
+    Stereo *allpass_lines[NUM_ALLPASS_FILTERS];
+    for (int i = 0; i < NUM_COMB_FILTERS; i++) comb_lines[i] = dst->reverb.combs[i].buffer;
+    for (int i = 0; i < NUM_ALLPASS_FILTERS; i++) allpass_lines[i] = dst->reverb.allpasses[i].buffer;
+
+    *dst = *src;
+
+    dst->delay.buffer = delay_line;
+    memcpy(delay_line, src->delay.buffer, src->delay.length * sizeof(Stereo));
+    for (int i = 0; i < NUM_COMB_FILTERS; i++) {
+        CombFilter *c = &dst->reverb.combs[i];
+        c->buffer = comb_lines[i];
+        memcpy(c->buffer, src->reverb.combs[i].buffer, (c->mask + 1) * sizeof(Stereo));
+    }
+    for (int i = 0; i < NUM_ALLPASS_FILTERS; i++) {
+        AllpassFilter *a = &dst->reverb.allpasses[i];
+        a->buffer = allpass_lines[i];
+        memcpy(a->buffer, src->reverb.allpasses[i].buffer, (a->mask + 1) * sizeof(Stereo));
+    }
+}
+
+void effects_control_update(Effects *fx) {
+    smoother_next(&fx->delay.feedback_smooth, fx->delay.feedback);
+    smoother_next(&fx->delay.mix_smooth, fx->delay.mix);
+    smoother_next(&fx->reverb.mix_smooth, fx->reverb.mix);
+
+    // Comb filter feedback follows room size
+    float feedback = 0.7f + fx->reverb.roomsize * 0.28f;  // 0.7 to 0.98
+    for (int i = 0; i < NUM_COMB_FILTERS; i++) {
+        fx->reverb.combs[i].feedback = feedback;
+    }
+    smoother_next(&fx->distortion.drive_smooth, fx->distortion.drive);
+    smoother_next(&fx->distortion.mix_smooth, fx->distortion.mix);
+}
+
+Stereo effects_process(Effects *fx, Stereo input) {
+    Stereo signal = input;
 
     // Order: Distortion -> Delay -> Reverb
     signal = distortion_process(&fx->distortion, signal);
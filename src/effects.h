@@ -1,35 +1,51 @@
 #ifndef EFFECTS_H
 #define EFFECTS_H
 
-#include "oscillator.h"  // for SAMPLE_RATE
+#include "oscillator.h"  // for sample_rate
+#include "smooth.h"
+#include "stereo.h"
+#include "arena.h"
+#include <stddef.h>
 
-// Delay buffer size (max 1 second at 44100Hz)
-#define DELAY_BUFFER_SIZE 44100
+// The effects run in stereo, both channels as one 2-lane vector.
+// The delay and reverb lines are not part of the struct: effects_alloc
+// carves them from an arena sized for the sample rate and the longest delay.
 
-// Reverb uses comb and allpass filters
+#define DELAY_MAX_TIME 2.0f     // Longest delay time offered, seconds
+
+// Reverb uses comb and allpass filters. The right channel's lines are
+// STEREO_SPREAD samples (at 44.1 kHz) longer, which decorrelates the tails.
+// Line buffers are power-of-two rings, both channels in one.
 #define NUM_COMB_FILTERS 4
 #define NUM_ALLPASS_FILTERS 2
-#define COMB_BUFFER_SIZE 4096
-#define ALLPASS_BUFFER_SIZE 1024
+#define STEREO_SPREAD 23
 
 typedef struct {
-    float buffer[DELAY_BUFFER_SIZE];
+    Stereo *buffer;
+    int length;      // Samples in the line (longest delay + 1)
     int write_pos;
-    float time;      // delay time in seconds (0.0 - 1.0)
+    float time;      // delay time in seconds (0.01 - DELAY_MAX_TIME)
     float feedback;  // 0.0 - 0.9
     float mix;       // dry/wet 0.0 - 1.0
+    int pingpong;    // 1 = repeats alternate left and right
+    Smoother feedback_smooth;
+    Smoother mix_smooth;
 } Delay;
 
 typedef struct {
-    float buffer[COMB_BUFFER_SIZE];
-    int size;
-    int pos;
+    Stereo *buffer;
+    int mask;        // Line length - 1
+    int size;        // Left delay in samples
+    int spread;      // Extra delay of the right channel
+    int pos;         // Next write
     float feedback;
 } CombFilter;
 
 typedef struct {
-    float buffer[ALLPASS_BUFFER_SIZE];
+    Stereo *buffer;
+    int mask;
     int size;
+    int spread;
     int pos;
     float feedback;
 } AllpassFilter;
@@ -39,11 +55,16 @@ typedef struct {
     AllpassFilter allpasses[NUM_ALLPASS_FILTERS];
     float mix;      // dry/wet 0.0 - 1.0
     float roomsize; // 0.0 - 1.0
+    Smoother mix_smooth;
 } Reverb;
 
 typedef struct {
     float drive;    // 1.0 - 10.0
     float mix;      // dry/wet 0.0 - 1.0
+    Smoother drive_smooth;
+    Smoother mix_smooth;
+    float norm_drive;   // Drive the cached normalisation was computed for
+    float drive_norm;   // tanh(drive): full-scale output level, divided out
 } Distortion;
 
 typedef struct {
@@ -52,13 +73,44 @@ typedef struct {
     Distortion distortion;
 } Effects;
 
+// Settings only; effects_alloc must follow before anything is processed
 void effects_init(Effects *fx);
-float effects_process(Effects *fx, float input);
+
+// Arena bytes the lines take at the current sample rate with delays up to
+// max_delay seconds
+size_t effects_memory(float max_delay);
+
+// Give an initialised Effects its delay and reverb lines (silent).
+// Returns 0, or -1 if the arena is too small.
+int effects_alloc(Effects *fx, Arena *arena, float max_delay);
+
+// Copy everything, line contents included, into an Effects allocated with
+// the same max_delay; dst keeps its own lines
+void effects_copy(Effects *dst, const Effects *src);
+
+Stereo effects_process(Effects *fx, Stereo input);
+
+// Longest the effects can stay silent and still have something to play, in
+// seconds at the current rate: a repeat of the longest delay, then the
+// reverb's lines in series. Repeats come one delay time apart however high
+// the feedback is, and the feedback is below 1, so this does not grow with it.
+float effects_silent_gap(float max_delay);
+
+// Silence the delay and reverb lines (keeps every setting)
+void effects_clear(Effects *fx);
+
+// Advance parameter smoothing by one control block (audio thread)
+void effects_control_update(Effects *fx);
+
+// Longest time the delay line holds, seconds: max_delay from effects_alloc,
+// DELAY_MAX_TIME before it. Times above it are clamped.
+float delay_max_time(const Delay *d);
 
 // Individual effect controls
 void delay_set_time(Delay *d, float time);
 void delay_set_feedback(Delay *d, float feedback);
 void delay_set_mix(Delay *d, float mix);
+void delay_set_pingpong(Delay *d, int pingpong);
 
 void reverb_set_roomsize(Reverb *r, float size);
 void reverb_set_mix(Reverb *r, float mix);
@@ -0,0 +1,450 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "engine.h"
+#include "wavetable.h"
+#include "crossfade.h"
+#include "patch.h"
+#include "preset.h"
+#include "rtcheck.h"
+#include "trace.h"
+#include "perfctr.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+Engine *engine_create(int rate) {
+    EngineConfig config = {rate, 0.0f};
+    return engine_create_config(&config);
+}
+
+Engine *engine_create_config(const EngineConfig *config) {
+    // Rate-dependent tables are built from here on
+    set_sample_rate(config->rate > 0 ? config->rate : DEFAULT_SAMPLE_RATE);
+    wavetables_init();
+    params_init();
+
+    // One arena for the instance and its lines, sized for this rate
+    float max_delay = config->max_delay > 0.0f ? config->max_delay : DELAY_MAX_TIME;
+    Arena arena;
+    if (arena_init(&arena, arena_round(sizeof(Engine)) + effects_memory(max_delay)) < 0) {
+        return NULL;
+    }
+    Engine *e = arena_alloc(&arena, sizeof(Engine));
+    e->arena = arena;
+    e->max_delay = max_delay;
+    arena_lock(&e->arena);
+
+    multi_init(&e->multi);
+    effects_init(&e->effects);
+    effects_alloc(&e->effects, &e->arena, max_delay);
+    midimap_init(&e->midimap);
+    limiter_init(&e->limiter, sample_rate);
+    e->idle_hold = (unsigned long)((effects_silent_gap(max_delay) + ENGINE_IDLE_MARGIN) * sample_rate) +
+                   (unsigned long)limiter_latency(&e->limiter);
+    governor_init(&e->governor);
+    scope_init(&e->scope);
+    pthread_mutex_init(&e->lock, NULL);
+    e->preset_xfade = 1;
+    e->govern = 1;
+
+    if (loader_start(&e->loader) < 0) {
+        pthread_mutex_destroy(&e->lock);
+        arena = e->arena;
+        arena_free(&arena);
+        return NULL;
+    }
+
+    // Spare cores render parts in parallel
+    multi_start(&e->multi);
+    return e;
+}
+
+void engine_destroy(Engine *e) {
+    if (!e) return;
+    loader_stop(&e->loader);
+    multi_stop(&e->multi);
+    pthread_mutex_destroy(&e->lock);
+
+    // The engine lives in its own arena
+    Arena arena = e->arena;
+    arena_free(&arena);
+}
+
+void engine_lock(Engine *e) {
+    pthread_mutex_lock(&e->lock);
+}
+
+void engine_unlock(Engine *e) {
+    pthread_mutex_unlock(&e->lock);
+}
+
+//------------------------------------------------------------------------------
+// MIDI
+//------------------------------------------------------------------------------
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int engine_queue_midi(Engine *e, const MidiEvent *event) {
+    unsigned int head = __atomic_load_n(&e->queue_head, __ATOMIC_RELAXED);
+    unsigned int tail = __atomic_load_n(&e->queue_tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= ENGINE_MIDI_QUEUE) {
+        __atomic_add_fetch(&e->stats.midi_dropped, 1, __ATOMIC_RELAXED);
+        return -1;
+    }
+    e->queue[head & (ENGINE_MIDI_QUEUE - 1)] = *event;
+    e->queue_time[head & (ENGINE_MIDI_QUEUE - 1)] = now_seconds();
+    __atomic_store_n(&e->queue_head, head + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// Apply everything queued, noting how long the oldest event waited
+static void drain_midi(Engine *e, double now) {
+    EngineStats *st = &e->stats;
+    unsigned int tail = e->queue_tail;
+    unsigned int head = __atomic_load_n(&e->queue_head, __ATOMIC_ACQUIRE);
+    st->midi_queue = (int)(head - tail);
+    if (st->midi_queue > st->midi_queue_peak) st->midi_queue_peak = st->midi_queue;
+    if (tail == head) return;
+
+    st->midi_latency = (float)((now - e->queue_time[tail & (ENGINE_MIDI_QUEUE - 1)]) * 1000.0);
+    if (st->midi_latency > st->midi_latency_peak) st->midi_latency_peak = st->midi_latency;
+
+    TRACE_BEGIN("midi");
+    while (tail != head) {
+        engine_midi(e, &e->queue[tail & (ENGINE_MIDI_QUEUE - 1)]);
+        tail++;
+    }
+    TRACE_END("midi");
+    __atomic_store_n(&e->queue_tail, tail, __ATOMIC_RELEASE);
+}
+
+static void handle_cc(Engine *e, int channel, int cc, int value) {
+    // Registered parameters the synth understands (bend range, MPE zone)
+    if (cc == CC_DATA_ENTRY_MSB) {
+        int rpn = midimap_rpn(&e->midimap, channel);
+        if (rpn == RPN_PITCH_BEND_RANGE || rpn == RPN_MPE_CONFIG) {
+            multi_rpn(&e->multi, channel, rpn, value);
+            return;
+        }
+    }
+
+    // Controllers go to every part listening on this channel, as notes do.
+    // The map's per-channel state (14-bit halves, NRPN selection) is only
+    // ever set to the incoming value, so running it once per part is safe.
+    for (int part = multi_part_for_channel(&e->multi, channel, 0); part >= 0;
+         part = multi_part_for_channel(&e->multi, channel, part + 1)) {
+        Part *p = &e->multi.parts[part];
+
+        // Timbre on an MPE member channel belongs to that channel's notes
+        if (cc == CC_MPE_TIMBRE && synth_is_member_channel(&p->synth, channel)) {
+            float timbre = (value - 64) / 63.0f;
+            if (timbre < -1.0f) timbre = -1.0f;
+            synth_expression(&p->synth, channel, EXPR_TIMBRE, timbre);
+            continue;
+        }
+
+        ParamContext ctx = {&p->synth, &e->effects, &p->arp};
+        midimap_handle_cc(&e->midimap, &ctx, channel, cc, value);
+    }
+}
+
+void engine_midi(Engine *e, const MidiEvent *event) {
+    switch (event->type) {
+        case MIDI_NOTE_ON:
+            if (event->data2 > 0) {
+                multi_note_on(&e->multi, event->channel, event->data1, event->data2);
+            } else {
+                multi_note_off(&e->multi, event->channel, event->data1);
+            }
+            break;
+
+        case MIDI_NOTE_OFF:
+            multi_note_off(&e->multi, event->channel, event->data1);
+            break;
+
+        case MIDI_CONTROL:
+            handle_cc(e, event->channel, event->data1, event->data2);
+            break;
+
+        case MIDI_PITCH_BEND:
+            multi_expression(&e->multi, event->channel, EXPR_BEND,
+                             (event->data2 - 8192) / 8192.0f);
+            break;
+
+        case MIDI_CHANNEL_PRESSURE:
+            multi_expression(&e->multi, event->channel, EXPR_PRESSURE,
+                             event->data2 / 127.0f);
+            break;
+
+        case MIDI_POLY_PRESSURE:
+            multi_note_pressure(&e->multi, event->channel, event->data1,
+                                event->data2 / 127.0f);
+            break;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Rendering
+//------------------------------------------------------------------------------
+
+// With no part sounding, count how long the output has stayed below the idle
+// level. Once that outlasts the longest gap the effects can leave before the
+// next repeat (e->idle_hold), whatever is left in the lines is inaudible:
+// clear them and stop rendering.
+static void track_silence(Engine *e, const float *out, int frames) {
+    float peak = 0.0f;
+    for (int i = 0; i < frames * 2; i++) {
+        float level = fabsf(out[i]);
+        if (level > peak) peak = level;
+    }
+    if (peak > ENGINE_IDLE_LEVEL) {
+        e->quiet_frames = 0;
+        return;
+    }
+
+    e->quiet_frames += frames;
+    if (e->quiet_frames >= e->idle_hold) {
+        effects_clear(&e->effects);
+        e->idle = 1;
+    }
+}
+
+// Put the governor's level into effect for the next block. At the last level
+// every block that is still late also loses its quietest voice.
+static void apply_quality(Engine *e, int level, float load) {
+    int shed = 0;
+    if (level >= QUALITY_RELEASE_UNISON) shed |= VOICE_SHED_UNISON;
+    if (level >= QUALITY_CONTROL_MOD) shed |= VOICE_SHED_MOD;
+    for (int i = 0; i < MAX_PARTS; i++) {
+        e->multi.parts[i].synth.shed = shed;
+    }
+    e->limiter.sample_peak = (level >= QUALITY_SAMPLE_PEAK);
+
+    if (level == QUALITY_STEAL && load > GOVERNOR_HIGH && multi_steal_quietest(&e->multi)) {
+        e->stats.voices_stolen++;
+    }
+}
+
+// Sounding voices and the parts they are in (caller holds the lock)
+static void count_active(Engine *e, EngineStats *st) {
+    st->active_voices = 0;
+    st->active_parts = 0;
+    for (int i = 0; i < MAX_PARTS; i++) {
+        Part *p = &e->multi.parts[i];
+        if (!p->enabled) continue;
+        int voices = 0;
+        for (int v = 0; v < NUM_VOICES; v++) {
+            voices += voice_is_active(&p->synth.voices[v]);
+        }
+        st->active_voices += voices;
+        st->active_parts += (voices > 0);
+    }
+}
+
+static void publish_telemetry(Engine *e, double now) {
+    EngineStats *st = &e->stats;
+    Telemetry *t = e->telemetry;
+    count_active(e, st);
+
+    telemetry_begin(t);
+    t->time = now;
+    t->blocks = st->blocks;
+    t->frames = st->frames;
+    t->load = st->load;
+    t->peak_load = st->peak_load;
+    t->active_voices = st->active_voices;
+    t->active_parts = st->active_parts;
+    t->midi_latency = st->midi_latency;
+    t->midi_latency_peak = st->midi_latency_peak;
+    t->midi_queue = st->midi_queue;
+    t->midi_queue_peak = st->midi_queue_peak;
+    t->midi_dropped = __atomic_load_n(&st->midi_dropped, __ATOMIC_RELAXED);
+    t->idle = st->idle;
+    t->limiter_gr = st->limiter_gr;
+    t->quality = st->quality;
+    for (int i = 0; i < QUALITY_LEVELS; i++) t->quality_steps[i] = st->quality_steps[i];
+    t->quality_restores = st->quality_restores;
+    t->voices_stolen = st->voices_stolen;
+    telemetry_end(t);
+}
+
+void engine_render(Engine *e, float *out, int frames) {
+    TRACE_BEGIN("engine_render");
+    rtcheck_enter();
+    // Control threads hold the lock only briefly; finding it taken means the
+    // audio thread waits on a lower-priority one, so the check logs it
+    if (pthread_mutex_trylock(&e->lock) != 0) {
+        rtcheck_violation("engine lock contended");
+        rtcheck_leave();    // Logged once above, not again by the wait
+        pthread_mutex_lock(&e->lock);
+        rtcheck_enter();
+    }
+    PERF_BEGIN(PERF_BLOCK);
+    double start_time = now_seconds();
+
+    drain_midi(e, start_time);
+
+    // Swap in a preset parsed by the background loader (never blocks)
+    Patch patch;
+    int part;
+    if (loader_take(&e->loader, &patch, &part)) {
+        TRACE_BEGIN("preset swap");
+        Part *p = &e->multi.parts[part];
+        if (e->preset_xfade) {
+            crossfade_begin(&p->xfade, &p->synth,
+                            (int)(CROSSFADE_MS * 0.001f * sample_rate));
+        }
+        // The effects and controller map are shared; they follow the preset
+        // loaded into part 1
+        patch_apply(&patch, &p->synth, part == 0 ? &e->effects : NULL, &p->arp);
+        if (part == 0 && patch.map.count >= 0) {
+            midimap_import(&e->midimap, &patch.map);
+        }
+        TRACE_END("preset swap");
+    }
+
+    // Arpeggiators step on the audio clock
+    multi_process_arps(&e->multi, frames / sample_rate);
+
+    // Anything sounding wakes an idle engine before this block
+    int active = multi_is_active(&e->multi);
+    if (active) {
+        e->idle = 0;
+        e->quiet_frames = 0;
+    }
+
+    if (e->idle) {
+        memset(out, 0, frames * 2 * sizeof(float));
+    } else {
+        for (int start = 0; start < frames; start += PART_MAX_FRAMES) {
+            int n = frames - start;
+            if (n > PART_MAX_FRAMES) n = PART_MAX_FRAMES;
+
+            // Render every active part (in parallel when there are several)
+            TRACE_BEGIN("voices");
+            PERF_BEGIN(PERF_VOICES);
+            multi_render(&e->multi, e->dry, e->send, n);
+            PERF_END(PERF_VOICES);
+            TRACE_END("voices");
+
+            TRACE_BEGIN("effects");
+            PERF_BEGIN(PERF_EFFECTS);
+            for (int i = 0; i < n; i++) {
+                if (i % CONTROL_BLOCK == 0) {
+                    effects_control_update(&e->effects);
+                }
+
+                // Apply effects to the send mix
+                Stereo sample = e->dry[i] + effects_process(&e->effects, e->send[i]);
+
+                out[(start + i) * 2] = sample[0];
+                out[(start + i) * 2 + 1] = sample[1];
+            }
+            PERF_END(PERF_EFFECTS);
+            TRACE_END("effects");
+        }
+
+        // Master bus: peaks are limited rather than clipped
+        TRACE_BEGIN("limiter");
+        PERF_BEGIN(PERF_LIMITER);
+        limiter_process(&e->limiter, out, frames);
+        PERF_END(PERF_LIMITER);
+        TRACE_END("limiter");
+
+        if (!active) {
+            track_silence(e, out, frames);
+        }
+    }
+
+    // One block copy for the display; readers never take the lock
+    scope_write(&e->scope, out, frames, 2);
+
+    // Load: time spent against the time the block lasts
+    EngineStats *st = &e->stats;
+    double end_time = now_seconds();
+    float load = 0.0f;
+    if (frames > 0) {
+        load = (float)((end_time - start_time) * sample_rate / frames);
+    }
+    st->load += (load - st->load) * 0.05f;
+    if (load > st->peak_load) st->peak_load = load;
+    st->blocks++;
+    st->frames += frames;
+    st->idle = e->idle;
+    if (e->idle) st->idle_blocks++;
+    st->limiter_gr = e->limiter.meter_db;
+
+    // Shed or restore quality for the next block
+    int level = QUALITY_FULL;
+    if (e->govern) {
+        level = governor_update(&e->governor, load, frames / sample_rate);
+    }
+    apply_quality(e, level, load);
+    st->quality = level;
+    memcpy(st->quality_steps, e->governor.steps, sizeof(st->quality_steps));
+    st->quality_restores = e->governor.restores;
+
+    if (e->telemetry) {
+        publish_telemetry(e, end_time);
+    }
+
+    PERF_END(PERF_BLOCK);
+    rtcheck_leave();
+    pthread_mutex_unlock(&e->lock);
+    TRACE_END("engine_render");
+}
+
+//------------------------------------------------------------------------------
+// Parameters, presets, statistics
+//------------------------------------------------------------------------------
+
+int engine_set_param(Engine *e, int part, ParamId id, float value) {
+    if (part < 0 || part >= MAX_PARTS || (int)id < 0 || id >= PARAM_COUNT) return -1;
+
+    pthread_mutex_lock(&e->lock);
+    Part *p = &e->multi.parts[part];
+    ParamContext ctx = {&p->synth, &e->effects, &p->arp};
+    param_set(&ctx, id, value);
+    pthread_mutex_unlock(&e->lock);
+    return 0;
+}
+
+int engine_set_param_name(Engine *e, int part, const char *name, float value) {
+    int id = param_find_name(name);
+    if (id < 0) return -1;
+    return engine_set_param(e, part, (ParamId)id, value);
+}
+
+int engine_load_preset(Engine *e, int part, const char *path) {
+    if (part < 0 || part >= MAX_PARTS) return -1;
+
+    // Keys missing from the file take their defaults, as in the bank
+    Patch patch = *patch_defaults();
+    Part *p = &e->multi.parts[part];
+
+    char name[PRESET_NAME_LEN];
+    if (preset_read(path, name, sizeof(name), &patch) < 0) return -1;
+
+    pthread_mutex_lock(&e->lock);
+    patch_apply(&patch, &p->synth, part == 0 ? &e->effects : NULL, &p->arp);
+    if (part == 0 && patch.map.count >= 0) {
+        midimap_import(&e->midimap, &patch.map);
+    }
+    snprintf(p->preset_name, PART_NAME_LEN, "%s", name);
+    pthread_mutex_unlock(&e->lock);
+    return 0;
+}
+
+void engine_stats(Engine *e, EngineStats *out) {
+    pthread_mutex_lock(&e->lock);
+    EngineStats st = e->stats;
+    st.midi_dropped = __atomic_load_n(&e->stats.midi_dropped, __ATOMIC_RELAXED);
+    count_active(e, &st);
+    pthread_mutex_unlock(&e->lock);
+    *out = st;
+}
@@ -0,0 +1,153 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "multi.h"
+#include "effects.h"
+#include "midimap.h"
+#include "loader.h"
+#include "midi.h"
+#include "scope.h"
+#include "limiter.h"
+#include "governor.h"
+#include "arena.h"
+#include "telemetry.h"
+#include <pthread.h>
+
+// The synth engine as an embeddable instance: parts, shared effects, MIDI
+// mapping, preset loader and the lock that guards them. Has no raylib or ALSA
+// dependency; the app, the tools and test harnesses are all clients.
+//
+// Threads: engine_render runs on the audio thread and takes the lock for the
+// block. engine_queue_midi may be called from one other thread without the
+// lock. Everything else that touches parts/effects/midimap holds the lock
+// (engine_lock/engine_unlock, or the functions that say they take it).
+//
+// Memory: the instance and its delay/reverb lines live in one arena, sized
+// from the configuration, zeroed and locked into RAM at creation, so the
+// audio thread never page-faults on engine state.
+
+#define ENGINE_MIDI_QUEUE 256   // Queued MIDI events (power of two)
+
+// Idle detection: with no part sounding, the output has to stay below
+// ENGINE_IDLE_LEVEL for longer than the effects can hold a sound back (a
+// full-length delay repeat, the reverb lines and the limiter lookahead) plus
+// ENGINE_IDLE_MARGIN seconds before blocks are skipped
+#define ENGINE_IDLE_LEVEL  3.2e-5f  // -90 dBFS
+#define ENGINE_IDLE_MARGIN 0.2f
+
+typedef struct {
+    unsigned long blocks;       // Blocks rendered
+    unsigned long frames;       // Frames rendered
+    float load;                 // Render time / block time, smoothed
+    float peak_load;            // Highest single-block load
+    int active_voices;          // Voices sounding across all parts
+    int active_parts;
+    unsigned long midi_dropped; // Events lost to a full queue
+    float midi_latency;         // Longest queue wait in the last block with MIDI, ms
+    float midi_latency_peak;
+    int midi_queue;             // Events waiting when the last block started
+    int midi_queue_peak;
+    int idle;                   // Output is silent and rendering is skipped
+    unsigned long idle_blocks;  // Blocks skipped as silent
+    float limiter_gr;           // Master limiter gain reduction, dB (held)
+    int quality;                // QualityLevel set by the load governor
+    unsigned long quality_steps[QUALITY_LEVELS];  // Times each level was entered
+    unsigned long quality_restores;               // Levels given back
+    unsigned long voices_stolen;                  // Voices faded out under load
+} EngineStats;
+
+// Creation settings (0 = default)
+typedef struct {
+    int rate;                   // Sample rate (DEFAULT_SAMPLE_RATE)
+    float max_delay;            // Longest delay line, seconds (DELAY_MAX_TIME).
+                                // Delay times set above it are stored clamped
+} EngineConfig;
+
+typedef struct {
+    Arena arena;                // Holds this struct and the effect lines
+    float max_delay;            // Delay line length the effects were given, seconds
+
+    Multi multi;
+    Effects effects;
+    MidiMap midimap;            // Shared by all parts; follows part 1's preset
+    PresetLoader loader;
+    pthread_mutex_t lock;
+    int preset_xfade;           // Crossfade parts on preset loads
+    int govern;                 // Shed quality under load (off for offline renders)
+
+    // Lock-free MIDI queue (one producer, drained by engine_render)
+    MidiEvent queue[ENGINE_MIDI_QUEUE];
+    double queue_time[ENGINE_MIDI_QUEUE];   // When each was queued (monotonic seconds)
+    unsigned int queue_head;    // Next write (producer)
+    unsigned int queue_tail;    // Next read (audio thread)
+
+    // Part mix buffers: dry share and effects send
+    Stereo dry[PART_MAX_FRAMES];
+    Stereo send[PART_MAX_FRAMES];
+
+    // Master bus (audio thread)
+    Limiter limiter;
+
+    // Sheds quality when blocks near their deadline (audio thread)
+    Governor governor;
+
+    // Silence detection (audio thread)
+    int idle;                   // Blocks are zero-filled until something sounds
+    unsigned long quiet_frames; // Frames below ENGINE_IDLE_LEVEL with nothing playing
+    unsigned long idle_hold;    // Quiet frames before going idle (from max_delay)
+
+    // Left output of every block, for scopes and analysers (read lock-free)
+    ScopeRing scope;
+
+    EngineStats stats;
+
+    // Published at the end of every block when set (see telemetry.h)
+    Telemetry *telemetry;
+} Engine;
+
+// Create an engine running at the given rate (0 = DEFAULT_SAMPLE_RATE).
+// The rate is process-wide, so every instance shares the latest one.
+// Starts the render workers and preset loader. Returns NULL on failure.
+// Memory that could not be locked (RLIMIT_MEMLOCK) leaves arena.locked 0
+// but is not a failure.
+Engine *engine_create(int rate);
+Engine *engine_create_config(const EngineConfig *config);
+void engine_destroy(Engine *e);
+
+void engine_lock(Engine *e);
+void engine_unlock(Engine *e);
+
+// Render interleaved stereo (audio thread, takes the lock). Applies queued
+// MIDI and ready preset loads first and advances the arpeggiators. The mix
+// goes through the master limiter, so the output is limiter_latency() frames
+// late and never above LIMITER_CEILING. The block is also appended to
+// e->scope. A block that takes most of its own length to render makes the
+// governor lower quality for the following ones (see governor.h). Once
+// nothing is sounding and the effect tails have died away the engine goes
+// idle: blocks are zero-filled without running the voices or effects until a
+// note or crossfade starts.
+void engine_render(Engine *e, float *out, int frames);
+
+// Queue a MIDI event for the next block (no lock). Returns 0, or -1 if the
+// queue is full.
+int engine_queue_midi(Engine *e, const MidiEvent *event);
+
+// Dispatch a MIDI event now (caller holds the lock)
+void engine_midi(Engine *e, const MidiEvent *event);
+
+// Set a registry parameter on a part by ID or "section.key" name (takes the
+// lock). Effects parameters are shared by every part. Returns 0, or -1 for an
+// unknown name or part.
+int engine_set_param(Engine *e, int part, ParamId id, float value);
+int engine_set_param_name(Engine *e, int part, const char *name, float value);
+
+// Read and apply a JSON preset to a part (file I/O on the calling thread,
+// then applied under the lock). Keys missing from the file take their
+// defaults. Like the shared effects, the preset's controller map is only
+// taken from a load into part 1. Returns 0 or -1.
+int engine_load_preset(Engine *e, int part, const char *path);
+
+// Copy of the current statistics (takes the lock)
+void engine_stats(Engine *e, EngineStats *out);
+
+#endif // ENGINE_H
@@ -1,5 +1,5 @@
 #include "envelope.h"
-#include "oscillator.h"  // for SAMPLE_RATE
+#include "oscillator.h"  // for sample_rate
 
 void env_init(Envelope *env) {
     env->attack = 0.01f;
@@ -20,13 +20,13 @@ void env_set_adsr(Envelope *env, float a, float d, float s, float r) {
 
 void env_gate_on(Envelope *env) {
     env->stage = ENV_ATTACK;
-    env->rate = 1.0f / (env->attack * SAMPLE_RATE);
+    env->rate = 1.0f / (env->attack * sample_rate);
 }
 
 void env_gate_off(Envelope *env) {
     if (env->stage != ENV_IDLE) {
         env->stage = ENV_RELEASE;
-        env->rate = env->level / (env->release * SAMPLE_RATE);
+        env->rate = env->level / (env->release * sample_rate);
     }
 }
 
@@ -41,7 +41,7 @@ float env_process(Envelope *env) {
             if (env->level >= 1.0f) {
                 env->level = 1.0f;
                 env->stage = ENV_DECAY;
-                env->rate = (1.0f - env->sustain) / (env->decay * SAMPLE_RATE);
+                env->rate = (1.0f - env->sustain) / (env->decay * sample_rate);
             }
             break;
 
@@ -69,6 +69,6 @@ float env_process(Envelope *env) {
     return env->level;
 }
 
-int env_is_active(Envelope *env) {
+int env_is_active(const Envelope *env) {
     return env->stage != ENV_IDLE;
 }
@@ -25,6 +25,6 @@ void env_set_adsr(Envelope *env, float a, float d, float s, float r);
 void env_gate_on(Envelope *env);
 void env_gate_off(Envelope *env);
 float env_process(Envelope *env);
-int env_is_active(Envelope *env);
+int env_is_active(const Envelope *env);
 
 #endif // ENVELOPE_H
@@ -1,15 +1,20 @@
 #include "filter.h"
-#include "oscillator.h"  // for SAMPLE_RATE
+#include "oscillator.h"  // for sample_rate
 #include <math.h>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846f
 #endif
 
+// Highest cutoff: the SVF's stability limit (fc = 0.9) at 44.1 kHz, held in
+// Hz so the filter sounds the same at every sample rate
+#define FILTER_MAX_HZ 6550.0f
+
 // Pre-calculate filter coefficient from cutoff
 static void filter_update_fc(SVFilter *f) {
     float freq = 20.0f * powf(1000.0f, f->cutoff);
-    f->fc = 2.0f * sinf(M_PI * freq / SAMPLE_RATE);
+    if (freq > FILTER_MAX_HZ) freq = FILTER_MAX_HZ;
+    f->fc = 2.0f * sinf(M_PI * freq / sample_rate);
     if (f->fc > 0.9f) f->fc = 0.9f;
 }
 
@@ -20,10 +25,10 @@ static void filter_update_q(SVFilter *f) {
 }
 
 void filter_init(SVFilter *f) {
-    f->low = 0.0f;
-    f->high = 0.0f;
-    f->band = 0.0f;
-    f->notch = 0.0f;
+    f->low = stereo_mono(0.0f);
+    f->high = stereo_mono(0.0f);
+    f->band = stereo_mono(0.0f);
+    f->notch = stereo_mono(0.0f);
     f->cutoff = 0.5f;
     f->resonance = 0.0f;
     f->type = FILTER_LOWPASS;
@@ -51,7 +56,7 @@ void filter_set_type(SVFilter *f, FilterType type) {
     f->type = type;
 }
 
-float filter_process(SVFilter *f, float input) {
+Stereo filter_process(SVFilter *f, Stereo input) {
     // Use cached coefficients (fc and q pre-calculated in setters)
     // State variable filter algorithm (Chamberlin)
     f->low = f->low + f->fc * f->band;
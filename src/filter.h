@@ -1,17 +1,20 @@
 #ifndef FILTER_H
 #define FILTER_H
 
+#include "stereo.h"
+
 typedef enum {
     FILTER_LOWPASS,
     FILTER_HIGHPASS,
     FILTER_BANDPASS
 } FilterType;
 
+// Both channels share the coefficients and run as one 2-lane filter
 typedef struct {
-    float low;         // lowpass output
-    float high;        // highpass output
-    float band;        // bandpass output
-    float notch;       // notch output
+    Stereo low;        // lowpass output
+    Stereo high;       // highpass output
+    Stereo band;       // bandpass output
+    Stereo notch;      // notch output
 
     float cutoff;      // normalized 0.0 - 1.0 (maps to 20Hz - 20kHz)
     float resonance;   // 0.0 - 1.0
@@ -26,6 +29,6 @@ void filter_init(SVFilter *f);
 void filter_set_cutoff(SVFilter *f, float cutoff);
 void filter_set_resonance(SVFilter *f, float resonance);
 void filter_set_type(SVFilter *f, FilterType type);
-float filter_process(SVFilter *f, float input);
+Stereo filter_process(SVFilter *f, Stereo input);
 
 #endif // FILTER_H
@@ -0,0 +1,37 @@
+#include "governor.h"
+#include <string.h>
+
+static const char *LEVEL_NAMES[QUALITY_LEVELS] = {
+    "full", "release unison", "control-rate mod", "sample peak", "voice steal",
+};
+
+void governor_init(Governor *g) {
+    memset(g, 0, sizeof(Governor));
+    g->level = QUALITY_FULL;
+}
+
+int governor_update(Governor *g, float load, float seconds) {
+    if (load > GOVERNOR_HIGH) {
+        // Late or nearly: shed straight away, one level per block
+        g->calm = 0.0f;
+        if (g->level < QUALITY_LEVELS - 1) {
+            g->level++;
+            g->steps[g->level]++;
+        }
+    } else if (load < GOVERNOR_LOW && g->level > QUALITY_FULL) {
+        g->calm += seconds;
+        if (g->calm >= GOVERNOR_HOLD) {
+            g->level--;
+            g->restores++;
+            g->calm = 0.0f;
+        }
+    } else {
+        g->calm = 0.0f;
+    }
+    return g->level;
+}
+
+const char *governor_level_name(int level) {
+    if (level < 0 || level >= QUALITY_LEVELS) return "?";
+    return LEVEL_NAMES[level];
+}
@@ -0,0 +1,39 @@
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+// Load governor (audio thread).
+// Watches each block's render time against its deadline. When the headroom
+// runs out it lowers quality one level per block, cheapest loss first, and
+// once the load has stayed low for a while it brings the levels back one at
+// a time. Every level entered is counted so heavy presets show up in the
+// statistics.
+
+#define GOVERNOR_HIGH 0.80f     // Block load that sheds the next level
+#define GOVERNOR_LOW  0.55f     // Load under which quality may come back
+#define GOVERNOR_HOLD 0.5f      // Seconds under GOVERNOR_LOW per level restored
+
+typedef enum {
+    QUALITY_FULL,
+    QUALITY_RELEASE_UNISON,     // Releasing voices drop their unison copies
+    QUALITY_CONTROL_MOD,        // Filter modulation at control rate
+    QUALITY_SAMPLE_PEAK,        // Limiter skips its 4x true-peak detector
+    QUALITY_STEAL,              // Quietest voice faded out per late block
+    QUALITY_LEVELS
+} QualityLevel;
+
+typedef struct {
+    int level;                  // QualityLevel in force
+    float calm;                 // Seconds the load has stayed under GOVERNOR_LOW
+    unsigned long steps[QUALITY_LEVELS];    // Times each level was entered
+    unsigned long restores;     // Levels given back
+} Governor;
+
+void governor_init(Governor *g);
+
+// Feed one block's load (render time / block time) and length in seconds.
+// Returns the level for the next block.
+int governor_update(Governor *g, float load, float seconds);
+
+const char *governor_level_name(int level);
+
+#endif // GOVERNOR_H
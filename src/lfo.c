@@ -1,8 +1,7 @@
 #include "lfo.h"
+#include "oscillator.h"  // for sample_rate
 #include <math.h>
 
-#define SAMPLE_RATE 44100.0f
-
 void lfo_init(LFO *lfo) {
     lfo->phase = 0.0f;
     lfo->rate = 1.0f;       // 1 Hz default
@@ -28,7 +27,7 @@ void lfo_set_type(LFO *lfo, LFOWaveType type) {
 
 float lfo_process(LFO *lfo) {
     // Advance phase
-    lfo->phase += lfo->rate / SAMPLE_RATE;
+    lfo->phase += lfo->rate / sample_rate;
     if (lfo->phase >= 1.0f) {
         lfo->phase -= 1.0f;
     }
@@ -0,0 +1,151 @@
+#include "limiter.h"
+#include <math.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define MASK (LIMITER_MAX_DELAY - 1)
+#define TP_PHASES 3     // Points between samples (4x oversampling)
+
+// Windowed-sinc interpolator, one row per fractional position
+static float tp_coeff[TP_PHASES][LIMITER_TP_TAPS];
+static pthread_once_t tp_once = PTHREAD_ONCE_INIT;
+
+static void build_tp_coeff(void) {
+    for (int p = 0; p < TP_PHASES; p++) {
+        float frac = (p + 1) / 4.0f;
+        float sum = 0.0f;
+        for (int t = 0; t < LIMITER_TP_TAPS; t++) {
+            // Tap t reads the sample LIMITER_TP_LAG - 1 - t before the segment start
+            float d = frac + (LIMITER_TP_LAG - 1) - t;
+            float x = (float)M_PI * d;
+            float sinc = (fabsf(x) < 1e-6f) ? 1.0f : sinf(x) / x;
+            float window = 0.5f + 0.5f * cosf((float)M_PI * d / LIMITER_TP_LAG);
+            tp_coeff[p][t] = sinc * window;
+            sum += tp_coeff[p][t];
+        }
+        for (int t = 0; t < LIMITER_TP_TAPS; t++) {
+            tp_coeff[p][t] /= sum;
+        }
+    }
+}
+
+void limiter_init(Limiter *l, float rate) {
+    pthread_once(&tp_once, build_tp_coeff);
+    memset(l, 0, sizeof(Limiter));
+
+    // Audio read at the end of a chunk must not have been overwritten yet
+    int max_lookahead = LIMITER_MAX_DELAY - LIMITER_CHUNK - LIMITER_TP_TAPS;
+    l->lookahead = (int)(LIMITER_LOOKAHEAD_MS * 0.001f * rate);
+    if (l->lookahead < 1) l->lookahead = 1;
+    if (l->lookahead > max_lookahead) l->lookahead = max_lookahead;
+
+    l->release = expf(-1.0f / (LIMITER_RELEASE_MS * 0.001f * rate));
+    l->meter_fall = LIMITER_METER_FALL / rate;
+
+    l->target = 1.0f;
+    for (int i = 0; i < l->lookahead; i++) {
+        l->average[i] = 1.0f;
+    }
+    l->average_sum = l->lookahead;
+}
+
+int limiter_latency(const Limiter *l) {
+    return l->lookahead + LIMITER_TP_LAG;
+}
+
+// Largest of the sample at the segment start and the interpolated points
+// between it and the next one. `end` is the newest sample in the history.
+static float true_peak(const float *x, unsigned int end) {
+    unsigned int first = end - (LIMITER_TP_TAPS - 1);
+    float peak = fabsf(x[(end - LIMITER_TP_LAG) & MASK]);
+    for (int p = 0; p < TP_PHASES; p++) {
+        float v = 0.0f;
+        for (int t = 0; t < LIMITER_TP_TAPS; t++) {
+            v += tp_coeff[p][t] * x[(first + t) & MASK];
+        }
+        v = fabsf(v);
+        if (v > peak) peak = v;
+    }
+    return peak;
+}
+
+static void process_chunk(Limiter *l, float *buf, int frames) {
+    float peak[LIMITER_CHUNK];
+    float gain[LIMITER_CHUNK];
+    unsigned int pos = l->pos;
+    int window = l->lookahead + 1;
+
+    // Detector: stereo-linked true peak of each segment
+    for (int i = 0; i < frames; i++) {
+        unsigned int t = pos + i;
+        l->delay[0][t & MASK] = buf[i * 2];
+        l->delay[1][t & MASK] = buf[i * 2 + 1];
+        float left, right;
+        if (l->sample_peak) {
+            left = fabsf(l->delay[0][(t - LIMITER_TP_LAG) & MASK]);
+            right = fabsf(l->delay[1][(t - LIMITER_TP_LAG) & MASK]);
+        } else {
+            left = true_peak(l->delay[0], t);
+            right = true_peak(l->delay[1], t);
+        }
+        peak[i] = (left > right) ? left : right;
+    }
+
+    // Gain: running max over the lookahead (monotonic deque), released,
+    // then averaged over the lookahead so it is down in time for each peak
+    for (int i = 0; i < frames; i++) {
+        unsigned int k = pos + i;
+        while (l->deque_tail != l->deque_head &&
+               l->deque_peak[(l->deque_tail - 1) & MASK] <= peak[i]) {
+            l->deque_tail--;
+        }
+        l->deque_peak[l->deque_tail & MASK] = peak[i];
+        l->deque_time[l->deque_tail & MASK] = k;
+        l->deque_tail++;
+        while (k - l->deque_time[l->deque_head & MASK] >= (unsigned int)window) {
+            l->deque_head++;
+        }
+
+        float loudest = l->deque_peak[l->deque_head & MASK];
+        float wanted = (loudest > LIMITER_CEILING) ? LIMITER_CEILING / loudest : 1.0f;
+        if (wanted < l->target) {
+            l->target = wanted;
+        } else {
+            l->target = wanted - (wanted - l->target) * l->release;
+        }
+
+        l->average_sum += l->target - l->average[l->average_pos];
+        l->average[l->average_pos] = l->target;
+        if (++l->average_pos == l->lookahead) l->average_pos = 0;
+        gain[i] = (float)(l->average_sum / l->lookahead);
+    }
+
+    // Output: the delayed audio under the gain
+    unsigned int latency = limiter_latency(l);
+    float lowest = 1.0f;
+    for (int i = 0; i < frames; i++) {
+        unsigned int j = (pos + i - latency) & MASK;
+        buf[i * 2] = l->delay[0][j] * gain[i];
+        buf[i * 2 + 1] = l->delay[1][j] * gain[i];
+        if (gain[i] < lowest) lowest = gain[i];
+    }
+
+    l->pos = pos + frames;
+
+    float reduction = -20.0f * log10f(lowest);
+    float held = l->meter_db - l->meter_fall * frames;
+    if (held < 0.0f) held = 0.0f;
+    l->meter_db = (reduction > held) ? reduction : held;
+}
+
+void limiter_process(Limiter *l, float *buf, int frames) {
+    for (int start = 0; start < frames; start += LIMITER_CHUNK) {
+        int n = frames - start;
+        if (n > LIMITER_CHUNK) n = LIMITER_CHUNK;
+        process_chunk(l, buf + start * 2, n);
+    }
+}
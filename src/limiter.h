@@ -0,0 +1,53 @@
+#ifndef LIMITER_H
+#define LIMITER_H
+
+// Master bus lookahead limiter (audio thread).
+// The detector estimates true peaks by 4x polyphase interpolation between
+// samples, and a monotonic deque tracks the loudest one ahead of the delayed
+// audio. The gain follows it with an instant-but-lookahead attack (a moving
+// average over the lookahead, which reaches each peak's gain in time) and an
+// exponential release, so the output stays under the ceiling without the
+// distortion of a hard clip. Stereo-linked; a whole block per call.
+
+#define LIMITER_CEILING      0.891f     // -1 dBTP
+#define LIMITER_LOOKAHEAD_MS 1.5f
+#define LIMITER_RELEASE_MS   60.0f
+#define LIMITER_METER_FALL   20.0f      // Gain reduction meter fall, dB/s
+#define LIMITER_TP_TAPS      8          // Interpolator taps per phase
+#define LIMITER_TP_LAG       (LIMITER_TP_TAPS / 2)  // Samples the detector waits for
+#define LIMITER_MAX_DELAY    512        // Delay line length (power of two)
+#define LIMITER_CHUNK        128        // Frames per detector/gain pass
+
+typedef struct {
+    int lookahead;              // Samples the gain sees ahead of the audio
+    float release;              // Per-sample release coefficient
+    int sample_peak;            // Detect sample peaks only, no interpolation (under load)
+
+    // Input history per channel, also the audio delay line
+    float delay[2][LIMITER_MAX_DELAY];
+    unsigned int pos;           // Frames written (wraps)
+
+    // Running maximum of the detector over the lookahead window
+    float deque_peak[LIMITER_MAX_DELAY];
+    unsigned int deque_time[LIMITER_MAX_DELAY];
+    unsigned int deque_head, deque_tail;
+
+    // Gain: released target, averaged over the lookahead
+    float target;
+    float average[LIMITER_MAX_DELAY];
+    int average_pos;
+    double average_sum;
+
+    float meter_db;             // Gain reduction, peak-held with a fall (>= 0)
+    float meter_fall;           // dB per frame
+} Limiter;
+
+void limiter_init(Limiter *l, float rate);
+
+// Limit interleaved stereo in place. The output lags the input by
+// limiter_latency() frames.
+void limiter_process(Limiter *l, float *buf, int frames);
+
+int limiter_latency(const Limiter *l);
+
+#endif // LIMITER_H
@@ -0,0 +1,146 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "loader.h"
+#include "trace.h"
+#include <string.h>
+#include <time.h>
+
+static int get_state(PresetLoader *l) {
+    return __atomic_load_n(&l->state, __ATOMIC_ACQUIRE);
+}
+
+static void set_state(PresetLoader *l, int state) {
+    __atomic_store_n(&l->state, state, __ATOMIC_RELEASE);
+}
+
+static int is_running(PresetLoader *l) {
+    return __atomic_load_n(&l->running, __ATOMIC_RELAXED);
+}
+
+static void *loader_thread(void *arg) {
+    PresetLoader *l = (PresetLoader *)arg;
+    TRACE_THREAD("loader");
+
+    pthread_mutex_lock(&l->lock);
+    while (l->running) {
+        if (l->request_slot < 0) {
+            pthread_cond_wait(&l->cond, &l->lock);
+            continue;
+        }
+
+        int slot = l->request_slot;
+        int part = l->request_part;
+        int parsed = l->request_parsed;
+        Patch patch = l->request_base;
+        char name[PRESET_NAME_LEN];
+        memcpy(name, l->request_name, sizeof(name));
+        l->request_slot = -1;
+        pthread_mutex_unlock(&l->lock);
+
+        // File I/O happens here, outside any lock the engine uses
+        int ok = 1;
+        if (!parsed) {
+            char path[64];
+            preset_filename(slot, path, sizeof(path));
+            TRACE_BEGIN("preset load");
+            ok = (preset_read(path, name, sizeof(name), &patch) == 0);
+            TRACE_END("preset load");
+        }
+
+        // Wait for the previous result to be consumed before overwriting it
+        struct timespec wait = {0, 1000000};  // 1ms
+        while (ok && get_state(l) != LOADER_IDLE && is_running(l)) {
+            nanosleep(&wait, NULL);
+        }
+
+        if (ok && is_running(l)) {
+            l->result = patch;
+            memcpy(l->result_name, name, sizeof(l->result_name));
+            l->result_slot = slot;
+            l->result_part = part;
+            set_state(l, LOADER_READY);
+        }
+
+        pthread_mutex_lock(&l->lock);
+    }
+    pthread_mutex_unlock(&l->lock);
+
+    return NULL;
+}
+
+int loader_start(PresetLoader *l) {
+    l->running = 1;
+    l->request_slot = -1;
+    l->request_part = 0;
+    l->request_parsed = 0;
+    l->request_name[0] = '\0';
+    l->result_slot = 0;
+    l->result_part = 0;
+    l->result_name[0] = '\0';
+    l->state = LOADER_IDLE;
+    pthread_mutex_init(&l->lock, NULL);
+    pthread_cond_init(&l->cond, NULL);
+
+    if (pthread_create(&l->thread, NULL, loader_thread, l) != 0) {
+        l->running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void loader_stop(PresetLoader *l) {
+    if (!l->running) return;
+
+    pthread_mutex_lock(&l->lock);
+    l->running = 0;
+    pthread_cond_signal(&l->cond);
+    pthread_mutex_unlock(&l->lock);
+
+    pthread_join(l->thread, NULL);
+    pthread_cond_destroy(&l->cond);
+    pthread_mutex_destroy(&l->lock);
+}
+
+void loader_request(PresetLoader *l, int part, int slot, const Patch *base) {
+    pthread_mutex_lock(&l->lock);
+    l->request_slot = slot;
+    l->request_part = part;
+    l->request_base = *base;
+    l->request_parsed = 0;
+    pthread_cond_signal(&l->cond);
+    pthread_mutex_unlock(&l->lock);
+}
+
+void loader_request_patch(PresetLoader *l, int part, int slot, const Patch *patch, const char *name) {
+    pthread_mutex_lock(&l->lock);
+    l->request_slot = slot;
+    l->request_part = part;
+    l->request_base = *patch;
+    l->request_parsed = 1;
+    strncpy(l->request_name, name, sizeof(l->request_name) - 1);
+    l->request_name[sizeof(l->request_name) - 1] = '\0';
+    pthread_cond_signal(&l->cond);
+    pthread_mutex_unlock(&l->lock);
+}
+
+int loader_take(PresetLoader *l, Patch *out, int *part) {
+    if (get_state(l) != LOADER_READY) return 0;
+
+    *out = l->result;
+    *part = l->result_part;
+    set_state(l, LOADER_APPLIED);
+    return 1;
+}
+
+int loader_poll_applied(PresetLoader *l, int *part, int *slot, char *name, int name_size) {
+    if (get_state(l) != LOADER_APPLIED) return 0;
+
+    if (part) *part = l->result_part;
+    if (slot) *slot = l->result_slot;
+    if (name && name_size > 0) {
+        strncpy(name, l->result_name, name_size - 1);
+        name[name_size - 1] = '\0';
+    }
+    set_state(l, LOADER_IDLE);
+    return 1;
+}
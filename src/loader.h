@@ -0,0 +1,57 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include "patch.h"
+#include "preset.h"
+#include <pthread.h>
+
+// Background preset loader.
+// File I/O and parsing happen on a worker thread; the finished patch is handed
+// to the audio thread through a lock-free state flag so it can be swapped in
+// at a block boundary without the audio thread ever waiting.
+
+typedef enum {
+    LOADER_IDLE,        // Result slot free
+    LOADER_READY,       // Patch parsed, waiting for the audio thread
+    LOADER_APPLIED      // Audio thread swapped it in, UI not yet notified
+} LoaderState;
+
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;   // Protects the request fields (never taken by audio)
+    pthread_cond_t cond;
+    int running;
+
+    // Pending request (latest wins)
+    int request_slot;       // -1 = none
+    int request_part;       // Part the preset is loaded into
+    Patch request_base;     // Values for keys missing from the file (the defaults)
+    int request_parsed;     // request_base is already complete (bank recall)
+    char request_name[PRESET_NAME_LEN];
+
+    // Result handed over to the audio thread
+    Patch result;
+    char result_name[PRESET_NAME_LEN];
+    int result_slot;
+    int result_part;
+    int state;              // LoaderState, accessed atomically
+} PresetLoader;
+
+// Start/stop the worker thread (loader_start returns 0 on success)
+int loader_start(PresetLoader *l);
+void loader_stop(PresetLoader *l);
+
+// Queue a preset slot for loading into a part (UI thread)
+void loader_request(PresetLoader *l, int part, int slot, const Patch *base);
+
+// Queue an already-decoded patch (e.g. from the preset bank), skipping file I/O
+void loader_request_patch(PresetLoader *l, int part, int slot, const Patch *patch, const char *name);
+
+// Take a ready patch and its target part (audio thread, never blocks).
+// Returns 1 if one was taken.
+int loader_take(PresetLoader *l, Patch *out, int *part);
+
+// Check whether a patch has been swapped in (UI thread). Returns 1 once per load.
+int loader_poll_applied(PresetLoader *l, int *part, int *slot, char *name, int name_size);
+
+#endif // LOADER_H
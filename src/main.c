@@ -1,91 +1,206 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include "raylib.h"
-#include "synth.h"
-#include "effects.h"
+#include "engine.h"
 #include "midi.h"
 #include "ui.h"
-#include "wavetable.h"
-#include "arp.h"
+#include "param.h"
+#include "patch.h"
+#include "bank.h"
+#include "preset.h"
+#include "audiodev.h"
+#include "snapshot.h"
+#include "renderer.h"
+#include "trace.h"
 #include <stdio.h>
-#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
 
 // Physical display dimensions (portrait WaveShare panel)
 #define PHYSICAL_WIDTH  400
 #define PHYSICAL_HEIGHT 1280
 
 // Global state (accessible from audio callback)
-static Synth g_synth;
-static Effects g_effects;
+static Engine *g_engine;
 static UI g_ui;
-static Arpeggiator g_arp;
-static pthread_mutex_t g_mutex = PTHREAD_MUTEX_INITIALIZER;
 static AudioStream g_stream;
+static Bank g_bank;
+static Renderer g_renderer;
 static const int BUFFER_SIZES[] = {512, 256, 128};
+#define BUFFER_COUNT    3
+#define BUFFER_SMALLEST (BUFFER_COUNT - 1)
+
+// The stream period never changes; the SET page buffer is how far ahead of
+// it the render thread works
+#define STREAM_FRAMES 128
+
+// Buffer size auto mode settled on, one file per machine
+#define BUFFER_RECORD "presets/buffer-%s.txt"
+
+// Scala tuning files (optional)
+#define TUNING_SCL "presets/tuning.scl"
+#define TUNING_KBM "presets/tuning.kbm"
+
+// Engine state captured from the SET page
+#define SNAPSHOT_FILE "presets/state.bsnap"
+
+// Written on SIGUSR1 in tracing builds (make TRACE=1)
+#define TRACE_FILE "buttery-trace.json"
+static volatile sig_atomic_t g_trace_requested;
+
+static void request_trace(int sig) {
+    (void)sig;
+    g_trace_requested = 1;
+}
 
 // Audio callback - called by raylib to fill audio buffer
 static void SynthAudioCallback(void *buffer, unsigned int frames) {
     float *out = (float *)buffer;
 
-    pthread_mutex_lock(&g_mutex);
+    // The render thread has the frames ready (and feeds the scope ring)
+    renderer_read(&g_renderer, out, (int)frames);
+}
+
+static void buffer_record_path(char *path, int size) {
+    char host[64];
+    if (gethostname(host, sizeof(host)) != 0) snprintf(host, sizeof(host), "default");
+    host[sizeof(host) - 1] = '\0';
+    snprintf(path, size, BUFFER_RECORD, host);
+}
+
+// Buffer index auto mode chose on this machine before, or the smallest
+static int buffer_record_load(void) {
+    char path[128];
+    buffer_record_path(path, sizeof(path));
+    FILE *f = fopen(path, "r");
+    if (!f) return BUFFER_SMALLEST;
+
+    int frames = 0;
+    int index = BUFFER_SMALLEST;
+    if (fscanf(f, "%d", &frames) == 1) {
+        for (int i = 0; i < BUFFER_COUNT; i++) {
+            if (BUFFER_SIZES[i] == frames) index = i;
+        }
+    }
+    fclose(f);
+    return index;
+}
+
+static void buffer_record_save(int index) {
+    char path[128];
+    buffer_record_path(path, sizeof(path));
+    FILE *f = fopen(path, "w");
+    if (!f) return;
+    fprintf(f, "%d\n", BUFFER_SIZES[index]);
+    fclose(f);
+}
+
+// Idle UI: with the engine idle and no touch or MIDI for UI_IDLE_DELAY
+// seconds, frames drop to UI_IDLE_FPS. Between them the loop dozes in
+// UI_DOZE_SLICE steps, still polling MIDI and touch, so either wakes it at once.
+#define UI_IDLE_DELAY 2.0
+#define UI_IDLE_FPS   10
+#define UI_DOZE_SLICE 0.004
+
+// UI cost for the SET page: work per frame, UI thread CPU time against wall
+// time, and widgets repainted, averaged over half a second
+#define FRAME_STATS_PERIOD 0.5
+
+static double thread_cpu_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
 
-    for (unsigned int i = 0; i < frames; i++) {
-        // Generate synth sample
-        float sample = synth_process(&g_synth);
+static void update_frame_stats(double work_seconds) {
+    static double window_start, cpu_start, work;
+    static int frames, redrawn;
 
-        // Apply effects
-        sample = effects_process(&g_effects, sample);
+    double now = GetTime();
+    double cpu = thread_cpu_seconds();
+    if (window_start == 0.0) {
+        window_start = now;
+        cpu_start = cpu;
+    }
+    work += work_seconds;
+    redrawn += g_ui.widgets_drawn;
+    frames++;
+
+    double elapsed = now - window_start;
+    if (elapsed >= FRAME_STATS_PERIOD) {
+        g_ui.frame_ms = (float)(work * 1000.0 / frames);
+        g_ui.frame_cpu = (float)((cpu - cpu_start) * 100.0 / elapsed);
+        g_ui.frame_redrawn = (float)redrawn / frames;
+        window_start = now;
+        cpu_start = cpu;
+        work = 0.0;
+        frames = 0;
+        redrawn = 0;
+    }
+}
 
-        // Clamp output
-        if (sample > 1.0f) sample = 1.0f;
-        if (sample < -1.0f) sample = -1.0f;
+static void sleep_seconds(double seconds) {
+    struct timespec ts = {(time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9)};
+    nanosleep(&ts, NULL);
+}
 
-        // Stereo output
-        out[i * 2] = sample;
-        out[i * 2 + 1] = sample;
+// Learn mode: bind a controller to the parameter picked on screen (takes the
+// engine lock for the binding only; the report is printed after it)
+static void learn_cc(int channel, int cc) {
+    ParamId id = (ParamId)g_ui.learn_param;
+    engine_lock(g_engine);
+    midimap_learn(&g_engine->midimap, channel, cc, id);
+    engine_unlock(g_engine);
+    g_ui.learn_param = -1;
+    printf("MIDI learn: ch %d CC %d -> %s\n", channel + 1, cc, param_desc(id)->name);
+}
 
-        // Feed to waveform display (every few samples to avoid too much overhead)
-        ui_add_sample(&g_ui, sample);
+// Poll MIDI. Everything but a controller being learned goes through the
+// engine's queue and is applied at the next block. Returns the events read.
+static int poll_midi(MidiInput *midi) {
+    if (!midi) return 0;
+
+    int count = 0;
+    MidiEvent event;
+    while (midi_poll(midi, &event)) {
+        count++;
+        // The learn flags are UI state: lock only to bind a controller
+        if (event.type == MIDI_CONTROL && g_ui.midi_learn && g_ui.learn_param >= 0) {
+            learn_cc(event.channel, event.data1);
+            continue;
+        }
+        engine_queue_midi(g_engine, &event);
     }
+    return count;
+}
 
-    pthread_mutex_unlock(&g_mutex);
+// Idle frame wait: returns early when touch or MIDI arrives
+static int doze(MidiInput *midi) {
+    double wake_at = GetTime() + 1.0 / UI_IDLE_FPS;
+    while (GetTime() < wake_at) {
+        sleep_seconds(UI_DOZE_SLICE);
+        PollInputEvents();
+        if (IsMouseButtonDown(MOUSE_LEFT_BUTTON)) return 1;
+        if (poll_midi(midi) > 0) return 1;
+    }
+    return 0;
 }
 
-// Handle MIDI CC messages
-static void handle_midi_cc(int cc, int value) {
-    float normalized = (float)value / 127.0f;
-
-    switch (cc) {
-        case CC_FILTER_CUTOFF:
-            synth_set_filter(&g_synth, normalized,
-                           g_synth.filter_resonance, g_synth.filter_type);
-            break;
-
-        case CC_FILTER_RESO:
-            synth_set_filter(&g_synth, g_synth.filter_cutoff,
-                           normalized * 0.95f, g_synth.filter_type);
-            break;
-
-        case CC_ATTACK:
-            g_synth.attack = 0.001f + normalized * 2.0f;
-            break;
-
-        case CC_RELEASE:
-            g_synth.release = 0.001f + normalized * 3.0f;
-            break;
-
-        case CC_REVERB:
-            reverb_set_mix(&g_effects.reverb, normalized);
-            break;
-
-        case CC_DELAY:
-            delay_set_mix(&g_effects.delay, normalized);
-            break;
-
-        case CC_MOD_WHEEL:
-            // Map mod wheel to filter cutoff modulation
-            synth_set_filter(&g_synth, normalized,
-                           g_synth.filter_resonance, g_synth.filter_type);
-            break;
+// Parse the Scala files with no lock held, then install the table in every
+// part. Without a scale the synth plays 12-TET.
+static void load_tuning(void) {
+    Tuning t;
+    if (tuning_load_scala(&t, TUNING_SCL, TUNING_KBM) < 0) {
+        tuning_init_equal(&t);
     }
+
+    engine_lock(g_engine);
+    multi_set_tuning(&g_engine->multi, &t);
+    snprintf(g_ui.tuning_name, sizeof(g_ui.tuning_name), "%s", t.name);
+    engine_unlock(g_engine);
+
+    printf("Tuning: %s\n", t.name);
 }
 
 int main(void) {
@@ -98,21 +213,62 @@ int main(void) {
 
     // Initialize audio
     InitAudioDevice();
+    signal(SIGUSR1, request_trace);
+
+    // Run at the output device's own rate so nothing resamples after us
+    // (the engine builds its rate-dependent tables on creation)
+    int native_rate = audiodev_native_rate();
+
+    // Create the engine BEFORE starting the audio stream
+    g_engine = engine_create(native_rate);
+    if (!g_engine) {
+        printf("Error: engine initialization failed\n");
+        CloseAudioDevice();
+        CloseWindow();
+        return 1;
+    }
+    int rate = (int)sample_rate;
+    Multi *multi = &g_engine->multi;
+
+    // Initialize UI (needs synth/effects/arp pointers, starts on part 1)
+    ui_init(&g_ui, &multi->parts[0].synth, &g_engine->effects, &multi->parts[0].arp,
+            &g_engine->midimap);
+    g_ui.multi = multi;
+    g_ui.scope = &g_engine->scope;
+    load_tuning();
+
+    // Panel chrome is drawn once per page; frames repaint only what changed
+    engine_lock(g_engine);
+    ui_load_chrome(&g_ui);
+    engine_unlock(g_engine);
+
+    // Map the compiled preset bank if one has been built (make bank)
+    if (bank_open(&g_bank, BANK_FILE) == 0) {
+        printf("Preset bank: %d presets\n", bank_count(&g_bank));
+        g_ui.bank = &g_bank;
+    }
 
-    // Initialize wavetables (must be before synth_init)
-    wavetables_init();
-
-    // Initialize synth components BEFORE starting audio stream
-    synth_init(&g_synth);
-    effects_init(&g_effects);
-    arp_init(&g_arp);
+    // Auto buffer mode picks up where it settled last time on this machine
+    if (g_ui.buffer_auto) {
+        g_ui.buffer_size = buffer_record_load();
+    }
 
-    // Initialize UI (needs synth/effects/arp pointers)
-    ui_init(&g_ui, &g_synth, &g_effects, &g_arp);
+    // Stats for buttersynth-top, published by the audio thread every block
+    g_engine->telemetry = telemetry_create(TELEMETRY_NAME, rate);
+
+    // The render thread fills its ring before the stream asks for any
+    if (renderer_start(&g_renderer, g_engine, BUFFER_SIZES[g_ui.buffer_size]) < 0) {
+        printf("Error: render thread could not be started\n");
+        telemetry_destroy(g_engine->telemetry, TELEMETRY_NAME);
+        engine_destroy(g_engine);
+        CloseAudioDevice();
+        CloseWindow();
+        return 1;
+    }
 
-    // Create audio stream with initial buffer size from UI
-    SetAudioStreamBufferSizeDefault(BUFFER_SIZES[g_ui.buffer_size]);
-    g_stream = LoadAudioStream(44100, 32, 2);
+    // Create the audio stream (fixed period, never reloaded)
+    SetAudioStreamBufferSizeDefault(STREAM_FRAMES);
+    g_stream = LoadAudioStream(rate, 32, 2);
     SetAudioStreamCallback(g_stream, SynthAudioCallback);
     PlayAudioStream(g_stream);
 
@@ -126,96 +282,188 @@ int main(void) {
     printf("ButterySynth started!\n");
     printf("  - Display: %dx%d physical -> %dx%d logical\n",
            PHYSICAL_WIDTH, PHYSICAL_HEIGHT, SCREEN_WIDTH, SCREEN_HEIGHT);
-    printf("  - Audio: 44100Hz stereo\n");
-    printf("  - Voices: %d\n", NUM_VOICES);
+    printf("  - Audio: %dHz stereo%s\n", rate, native_rate > 0 ? "" : " (device rate unknown)");
+    printf("  - Buffer: %d samples%s\n", BUFFER_SIZES[g_ui.buffer_size], g_ui.buffer_auto ? " (auto)" : "");
+    printf("  - Voices: %d per part, %d parts\n", NUM_VOICES, MAX_PARTS);
+    printf("  - Render workers: %d", multi->worker_count);
+    if (multi->realtime_workers < multi->worker_count) {
+        printf(" (%d without SCHED_FIFO: no real-time priority)", multi->worker_count - multi->realtime_workers);
+    }
+    printf("\n");
+    printf("  - DSP memory: %zu KB %s\n", g_engine->arena.size / 1024,
+           g_engine->arena.locked ? "locked" : "not locked (raise RLIMIT_MEMLOCK)");
+    printf("  - Telemetry: %s\n", g_engine->telemetry ? "/dev/shm" TELEMETRY_NAME " (buttersynth-top)" : "unavailable");
     printf("  - Touch: %s\n", GetTouchPointCount() > 0 ? "Yes" : "No");
 
     // Main loop
+    MidiInput *midi_in = (midi_ok >= 0) ? &midi : NULL;
+    double last_activity = GetTime();
+    unsigned long last_underruns = 0;
+    TRACE_THREAD("ui");
     while (!WindowShouldClose()) {
-        // Poll MIDI events
-        if (midi_ok >= 0) {
-            MidiEvent event;
-            while (midi_poll(&midi, &event)) {
-                pthread_mutex_lock(&g_mutex);
-
-                switch (event.type) {
-                    case MIDI_NOTE_ON:
-                        if (event.data2 > 0) {
-                            if (g_arp.enabled) {
-                                arp_note_on(&g_arp, event.data1, event.data2);
-                            } else {
-                                synth_note_on(&g_synth, event.data1, event.data2);
-                            }
-                        } else {
-                            if (g_arp.enabled) {
-                                arp_note_off(&g_arp, event.data1);
-                            } else {
-                                synth_note_off(&g_synth, event.data1);
-                            }
-                        }
-                        break;
-
-                    case MIDI_NOTE_OFF:
-                        if (g_arp.enabled) {
-                            arp_note_off(&g_arp, event.data1);
-                        } else {
-                            synth_note_off(&g_synth, event.data1);
-                        }
-                        break;
-
-                    case MIDI_CONTROL:
-                        handle_midi_cc(event.data1, event.data2);
-                        break;
-                }
-
-                pthread_mutex_unlock(&g_mutex);
-            }
-        }
-
-        // Process arpeggiator
-        pthread_mutex_lock(&g_mutex);
-        float delta = GetFrameTime();
-        int arp_note, arp_vel;
-        int arp_event = arp_process(&g_arp, delta, &arp_note, &arp_vel);
-        if (arp_event == 1) {
-            // Note on
-            synth_note_on(&g_synth, arp_note, arp_vel);
-        } else if (arp_event == -1) {
-            // Note off
-            synth_note_off(&g_synth, arp_note);
-        }
-        pthread_mutex_unlock(&g_mutex);
+        // Idle: wait for the next slow frame unless something wakes us
+        int woken = g_ui.idle_ui && doze(midi_in);
+        int midi_events = poll_midi(midi_in);
 
         // Update UI (handles touch input)
-        pthread_mutex_lock(&g_mutex);
+        engine_lock(g_engine);
+        TRACE_BEGIN("ui_update");
         ui_update(&g_ui);
+        TRACE_END("ui_update");
+        g_engine->preset_xfade = g_ui.preset_xfade;
+        g_ui.idle_audio = g_engine->stats.idle;
+        g_ui.limiter_gr = g_engine->stats.limiter_gr;
+
+        // Load governor steps, reported once the lock is released
+        int quality = g_engine->stats.quality;
+        unsigned long quality_entered = g_engine->stats.quality_steps[quality];
+        unsigned long voices_stolen = g_engine->stats.voices_stolen;
+
+        // MPE zone size (the controller can change it), reported after too
+        int mpe_members = multi->parts[0].synth.mpe_members;
 
         // Handle panic button
         if (g_ui.panic_triggered) {
-            synth_panic(&g_synth);
+            multi_panic(multi);
             g_ui.panic_triggered = false;
         }
 
-        // Handle buffer size change
-        if (g_ui.buffer_changed) {
-            StopAudioStream(g_stream);
-            UnloadAudioStream(g_stream);
-            SetAudioStreamBufferSizeDefault(BUFFER_SIZES[g_ui.buffer_size]);
-            g_stream = LoadAudioStream(44100, 32, 2);
-            SetAudioStreamCallback(g_stream, SynthAudioCallback);
-            PlayAudioStream(g_stream);
+        // Pick up the name once the audio thread has swapped the preset in
+        // (with its controller map, if it went into part 1)
+        int applied_part, applied_slot;
+        char applied_name[PART_NAME_LEN];
+        if (loader_poll_applied(&g_engine->loader, &applied_part, &applied_slot,
+                                applied_name, sizeof(applied_name))) {
+            snprintf(multi->parts[applied_part].preset_name, PART_NAME_LEN, "%s", applied_name);
+            if (applied_part == g_ui.selected_part) {
+                snprintf(g_ui.preset_name, sizeof(g_ui.preset_name), "%s", applied_name);
+            }
+        }
+
+        // Buffer size changes only move the render-ahead; the stream plays on
+        bool buffer_changed = g_ui.buffer_changed;
+        if (buffer_changed) {
+            renderer_set_depth(&g_renderer, BUFFER_SIZES[g_ui.buffer_size]);
             g_ui.buffer_changed = false;
-            printf("Audio buffer changed to %d samples\n", BUFFER_SIZES[g_ui.buffer_size]);
         }
 
-        pthread_mutex_unlock(&g_mutex);
+        // Auto mode backs off one size per underrun and remembers where it settled
+        unsigned long underruns = renderer_underruns(&g_renderer);
+        bool underran = underruns != last_underruns;
+        int record_buffer = 0;
+        if (underran) {
+            if (g_ui.buffer_auto && g_ui.buffer_size > 0) {
+                g_ui.buffer_size--;
+                renderer_set_depth(&g_renderer, BUFFER_SIZES[g_ui.buffer_size]);
+                record_buffer = 1;
+            }
+            last_underruns = underruns;
+        }
+
+        bool load_preset = g_ui.load_requested;
+        bool reload_tuning = g_ui.tuning_reload;
+        bool save_state = g_ui.snapshot_save;
+        bool restore_state = g_ui.snapshot_restore;
+        g_ui.load_requested = false;
+        g_ui.tuning_reload = false;
+        g_ui.snapshot_save = false;
+        g_ui.snapshot_restore = false;
+        engine_unlock(g_engine);
+
+        // Report load governor steps (counted per level, to find heavy presets)
+        static int last_quality = QUALITY_FULL;
+        if (quality != last_quality) {
+            if (quality > last_quality) {
+                printf("Load: shedding to level %d (%s), entered %lu times, %lu voices stolen\n",
+                       quality, governor_level_name(quality), quality_entered, voices_stolen);
+            } else {
+                printf("Load: restored to level %d (%s)\n", quality, governor_level_name(quality));
+            }
+            last_quality = quality;
+        }
+
+        if (buffer_changed) {
+            printf("Audio buffer changed to %d samples%s\n", BUFFER_SIZES[g_ui.buffer_size],
+                   g_ui.buffer_auto ? " (auto)" : "");
+        }
+        if (underran) {
+            printf("Audio: %lu underruns, buffer %d samples%s\n", underruns,
+                   BUFFER_SIZES[g_ui.buffer_size], g_ui.buffer_auto ? " (auto)" : "");
+        }
+
+        // Report MPE zone changes from the controller
+        static int last_mpe_members = 0;
+        if (mpe_members != last_mpe_members) {
+            last_mpe_members = mpe_members;
+            printf("MPE: %d member channels\n", mpe_members);
+        }
+
+        // Hand preset loads to the background loader (the bank check stats
+        // the JSON file, so it stays outside the engine lock)
+        if (load_preset) {
+            char path[64];
+            preset_filename(g_ui.current_preset, path, sizeof(path));
+            int index = bank_find_current(&g_bank, g_ui.current_preset, path);
+            if (index >= 0) {
+                // Bank recall: straight copy, no parsing
+                Patch patch;
+                bank_get(&g_bank, index, &patch);
+                loader_request_patch(&g_engine->loader, g_ui.selected_part, g_ui.current_preset, &patch,
+                                     bank_entry(&g_bank, index)->name);
+            } else {
+                loader_request(&g_engine->loader, g_ui.selected_part, g_ui.current_preset, patch_defaults());
+            }
+        }
+
+        if (reload_tuning) {
+            load_tuning();
+        }
+
+        if (record_buffer) {
+            buffer_record_save(g_ui.buffer_size);
+        }
+
+        // Snapshots take the engine lock themselves
+        if (save_state) {
+            int ok = snapshot_save(g_engine, SNAPSHOT_FILE, SNAPSHOT_COMPRESS) == 0;
+            printf("Engine state %s %s\n", ok ? "saved to" : "could not be saved to", SNAPSHOT_FILE);
+        }
+        if (restore_state) {
+            int ok = snapshot_load(g_engine, SNAPSHOT_FILE) == 0;
+            printf("Engine state %s %s\n", ok ? "restored from" : "could not be restored from", SNAPSHOT_FILE);
+        }
+
+        // Trace dump requested with kill -USR1
+        if (g_trace_requested) {
+            g_trace_requested = 0;
+            int events = trace_dump(TRACE_FILE);
+            if (events >= 0) {
+                printf("Trace: %d events written to %s\n", events, TRACE_FILE);
+            } else {
+                printf("Trace: not written (build with make TRACE=1)\n");
+            }
+        }
+
+        // Scope and spectrum read the engine's output tap without the lock
+        double frame_start = GetTime();
+        ui_analyse(&g_ui);
 
         // Draw UI to render texture (logical landscape coordinates)
         BeginTextureMode(target);
-        pthread_mutex_lock(&g_mutex);
+        engine_lock(g_engine);
+        TRACE_BEGIN("ui_draw");
         ui_draw(&g_ui);
-        pthread_mutex_unlock(&g_mutex);
+        TRACE_END("ui_draw");
+        engine_unlock(g_engine);
         EndTextureMode();
+        update_frame_stats(GetTime() - frame_start);
+
+        // Anything playing, touched or received keeps the full frame rate
+        double now = GetTime();
+        if (woken || midi_events > 0 || !g_ui.idle_audio || IsMouseButtonDown(MOUSE_LEFT_BUTTON)) {
+            last_activity = now;
+        }
+        g_ui.idle_ui = now - last_activity >= UI_IDLE_DELAY;
 
         // Draw rotated texture to physical screen
         BeginDrawing();
@@ -231,9 +479,14 @@ int main(void) {
         midi_close(&midi);
     }
 
+    ui_unload_chrome(&g_ui);
     UnloadRenderTexture(target);
     StopAudioStream(g_stream);
     UnloadAudioStream(g_stream);
+    renderer_stop(&g_renderer);
+    telemetry_destroy(g_engine->telemetry, TELEMETRY_NAME);
+    engine_destroy(g_engine);
+    bank_close(&g_bank);
     CloseAudioDevice();
     CloseWindow();
 
@@ -139,6 +139,25 @@ int midi_poll(MidiInput *m, MidiEvent *event) {
             event->data2 = ev->data.control.value;
             return 1;
 
+        case SND_SEQ_EVENT_PITCHBEND:
+            event->type = MIDI_PITCH_BEND;
+            event->channel = ev->data.control.channel;
+            event->data2 = ev->data.control.value + 8192;  // ALSA sends -8192..8191
+            return 1;
+
+        case SND_SEQ_EVENT_CHANPRESS:
+            event->type = MIDI_CHANNEL_PRESSURE;
+            event->channel = ev->data.control.channel;
+            event->data2 = ev->data.control.value;
+            return 1;
+
+        case SND_SEQ_EVENT_KEYPRESS:
+            event->type = MIDI_POLY_PRESSURE;
+            event->channel = ev->data.note.channel;
+            event->data1 = ev->data.note.note;
+            event->data2 = ev->data.note.velocity;
+            return 1;
+
         case SND_SEQ_EVENT_PORT_SUBSCRIBED:
             printf("MIDI: Device connected\n");
             m->connected = 1;
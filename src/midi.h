@@ -5,6 +5,9 @@
 #define MIDI_NOTE_OFF     0x80
 #define MIDI_NOTE_ON      0x90
 #define MIDI_CONTROL      0xB0
+#define MIDI_POLY_PRESSURE    0xA0
+#define MIDI_CHANNEL_PRESSURE 0xD0
+#define MIDI_PITCH_BEND       0xE0
 
 // Common CC numbers
 #define CC_MOD_WHEEL      1
@@ -15,6 +18,13 @@
 #define CC_REVERB         91
 #define CC_DELAY          94
 
+// MPE: per-note timbre on member channels
+#define CC_MPE_TIMBRE     74
+
+// Registered parameter numbers handled by the synth
+#define RPN_PITCH_BEND_RANGE 0
+#define RPN_MPE_CONFIG       6
+
 typedef struct {
     void *seq_handle;  // snd_seq_t*
     int port_id;
@@ -22,10 +32,10 @@ typedef struct {
 } MidiInput;
 
 typedef struct {
-    int type;       // MIDI_NOTE_ON, MIDI_NOTE_OFF, MIDI_CONTROL
+    int type;       // MIDI_NOTE_ON, MIDI_NOTE_OFF, MIDI_CONTROL, ...
     int channel;    // 0-15
     int data1;      // note or CC number
-    int data2;      // velocity or CC value
+    int data2;      // velocity, CC value, pressure, or pitch bend (0-16383, centre 8192)
 } MidiEvent;
 
 int midi_init(MidiInput *m);
@@ -0,0 +1,413 @@
+#include "midimap.h"
+#include "midi.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static const char *CURVE_NAMES[MIDI_CURVE_COUNT] = {"linear", "exp", "log"};
+
+// Default assignments (applied on every channel)
+static const struct { int cc; ParamId param; } DEFAULT_MAP[] = {
+    {CC_FILTER_CUTOFF, PARAM_FILTER_CUTOFF},
+    {CC_FILTER_RESO,   PARAM_FILTER_RESO},
+    {CC_ATTACK,        PARAM_AMP_ATTACK},
+    {CC_RELEASE,       PARAM_AMP_RELEASE},
+    {CC_REVERB,        PARAM_REVERB_MIX},
+    {CC_DELAY,         PARAM_DELAY_MIX},
+    {CC_MOD_WHEEL,     PARAM_LFO_DEPTH},
+};
+
+static void reset_state(MidiMap *m) {
+    memset(m->msb, 0, sizeof(m->msb));
+    memset(m->data_msb, 0, sizeof(m->data_msb));
+    for (int ch = 0; ch < MIDIMAP_CHANNELS; ch++) {
+        m->nrpn_number[ch] = -1;
+        m->nrpn_index[ch] = -1;
+        m->rpn_number[ch] = -1;
+    }
+}
+
+static void set_slot(MidiMap *m, int ch, int cc, MapKind kind) {
+    MidiMapping *e = &m->cc[ch][cc];
+    e->kind = (unsigned char)kind;
+    e->param = -1;
+    e->curve = MIDI_CURVE_LINEAR;
+    e->lo = 0.0f;
+    e->hi = 1.0f;
+}
+
+void midimap_clear(MidiMap *m) {
+    for (int ch = 0; ch < MIDIMAP_CHANNELS; ch++) {
+        for (int cc = 0; cc < MIDIMAP_CCS; cc++) {
+            set_slot(m, ch, cc, MAP_NONE);
+        }
+
+        // NRPN/RPN controllers are part of the table so dispatch stays one lookup
+        set_slot(m, ch, CC_DATA_ENTRY_MSB, MAP_DATA_MSB);
+        set_slot(m, ch, CC_DATA_ENTRY_LSB, MAP_DATA_LSB);
+        set_slot(m, ch, CC_NRPN_MSB, MAP_NRPN_MSB);
+        set_slot(m, ch, CC_NRPN_LSB, MAP_NRPN_LSB);
+        set_slot(m, ch, CC_RPN_MSB, MAP_RPN_MSB);
+        set_slot(m, ch, CC_RPN_LSB, MAP_RPN_LSB);
+    }
+    m->nrpn_count = 0;
+    reset_state(m);
+}
+
+void midimap_init(MidiMap *m) {
+    midimap_clear(m);
+    for (unsigned int i = 0; i < sizeof(DEFAULT_MAP) / sizeof(DEFAULT_MAP[0]); i++) {
+        midimap_set(m, MIDIMAP_ALL_CHANNELS, DEFAULT_MAP[i].cc, DEFAULT_MAP[i].param,
+                    0.0f, 1.0f, MIDI_CURVE_LINEAR, 0);
+    }
+}
+
+void midimap_set(MidiMap *m, int channel, int cc, ParamId param,
+                 float lo, float hi, MidiCurve curve, int hires) {
+    if (cc < 0 || cc >= MIDIMAP_CCS || (unsigned int)param >= PARAM_COUNT) return;
+    if (channel >= MIDIMAP_CHANNELS) return;
+    if ((unsigned int)curve >= MIDI_CURVE_COUNT) curve = MIDI_CURVE_LINEAR;
+
+    // Only CC 0-31 have a fine half
+    if (cc >= MIDIMAP_LSB_OFFSET) hires = 0;
+
+    int first = (channel < 0) ? 0 : channel;
+    int last = (channel < 0) ? MIDIMAP_CHANNELS - 1 : channel;
+    for (int ch = first; ch <= last; ch++) {
+        MidiMapping *e = &m->cc[ch][cc];
+        int was_hires = (e->kind == MAP_CC_MSB);
+
+        e->kind = hires ? MAP_CC_MSB : MAP_CC;
+        e->param = (signed char)param;
+        e->curve = (unsigned char)curve;
+        e->lo = lo;
+        e->hi = hi;
+
+        if (hires) {
+            m->cc[ch][cc + MIDIMAP_LSB_OFFSET] = *e;
+            m->cc[ch][cc + MIDIMAP_LSB_OFFSET].kind = MAP_CC_LSB;
+        } else if (was_hires) {
+            set_slot(m, ch, cc + MIDIMAP_LSB_OFFSET, MAP_NONE);
+        }
+    }
+}
+
+int midimap_set_nrpn(MidiMap *m, int channel, int number, ParamId param,
+                     float lo, float hi, MidiCurve curve) {
+    if (number < 0 || number > 16383 || (unsigned int)param >= PARAM_COUNT) return -1;
+    if ((unsigned int)curve >= MIDI_CURVE_COUNT) curve = MIDI_CURVE_LINEAR;
+
+    // Replace an existing mapping for the same number
+    int index = m->nrpn_count;
+    for (int i = 0; i < m->nrpn_count; i++) {
+        if (m->nrpn[i].channel == channel && m->nrpn[i].number == number) {
+            index = i;
+            break;
+        }
+    }
+    if (index == MIDIMAP_MAX_NRPN) return -1;
+    if (index == m->nrpn_count) m->nrpn_count++;
+
+    NrpnMapping *n = &m->nrpn[index];
+    n->channel = channel;
+    n->number = number;
+    n->map.kind = MAP_CC;
+    n->map.param = (signed char)param;
+    n->map.curve = (unsigned char)curve;
+    n->map.lo = lo;
+    n->map.hi = hi;
+
+    // Selections resolved before this mapping existed are stale
+    reset_state(m);
+    return 0;
+}
+
+void midimap_learn(MidiMap *m, int channel, int cc, ParamId param) {
+    if (channel < 0 || channel >= MIDIMAP_CHANNELS || cc < 0 || cc >= MIDIMAP_CCS) return;
+
+    // Fine half of a pair whose coarse half already drives this parameter
+    if (cc >= MIDIMAP_LSB_OFFSET && cc < 2 * MIDIMAP_LSB_OFFSET) {
+        const MidiMapping *coarse = &m->cc[channel][cc - MIDIMAP_LSB_OFFSET];
+        if ((coarse->kind == MAP_CC || coarse->kind == MAP_CC_MSB) && coarse->param == (int)param) {
+            midimap_set(m, channel, cc - MIDIMAP_LSB_OFFSET, param, coarse->lo, coarse->hi,
+                        (MidiCurve)coarse->curve, 1);
+            return;
+        }
+    }
+
+    midimap_set(m, channel, cc, param, 0.0f, 1.0f, MIDI_CURVE_LINEAR, 0);
+}
+
+//------------------------------------------------------------------------------
+// Dispatch
+//------------------------------------------------------------------------------
+
+static void resolve_nrpn(MidiMap *m, int channel) {
+    int number = m->nrpn_number[channel];
+    m->nrpn_index[channel] = -1;
+    for (int i = 0; i < m->nrpn_count; i++) {
+        const NrpnMapping *n = &m->nrpn[i];
+        if (n->number == number && (n->channel == channel || n->channel < 0)) {
+            m->nrpn_index[channel] = i;
+            return;
+        }
+    }
+}
+
+static int apply(const MidiMapping *e, const ParamContext *ctx, float v) {
+    switch (e->curve) {
+        case MIDI_CURVE_EXP: v = v * v; break;
+        case MIDI_CURVE_LOG: v = sqrtf(v); break;
+        default: break;
+    }
+    param_set_normalized(ctx, (ParamId)e->param, e->lo + (e->hi - e->lo) * v);
+    return e->param;
+}
+
+int midimap_rpn(const MidiMap *m, int channel) {
+    if ((unsigned int)channel >= MIDIMAP_CHANNELS) return -1;
+    return m->rpn_number[channel];
+}
+
+int midimap_handle_cc(MidiMap *m, const ParamContext *ctx, int channel, int cc, int value) {
+    if ((unsigned int)channel >= MIDIMAP_CHANNELS || (unsigned int)cc >= MIDIMAP_CCS) return -1;
+    value &= 0x7F;
+
+    const MidiMapping *e = &m->cc[channel][cc];
+    int number = m->nrpn_number[channel];
+    int rpn = m->rpn_number[channel];
+    int index;
+
+    switch (e->kind) {
+        case MAP_CC:
+            if (cc < MIDIMAP_LSB_OFFSET) m->msb[channel][cc] = (unsigned char)value;
+            return apply(e, ctx, value * (1.0f / 127.0f));
+
+        case MAP_CC_MSB:
+            // Coarse value applies at once; the fine half refines it
+            m->msb[channel][cc] = (unsigned char)value;
+            return apply(e, ctx, (value << 7) * (1.0f / 16383.0f));
+
+        case MAP_CC_LSB:
+            return apply(e, ctx, ((m->msb[channel][cc - MIDIMAP_LSB_OFFSET] << 7) | value) *
+                                 (1.0f / 16383.0f));
+
+        case MAP_NRPN_MSB:
+            m->nrpn_number[channel] = (value << 7) | (number >= 0 ? (number & 0x7F) : 0);
+            m->rpn_number[channel] = -1;
+            resolve_nrpn(m, channel);
+            return -1;
+
+        case MAP_NRPN_LSB:
+            m->nrpn_number[channel] = (number >= 0 ? (number & ~0x7F) : 0) | value;
+            m->rpn_number[channel] = -1;
+            resolve_nrpn(m, channel);
+            return -1;
+
+        case MAP_RPN_MSB:
+        case MAP_RPN_LSB:
+            if (e->kind == MAP_RPN_MSB) {
+                rpn = (value << 7) | (rpn >= 0 ? (rpn & 0x7F) : 0);
+            } else {
+                rpn = (rpn >= 0 ? (rpn & ~0x7F) : 0) | value;
+            }
+            m->rpn_number[channel] = (rpn == 0x3FFF) ? -1 : rpn;  // RPN null deselects
+            m->nrpn_number[channel] = -1;
+            m->nrpn_index[channel] = -1;
+            return -1;
+
+        case MAP_DATA_MSB:
+            index = m->nrpn_index[channel];
+            if (index < 0) return -1;
+            m->data_msb[channel] = (unsigned char)value;
+            return apply(&m->nrpn[index].map, ctx, (value << 7) * (1.0f / 16383.0f));
+
+        case MAP_DATA_LSB:
+            index = m->nrpn_index[channel];
+            if (index < 0) return -1;
+            return apply(&m->nrpn[index].map, ctx,
+                         ((m->data_msb[channel] << 7) | value) * (1.0f / 16383.0f));
+
+        default:
+            // Fine half arriving for a 7-bit mapping: the controller is 14-bit,
+            // so upgrade the pair and use the extra resolution from now on
+            if (cc >= MIDIMAP_LSB_OFFSET && cc < 2 * MIDIMAP_LSB_OFFSET) {
+                const MidiMapping *coarse = &m->cc[channel][cc - MIDIMAP_LSB_OFFSET];
+                if (coarse->kind == MAP_CC) {
+                    midimap_set(m, channel, cc - MIDIMAP_LSB_OFFSET, (ParamId)coarse->param,
+                                coarse->lo, coarse->hi, (MidiCurve)coarse->curve, 1);
+                    return midimap_handle_cc(m, ctx, channel, cc, value);
+                }
+            }
+            return -1;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Flat and text forms for presets
+//------------------------------------------------------------------------------
+
+static int same_mapping(const MidiMapping *a, const MidiMapping *b) {
+    return a->kind == b->kind && a->param == b->param && a->curve == b->curve &&
+           a->lo == b->lo && a->hi == b->hi;
+}
+
+static int is_user_mapping(const MidiMapping *e) {
+    return (e->kind == MAP_CC || e->kind == MAP_CC_MSB) && e->param >= 0;
+}
+
+static void fill_entry(MidiMapEntry *out, int channel, int number, int nrpn, const MidiMapping *e) {
+    memset(out, 0, sizeof(*out));
+    out->channel = (int8_t)channel;
+    out->number = (uint16_t)number;
+    out->nrpn = (uint8_t)nrpn;
+    out->hires = (e->kind == MAP_CC_MSB);
+    out->param = e->param;
+    out->curve = e->curve < MIDI_CURVE_COUNT ? e->curve : MIDI_CURVE_LINEAR;
+    out->lo = e->lo;
+    out->hi = e->hi;
+}
+
+// Iteration order: for each CC, "all channels" (step 0) then channels 1-16,
+// then the NRPN table
+static int next_entry(const MidiMap *m, int *iter, MidiMapEntry *out) {
+    const int steps = MIDIMAP_CHANNELS + 1;
+
+    while (*iter < MIDIMAP_CCS * steps) {
+        int cc = *iter / steps;
+        int step = *iter % steps;
+        (*iter)++;
+
+        const MidiMapping *first = &m->cc[0][cc];
+        int uniform = 1;
+        for (int ch = 1; ch < MIDIMAP_CHANNELS && uniform; ch++) {
+            uniform = same_mapping(&m->cc[ch][cc], first);
+        }
+
+        if (step == 0) {
+            if (!uniform || !is_user_mapping(first)) continue;
+            fill_entry(out, MIDIMAP_ALL_CHANNELS, cc, 0, first);
+            return 1;
+        }
+
+        const MidiMapping *e = &m->cc[step - 1][cc];
+        if (uniform || !is_user_mapping(e)) continue;
+        fill_entry(out, step - 1, cc, 0, e);
+        return 1;
+    }
+
+    int index = *iter - MIDIMAP_CCS * steps;
+    if (index < m->nrpn_count) {
+        (*iter)++;
+        const NrpnMapping *n = &m->nrpn[index];
+        fill_entry(out, n->channel, n->number, 1, &n->map);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int add_entry(MidiMap *m, const MidiMapEntry *e) {
+    if (e->nrpn) {
+        return midimap_set_nrpn(m, e->channel, e->number, (ParamId)e->param, e->lo, e->hi,
+                                (MidiCurve)e->curve);
+    }
+    if (e->number >= MIDIMAP_CCS) return -1;
+    midimap_set(m, e->channel, e->number, (ParamId)e->param, e->lo, e->hi, (MidiCurve)e->curve,
+                e->hires);
+    return 0;
+}
+
+int midimap_next(const MidiMap *m, int *iter, char *key, int key_size,
+                 char *value, int value_size) {
+    MidiMapEntry e;
+    if (!next_entry(m, iter, &e)) return 0;
+
+    const char *kind = e.nrpn ? "nrpn:" : "";
+    if (e.channel < 0) {
+        snprintf(key, key_size, "*:%s%d", kind, e.number);
+    } else {
+        snprintf(key, key_size, "%d:%s%d", e.channel + 1, kind, e.number);
+    }
+    snprintf(value, value_size, "%s %.4f %.4f %s%s",
+             param_desc((ParamId)e.param)->name, e.lo, e.hi, CURVE_NAMES[e.curve],
+             e.hires ? " 14bit" : "");
+    return 1;
+}
+
+static int parse_entry(const char *key, const char *value, MidiMapEntry *out) {
+    // Channel
+    int channel;
+    const char *p = key;
+    if (*p == '*') {
+        channel = MIDIMAP_ALL_CHANNELS;
+        p++;
+    } else {
+        char *end;
+        channel = (int)strtol(p, &end, 10) - 1;
+        if (end == p || channel < 0 || channel >= MIDIMAP_CHANNELS) return -1;
+        p = end;
+    }
+    if (*p++ != ':') return -1;
+
+    int nrpn = 0;
+    if (strncmp(p, "nrpn:", 5) == 0) {
+        nrpn = 1;
+        p += 5;
+    }
+    char *end;
+    int number = (int)strtol(p, &end, 10);
+    if (end == p || *end != '\0') return -1;
+    if (number < 0 || number > (nrpn ? 16383 : MIDIMAP_CCS - 1)) return -1;
+
+    // Mapping
+    char name[64], curve_name[16] = "linear", flag[16] = "";
+    float lo = 0.0f, hi = 1.0f;
+    if (sscanf(value, "%63s %f %f %15s %15s", name, &lo, &hi, curve_name, flag) < 1) return -1;
+
+    int param = param_find_name(name);
+    if (param < 0) return -1;
+
+    MidiCurve curve = MIDI_CURVE_LINEAR;
+    for (int i = 0; i < MIDI_CURVE_COUNT; i++) {
+        if (strcmp(curve_name, CURVE_NAMES[i]) == 0) curve = (MidiCurve)i;
+    }
+
+    MidiMapping mapping = {nrpn ? MAP_CC : (strcmp(flag, "14bit") == 0 ? MAP_CC_MSB : MAP_CC),
+                           (signed char)param, (unsigned char)curve, lo, hi};
+    fill_entry(out, channel, number, nrpn, &mapping);
+    return 0;
+}
+
+int midimap_parse(MidiMap *m, const char *key, const char *value) {
+    MidiMapEntry e;
+    if (parse_entry(key, value, &e) < 0) return -1;
+    return add_entry(m, &e);
+}
+
+int midimap_export(const MidiMap *m, MidiMapList *out) {
+    int iter = 0;
+    out->count = 0;
+    MidiMapEntry e;
+    while (next_entry(m, &iter, &e)) {
+        if (out->count == MIDIMAP_LIST_MAX) break;
+        out->entries[out->count++] = e;
+    }
+    return out->count;
+}
+
+void midimap_import(MidiMap *m, const MidiMapList *list) {
+    midimap_clear(m);
+    for (int i = 0; i < list->count; i++) {
+        add_entry(m, &list->entries[i]);
+    }
+}
+
+int midimap_list_parse(MidiMapList *list, const char *key, const char *value) {
+    if (list->count < 0) list->count = 0;
+    if (list->count == MIDIMAP_LIST_MAX) return -1;
+    if (parse_entry(key, value, &list->entries[list->count]) < 0) return -1;
+    list->count++;
+    return 0;
+}
@@ -0,0 +1,136 @@
+#ifndef MIDIMAP_H
+#define MIDIMAP_H
+
+#include "param.h"
+#include <stdint.h>
+
+// MIDI controller -> parameter dispatch.
+// Every (channel, CC) pair has a slot in a flat table, so handling a CC is a
+// single lookup plus one param_set; fader floods cost nanoseconds per message.
+
+#define MIDIMAP_CHANNELS 16
+#define MIDIMAP_CCS      128
+#define MIDIMAP_MAX_NRPN 32
+#define MIDIMAP_ALL_CHANNELS -1
+#define MIDIMAP_LIST_MAX 128    // Mappings a preset can carry
+
+// 14-bit controllers: CC n (0-31) is the coarse half, CC n+32 the fine half
+#define MIDIMAP_LSB_OFFSET 32
+
+// NRPN/RPN controller numbers
+#define CC_DATA_ENTRY_MSB 6
+#define CC_DATA_ENTRY_LSB 38
+#define CC_NRPN_LSB       98
+#define CC_NRPN_MSB       99
+#define CC_RPN_LSB        100
+#define CC_RPN_MSB        101
+
+// Controller response applied before the range (per mapping)
+typedef enum {
+    MIDI_CURVE_LINEAR,
+    MIDI_CURVE_EXP,     // Fine control at the bottom of the travel
+    MIDI_CURVE_LOG,     // Fine control at the top of the travel
+    MIDI_CURVE_COUNT
+} MidiCurve;
+
+// What a table slot does with an incoming value
+typedef enum {
+    MAP_NONE,
+    MAP_CC,             // 7-bit controller
+    MAP_CC_MSB,         // Coarse half of a 14-bit pair
+    MAP_CC_LSB,         // Fine half of a 14-bit pair
+    MAP_NRPN_MSB,       // NRPN parameter select
+    MAP_NRPN_LSB,
+    MAP_RPN_MSB,        // RPN select (deselects NRPN)
+    MAP_RPN_LSB,
+    MAP_DATA_MSB,       // Data entry for the selected NRPN
+    MAP_DATA_LSB
+} MapKind;
+
+typedef struct {
+    unsigned char kind;     // MapKind
+    signed char param;      // ParamId, -1 = none
+    unsigned char curve;    // MidiCurve
+    float lo;               // Normalized parameter position at controller 0
+    float hi;               // ... and at full scale (lo > hi inverts)
+} MidiMapping;
+
+typedef struct {
+    int channel;            // 0-15
+    int number;             // 14-bit NRPN number
+    MidiMapping map;
+} NrpnMapping;
+
+typedef struct {
+    MidiMapping cc[MIDIMAP_CHANNELS][MIDIMAP_CCS];
+    unsigned char msb[MIDIMAP_CHANNELS][MIDIMAP_LSB_OFFSET];   // Last coarse value per pair
+
+    // NRPN state per channel
+    int nrpn_number[MIDIMAP_CHANNELS];      // Selected NRPN, -1 = none
+    int nrpn_index[MIDIMAP_CHANNELS];       // Resolved mapping, -1 = unmapped
+    unsigned char data_msb[MIDIMAP_CHANNELS];
+    int rpn_number[MIDIMAP_CHANNELS];       // Selected RPN, -1 = none
+
+    NrpnMapping nrpn[MIDIMAP_MAX_NRPN];
+    int nrpn_count;
+} MidiMap;
+
+// One mapping in flat form, as presets and bank records carry it
+typedef struct {
+    int8_t channel;         // 0-15, -1 = all channels
+    uint8_t nrpn;           // number is an NRPN rather than a CC
+    uint8_t hires;          // CC 0-31 paired with CC+32
+    int8_t param;           // ParamId
+    uint16_t number;        // CC or NRPN number
+    uint8_t curve;          // MidiCurve
+    uint8_t reserved;
+    float lo;
+    float hi;
+} MidiMapEntry;
+
+typedef struct {
+    int count;              // -1 = none given (the current map stays)
+    MidiMapEntry entries[MIDIMAP_LIST_MAX];
+} MidiMapList;
+
+// Initialize with the default controller assignments (all channels)
+void midimap_init(MidiMap *m);
+
+// Remove all controller and NRPN mappings
+void midimap_clear(MidiMap *m);
+
+// Map a CC (channel -1 = all channels). hires pairs CC 0-31 with CC+32.
+void midimap_set(MidiMap *m, int channel, int cc, ParamId param,
+                 float lo, float hi, MidiCurve curve, int hires);
+
+// Map an NRPN number (returns -1 if the NRPN table is full)
+int midimap_set_nrpn(MidiMap *m, int channel, int number, ParamId param,
+                     float lo, float hi, MidiCurve curve);
+
+// Bind a received CC to a parameter with full range (MIDI learn)
+void midimap_learn(MidiMap *m, int channel, int cc, ParamId param);
+
+// Dispatch a CC message. Returns the parameter changed, or -1.
+int midimap_handle_cc(MidiMap *m, const ParamContext *ctx, int channel, int cc, int value);
+
+// RPN currently selected on a channel (-1 = none). RPN data entry is not
+// mapped to parameters; the caller reads it alongside midimap_handle_cc.
+int midimap_rpn(const MidiMap *m, int channel);
+
+// Text form used in presets: key "<channel>:<cc>" or "<channel>:nrpn:<number>"
+// (channel 1-16 or "*"), value "<param> <lo> <hi> <curve>[ 14bit]".
+// midimap_next iterates mappings from *iter = 0; returns 0 when done.
+int midimap_next(const MidiMap *m, int *iter, char *key, int key_size,
+                 char *value, int value_size);
+int midimap_parse(MidiMap *m, const char *key, const char *value);
+
+// Flat list form: midimap_export lists the user mappings (as midimap_next
+// does; any past MIDIMAP_LIST_MAX are dropped) and returns the count.
+// midimap_import replaces every assignment with the list's; it neither
+// allocates nor blocks, so the audio thread can swap a preset's map in.
+// midimap_list_parse adds one text mapping (-1 if malformed or full).
+int midimap_export(const MidiMap *m, MidiMapList *out);
+void midimap_import(MidiMap *m, const MidiMapList *list);
+int midimap_list_parse(MidiMapList *list, const char *key, const char *value);
+
+#endif // MIDIMAP_H
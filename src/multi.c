@@ -0,0 +1,317 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "multi.h"
+#include "midi.h"
+#include "rtcheck.h"
+#include "trace.h"
+#include "perfctr.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+
+static int part_is_active(const Part *p) {
+    return p->enabled && (synth_is_active(&p->synth) || crossfade_active(&p->xfade));
+}
+
+// A part on an MPE zone's master channel also takes the zone's member channels
+static int part_listens(const Part *p, int channel) {
+    return p->enabled && (p->channel == PART_OMNI || p->channel == channel ||
+                          (p->channel == MPE_ZONE_MASTER && synth_is_member_channel(&p->synth, channel)));
+}
+
+int multi_is_active(const Multi *m) {
+    for (int i = 0; i < MAX_PARTS; i++) {
+        if (part_is_active(&m->parts[i])) return 1;
+    }
+    return 0;
+}
+
+int multi_steal_quietest(Multi *m) {
+    Voice *quietest = NULL;
+    float lowest = 0.0f;
+    for (int i = 0; i < MAX_PARTS; i++) {
+        Synth *s = &m->parts[i].synth;
+        if (!m->parts[i].enabled) continue;
+        for (int n = 0; n < NUM_VOICES; n++) {
+            Voice *v = &s->voices[n];
+            if (!voice_is_active(v) || v->stolen) continue;
+            float level = voice_level(v) * s->smooth[SMOOTH_VOLUME].value;
+            if (!quietest || level < lowest) {
+                quietest = v;
+                lowest = level;
+            }
+        }
+    }
+    if (!quietest) return 0;
+    voice_steal(quietest);
+    return 1;
+}
+
+void multi_init(Multi *m) {
+    for (int i = 0; i < MAX_PARTS; i++) {
+        Part *p = &m->parts[i];
+        synth_init(&p->synth);
+        arp_init(&p->arp);
+        p->xfade.remaining = 0;
+        p->enabled = (i == 0);
+        p->channel = (i == 0) ? PART_OMNI : i;
+        p->fx_send = 1.0f;
+        snprintf(p->preset_name, sizeof(p->preset_name), "Init");
+        p->job = PART_JOB_IDLE;
+        p->frames = 0;
+    }
+    m->worker_count = 0;
+    m->running = 0;
+}
+
+//------------------------------------------------------------------------------
+// Parallel rendering
+//
+// Each active part is a job. The audio thread marks them PENDING, wakes up to
+// one worker per extra job, then claims jobs itself alongside the workers
+// (compare-and-swap on the job state), so a worker that wakes late costs
+// nothing: the audio thread has simply rendered its share. The audio thread
+// only waits for jobs a worker has already started: it polls the done count
+// for a short while, then sleeps on it.
+//------------------------------------------------------------------------------
+
+static void part_render(Part *p) {
+    TRACE_BEGIN("part");
+    PERF_BEGIN(PERF_PART);
+    Synth *s = &p->synth;
+    for (int i = 0; i < p->frames; i++) {
+        // Parameter smoothing and voice updates run at control rate
+        if (i % CONTROL_BLOCK == 0) {
+            synth_control_update(s);
+        }
+
+        Stereo sample = synth_process(s);
+
+        // Blend with the outgoing preset while a switch is fading
+        if (crossfade_active(&p->xfade)) {
+            sample = crossfade_process(&p->xfade, sample);
+        }
+
+        p->buffer[i] = sample;
+    }
+    PERF_END(PERF_PART);
+    TRACE_END("part");
+}
+
+// Returns the number of parts this thread rendered. Workers post each one
+// to m->done.
+static int run_jobs(Multi *m, int worker) {
+    int rendered = 0;
+    for (int i = 0; i < MAX_PARTS; i++) {
+        Part *p = &m->parts[i];
+        int expected = PART_JOB_PENDING;
+        if (__atomic_compare_exchange_n(&p->job, &expected, PART_JOB_RUNNING, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            part_render(p);
+            __atomic_store_n(&p->job, PART_JOB_DONE, __ATOMIC_RELEASE);
+            if (worker) sem_post(&m->done);
+            rendered++;
+        }
+    }
+    return rendered;
+}
+
+static void *worker_thread(void *arg) {
+    Multi *m = (Multi *)arg;
+    TRACE_THREAD("worker");
+    for (;;) {
+        sem_wait(&m->wake);
+        if (!__atomic_load_n(&m->running, __ATOMIC_ACQUIRE)) break;
+        rtcheck_enter();
+        run_jobs(m, 1);
+        rtcheck_leave();
+    }
+    return NULL;
+}
+
+int multi_start(Multi *m) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int wanted = (cores > 1) ? (int)cores - 1 : 0;
+    if (wanted > PART_MAX_WORKERS) wanted = PART_MAX_WORKERS;
+
+    if (sem_init(&m->wake, 0, 0) != 0) return 0;
+    if (sem_init(&m->done, 0, 0) != 0) {
+        sem_destroy(&m->wake);
+        return 0;
+    }
+    m->running = 1;
+    m->worker_count = 0;
+    m->realtime_workers = 0;
+
+    for (int i = 0; i < wanted; i++) {
+        if (pthread_create(&m->workers[i], NULL, worker_thread, m) != 0) break;
+
+        // Workers stand in for the audio thread, so match its scheduling when allowed
+        struct sched_param sp;
+        sp.sched_priority = sched_get_priority_min(SCHED_FIFO) + 1;
+        if (pthread_setschedparam(m->workers[i], SCHED_FIFO, &sp) == 0) {
+            m->realtime_workers++;
+        }
+
+        m->worker_count++;
+    }
+    return m->worker_count;
+}
+
+void multi_stop(Multi *m) {
+    if (!m->running) return;
+
+    __atomic_store_n(&m->running, 0, __ATOMIC_RELEASE);
+    for (int i = 0; i < m->worker_count; i++) {
+        sem_post(&m->wake);
+    }
+    for (int i = 0; i < m->worker_count; i++) {
+        pthread_join(m->workers[i], NULL);
+    }
+    m->worker_count = 0;
+    m->realtime_workers = 0;
+    sem_destroy(&m->wake);
+    sem_destroy(&m->done);
+}
+
+void multi_render(Multi *m, Stereo *dry, Stereo *send, int frames) {
+    if (frames > PART_MAX_FRAMES) frames = PART_MAX_FRAMES;
+
+    int active[MAX_PARTS];
+    int count = 0;
+
+    for (int i = 0; i < MAX_PARTS; i++) {
+        Part *p = &m->parts[i];
+        if (!part_is_active(p)) continue;  // Idle parts cost nothing
+        p->frames = frames;
+        __atomic_store_n(&p->job, PART_JOB_PENDING, __ATOMIC_RELEASE);
+        active[count++] = i;
+    }
+
+    memset(dry, 0, frames * sizeof(Stereo));
+    memset(send, 0, frames * sizeof(Stereo));
+    if (count == 0) return;
+
+    // One part renders inline; more are shared with the workers
+    int wake = count - 1;
+    if (wake > m->worker_count) wake = m->worker_count;
+    for (int i = 0; i < wake; i++) {
+        sem_post(&m->wake);
+    }
+
+    // Whatever the workers claimed, they post when finished. A part is
+    // usually nearly done by now, so poll before sleeping: a preempted
+    // worker then costs a wakeup rather than the rest of our time slice.
+    int remaining = count - run_jobs(m, 0);
+    for (int spin = 0; remaining > 0 && spin < PART_SPIN_LIMIT; spin++) {
+        if (sem_trywait(&m->done) == 0) remaining--;
+    }
+    while (remaining > 0) {
+        if (sem_wait(&m->done) == 0) remaining--;
+    }
+
+    for (int n = 0; n < count; n++) {
+        Part *p = &m->parts[active[n]];
+
+        float wet = p->fx_send;
+        for (int i = 0; i < frames; i++) {
+            send[i] += p->buffer[i] * wet;
+            dry[i] += p->buffer[i] * (1.0f - wet);
+        }
+        p->job = PART_JOB_IDLE;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Note routing
+//------------------------------------------------------------------------------
+
+void multi_note_on(Multi *m, int channel, int note, int velocity) {
+    for (int i = 0; i < MAX_PARTS; i++) {
+        Part *p = &m->parts[i];
+        if (!part_listens(p, channel)) continue;
+
+        if (p->arp.enabled) {
+            arp_note_on(&p->arp, note, velocity);
+        } else {
+            synth_note_on_channel(&p->synth, channel, note, velocity);
+        }
+    }
+}
+
+void multi_note_off(Multi *m, int channel, int note) {
+    for (int i = 0; i < MAX_PARTS; i++) {
+        Part *p = &m->parts[i];
+        if (!part_listens(p, channel)) continue;
+
+        if (p->arp.enabled) {
+            arp_note_off(&p->arp, note);
+        } else {
+            synth_note_off_channel(&p->synth, channel, note);
+        }
+    }
+}
+
+void multi_expression(Multi *m, int channel, ExprLane lane, float value) {
+    for (int i = 0; i < MAX_PARTS; i++) {
+        Part *p = &m->parts[i];
+        if (part_listens(p, channel)) synth_expression(&p->synth, channel, lane, value);
+    }
+}
+
+void multi_note_pressure(Multi *m, int channel, int note, float value) {
+    for (int i = 0; i < MAX_PARTS; i++) {
+        Part *p = &m->parts[i];
+        if (part_listens(p, channel)) synth_note_pressure(&p->synth, note, value);
+    }
+}
+
+void multi_rpn(Multi *m, int channel, int rpn, int value) {
+    for (int i = 0; i < MAX_PARTS; i++) {
+        Part *p = &m->parts[i];
+        if (!part_listens(p, channel)) continue;
+
+        if (rpn == RPN_PITCH_BEND_RANGE) {
+            synth_set_bend_range(&p->synth, channel, value);
+        } else if (rpn == RPN_MPE_CONFIG && channel == MPE_ZONE_MASTER) {
+            synth_set_mpe_members(&p->synth, value);
+        }
+    }
+}
+
+void multi_panic(Multi *m) {
+    for (int i = 0; i < MAX_PARTS; i++) {
+        synth_panic(&m->parts[i].synth);
+        arp_clear(&m->parts[i].arp);
+    }
+}
+
+void multi_set_tuning(Multi *m, const Tuning *t) {
+    for (int i = 0; i < MAX_PARTS; i++) {
+        synth_set_tuning(&m->parts[i].synth, t);
+    }
+}
+
+void multi_process_arps(Multi *m, float delta_time) {
+    for (int i = 0; i < MAX_PARTS; i++) {
+        Part *p = &m->parts[i];
+        if (!p->enabled) continue;
+
+        // Runs with the arp off too, so a held arp note still gets its note-off
+        int note, velocity;
+        int event = arp_process(&p->arp, delta_time, &note, &velocity);
+        if (event == 1) {
+            synth_note_on(&p->synth, note, velocity);
+        } else if (event == -1) {
+            synth_note_off(&p->synth, note);
+        }
+    }
+}
+
+int multi_part_for_channel(const Multi *m, int channel, int from) {
+    for (int i = from; i < MAX_PARTS; i++) {
+        if (part_listens(&m->parts[i], channel)) return i;
+    }
+    return -1;
+}
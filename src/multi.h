@@ -0,0 +1,100 @@
+#ifndef MULTI_H
+#define MULTI_H
+
+#include "synth.h"
+#include "arp.h"
+#include "crossfade.h"
+#include <pthread.h>
+#include <semaphore.h>
+
+// Multitimbral operation: up to MAX_PARTS independent parts, each with its
+// own voice pool, arpeggiator, preset and MIDI channel, summed into the
+// shared effects. Active parts render in parallel on spare cores; parts with
+// nothing sounding are skipped entirely.
+
+#define MAX_PARTS 8
+#define PART_OMNI -1            // Part responds to every MIDI channel
+#define PART_MAX_FRAMES 1024    // Largest block rendered in one pass
+#define PART_MAX_WORKERS 3      // Render threads besides the audio thread
+#define PART_SPIN_LIMIT 2000    // Polls for a worker's part before sleeping on it
+#define PART_NAME_LEN 32
+
+// Render job state per part (accessed atomically)
+typedef enum {
+    PART_JOB_IDLE,
+    PART_JOB_PENDING,       // Queued for this block
+    PART_JOB_RUNNING,       // Claimed by a thread
+    PART_JOB_DONE
+} PartJob;
+
+typedef struct {
+    Synth synth;
+    Arpeggiator arp;
+    Crossfade xfade;        // Preset switch fade for this part
+    int enabled;
+    int channel;            // MIDI channel 0-15, PART_OMNI = all
+    float fx_send;          // Share sent through the effects (rest stays dry)
+    char preset_name[PART_NAME_LEN];
+
+    // Render job (audio thread and workers)
+    int job;                // PartJob
+    int frames;
+    Stereo buffer[PART_MAX_FRAMES];
+} Part;
+
+typedef struct {
+    Part parts[MAX_PARTS];
+
+    // Render workers
+    pthread_t workers[PART_MAX_WORKERS];
+    int worker_count;
+    int realtime_workers;       // Workers that got SCHED_FIFO (the rest run normal)
+    sem_t wake;
+    sem_t done;                 // One post per part a worker finishes
+    int running;
+} Multi;
+
+// Part 1 is enabled in omni mode; the others start disabled on channels 2-8
+void multi_init(Multi *m);
+
+// Start/stop render workers (one per spare core; returns the worker count).
+// Workers that cannot get SCHED_FIFO still run, and are left out of
+// realtime_workers.
+int multi_start(Multi *m);
+void multi_stop(Multi *m);
+
+// True while any enabled part has a voice or crossfade sounding
+int multi_is_active(const Multi *m);
+
+// Fade out the quietest sounding voice in any part (load governor).
+// Returns 1, or 0 if nothing was left to steal.
+int multi_steal_quietest(Multi *m);
+
+// Render all active parts (audio thread, at most PART_MAX_FRAMES). dry
+// receives the unsent share and send the effects input, both stereo; they
+// are overwritten.
+void multi_render(Multi *m, Stereo *dry, Stereo *send, int frames);
+
+// Note routing to every enabled part listening on the channel
+void multi_note_on(Multi *m, int channel, int note, int velocity);
+void multi_note_off(Multi *m, int channel, int note);
+void multi_panic(Multi *m);
+
+// Expression routing (see synth_expression / synth_note_pressure)
+void multi_expression(Multi *m, int channel, ExprLane lane, float value);
+void multi_note_pressure(Multi *m, int channel, int note, float value);
+
+// RPN data entry: pitch bend range, or the MPE zone size on the master channel
+void multi_rpn(Multi *m, int channel, int rpn, int value);
+
+// Install a tuning in every part
+void multi_set_tuning(Multi *m, const Tuning *t);
+
+// Advance the arpeggiators and play their notes
+void multi_process_arps(Multi *m, float delta_time);
+
+// Next enabled part, from index `from` on, listening on a channel (-1 if
+// none). Loop with from = previous + 1 to visit every part a note would reach.
+int multi_part_for_channel(const Multi *m, int channel, int from);
+
+#endif // MULTI_H
@@ -6,9 +6,18 @@
 #define M_PI 3.14159265358979323846f
 #endif
 
+float sample_rate = (float)DEFAULT_SAMPLE_RATE;
+
+int set_sample_rate(int rate) {
+    if (rate < MIN_SAMPLE_RATE) rate = MIN_SAMPLE_RATE;
+    if (rate > MAX_SAMPLE_RATE) rate = MAX_SAMPLE_RATE;
+    sample_rate = (float)rate;
+    return rate;
+}
+
 void osc_init(Oscillator *osc) {
-    osc->phase = 0.0f;
-    osc->frequency = 440.0f;
+    osc->phase = 0;
+    osc_set_frequency(osc, 440.0f);
     osc->type = WAVE_SINE;
     osc->pulse_width = 0.5f;  // 50% duty cycle
     osc->noise_seed = 12345;
@@ -17,7 +26,13 @@ void osc_init(Oscillator *osc) {
 }
 
 void osc_set_frequency(Oscillator *osc, float freq) {
-    osc->frequency = freq;
+    osc_set_increment(osc, freq / sample_rate * PHASE_CYCLE);
+}
+
+void osc_set_increment(Oscillator *osc, float increment) {
+    if (increment < 0.0f) increment = 0.0f;
+    if (increment > PHASE_CYCLE * 0.5f) increment = PHASE_CYCLE * 0.5f - 1.0f;
+    osc->increment = (uint32_t)increment;
 }
 
 void osc_set_type(Oscillator *osc, WaveType type) {
@@ -50,7 +65,7 @@ static float generate_noise(unsigned int *seed) {
 
 float osc_generate(Oscillator *osc) {
     float sample = 0.0f;
-    float phase = osc->phase;
+    float phase = osc->phase * (1.0f / PHASE_CYCLE);
 
     switch (osc->type) {
         case WAVE_SINE:
@@ -81,17 +96,13 @@ float osc_generate(Oscillator *osc) {
 
         case WAVE_WAVETABLE:
             if (osc->wavetable) {
-                sample = wavetable_sample(osc->wavetable, osc->wt_position, phase);
+                sample = wavetable_sample(osc->wavetable, osc->wt_position, osc->phase);
             }
             break;
     }
 
-    // Advance phase
-    float inc = osc->frequency / SAMPLE_RATE;
-    osc->phase += inc;
-    if (osc->phase >= 1.0f) {
-        osc->phase -= 1.0f;
-    }
+    // Advance phase (integer overflow is the wrap)
+    osc->phase += osc->increment;
 
     return sample;
 }
@@ -2,8 +2,19 @@
 #define OSCILLATOR_H
 
 #include "wavetable.h"
+#include <stdint.h>
 
-#define SAMPLE_RATE 44100.0f
+// Output sample rate. Chosen once at startup (set_sample_rate, before any
+// *_init call); every rate-dependent coefficient and buffer length is derived
+// from it.
+#define DEFAULT_SAMPLE_RATE 44100
+#define MIN_SAMPLE_RATE 22050
+#define MAX_SAMPLE_RATE 96000
+
+extern float sample_rate;
+
+// Clamps to MIN..MAX_SAMPLE_RATE and returns the rate in use
+int set_sample_rate(int rate);
 
 typedef enum {
     WAVE_SINE,
@@ -14,20 +25,26 @@ typedef enum {
     WAVE_WAVETABLE
 } WaveType;
 
+// One full cycle of an oscillator's 32-bit phase accumulator (wraps for free)
+#define PHASE_CYCLE 4294967296.0f
+
 typedef struct {
-    float phase;
-    float frequency;
+    uint32_t phase;         // Position in the cycle, 0 to 2^32
+    uint32_t increment;     // Phase step per sample
     WaveType type;
     float pulse_width;      // 0.0-1.0, default 0.5 (50% duty cycle)
     unsigned int noise_seed;
 
     // Wavetable
-    Wavetable *wavetable;   // Pointer to current wavetable
+    const Wavetable *wavetable;  // Pointer to current (shared) wavetable
     float wt_position;      // Position within wavetable (0.0-1.0)
 } Oscillator;
 
 void osc_init(Oscillator *osc);
 void osc_set_frequency(Oscillator *osc, float freq);
+
+// Set the phase step directly (in units of 2^32 per cycle; clamped to Nyquist)
+void osc_set_increment(Oscillator *osc, float increment);
 void osc_set_type(Oscillator *osc, WaveType type);
 void osc_set_pulse_width(Oscillator *osc, float width);
 void osc_set_wavetable(Oscillator *osc, WavetableType type);
@@ -0,0 +1,267 @@
+#include "param.h"
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#define F(type, field) offsetof(type, field)
+
+static const ParamDesc param_table[PARAM_COUNT] = {
+    [PARAM_WAVE1] = {"oscillator.wave1", "oscillator", "wave1", "Wave", PARAM_INT, 0.0f, 5.0f,
+        PARAM_CURVE_STEPPED, PARAM_TARGET_SYNTH, F(Synth, wave_type), PARAM_SMOOTH_NONE},
+    [PARAM_WAVE2] = {"oscillator.wave2", "oscillator", "wave2", "Wave", PARAM_INT, 0.0f, 5.0f,
+        PARAM_CURVE_STEPPED, PARAM_TARGET_SYNTH, F(Synth, wave_type2), PARAM_SMOOTH_NONE},
+    [PARAM_OSC_MIX] = {"oscillator.mix", "oscillator", "mix", "O1/O2", PARAM_FLOAT, 0.0f, 1.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, osc_mix), PARAM_SMOOTH_CONTROL},
+    [PARAM_OSC2_DETUNE] = {"oscillator.detune", "oscillator", "detune", "Det", PARAM_FLOAT, -100.0f, 100.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, osc2_detune), PARAM_SMOOTH_NONE},
+    [PARAM_SUB_MIX] = {"oscillator.sub_mix", "oscillator", "sub_mix", "Sub", PARAM_FLOAT, 0.0f, 1.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, sub_osc_mix), PARAM_SMOOTH_CONTROL},
+    [PARAM_PULSE_WIDTH] = {"oscillator.pulse_width", "oscillator", "pulse_width", "Width", PARAM_FLOAT, 0.05f, 0.95f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, pulse_width), PARAM_SMOOTH_CONTROL},
+    [PARAM_PWM_RATE] = {"oscillator.pwm_rate", "oscillator", "pwm_rate", "Rate", PARAM_FLOAT, 0.1f, 20.0f,
+        PARAM_CURVE_EXP, PARAM_TARGET_SYNTH, F(Synth, pwm_rate), PARAM_SMOOTH_NONE},
+    [PARAM_PWM_DEPTH] = {"oscillator.pwm_depth", "oscillator", "pwm_depth", "Depth", PARAM_FLOAT, 0.0f, 0.45f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, pwm_depth), PARAM_SMOOTH_CONTROL},
+    [PARAM_UNISON_COUNT] = {"oscillator.unison_count", "oscillator", "unison_count", "Voc", PARAM_INT, 1.0f, 7.0f,
+        PARAM_CURVE_STEPPED, PARAM_TARGET_SYNTH, F(Synth, unison_count), PARAM_SMOOTH_NONE},
+    [PARAM_UNISON_SPREAD] = {"oscillator.unison_spread", "oscillator", "unison_spread", "Sprd", PARAM_FLOAT, 0.0f, 100.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, unison_spread), PARAM_SMOOTH_NONE},
+    [PARAM_UNISON_WIDTH] = {"oscillator.unison_width", "oscillator", "unison_width", "Wdth", PARAM_FLOAT, 0.0f, 1.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, unison_width), PARAM_SMOOTH_NONE},
+    [PARAM_PAN_SPREAD] = {"oscillator.pan_spread", "oscillator", "pan_spread", "Pan", PARAM_FLOAT, 0.0f, 1.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, pan_spread), PARAM_SMOOTH_NONE},
+    [PARAM_WAVETABLE] = {"oscillator.wavetable_type", "oscillator", "wavetable_type", "Table", PARAM_INT, 0.0f, 3.0f,
+        PARAM_CURVE_STEPPED, PARAM_TARGET_SYNTH, F(Synth, wavetable_type), PARAM_SMOOTH_NONE},
+    [PARAM_WT_POSITION] = {"oscillator.wt_position", "oscillator", "wt_position", "Pos", PARAM_FLOAT, 0.0f, 1.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, wt_position), PARAM_SMOOTH_CONTROL},
+
+    [PARAM_ARP_ENABLED] = {"arpeggiator.enabled", "arpeggiator", "enabled", "Arp", PARAM_INT, 0.0f, 1.0f,
+        PARAM_CURVE_STEPPED, PARAM_TARGET_ARP, F(Arpeggiator, enabled), PARAM_SMOOTH_NONE},
+    [PARAM_ARP_PATTERN] = {"arpeggiator.pattern", "arpeggiator", "pattern", "Ptrn", PARAM_INT, 0.0f, 4.0f,
+        PARAM_CURVE_STEPPED, PARAM_TARGET_ARP, F(Arpeggiator, pattern), PARAM_SMOOTH_NONE},
+    [PARAM_ARP_DIVISION] = {"arpeggiator.division", "arpeggiator", "division", "Div", PARAM_INT, 0.0f, 3.0f,
+        PARAM_CURVE_STEPPED, PARAM_TARGET_ARP, F(Arpeggiator, division), PARAM_SMOOTH_NONE},
+    [PARAM_ARP_TEMPO] = {"arpeggiator.tempo", "arpeggiator", "tempo", "BPM", PARAM_FLOAT, 40.0f, 240.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_ARP, F(Arpeggiator, tempo), PARAM_SMOOTH_NONE},
+    [PARAM_ARP_OCTAVES] = {"arpeggiator.octaves", "arpeggiator", "octaves", "Oct", PARAM_INT, 1.0f, 4.0f,
+        PARAM_CURVE_STEPPED, PARAM_TARGET_ARP, F(Arpeggiator, octaves), PARAM_SMOOTH_NONE},
+    [PARAM_ARP_GATE] = {"arpeggiator.gate", "arpeggiator", "gate", "Gate", PARAM_FLOAT, 0.1f, 1.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_ARP, F(Arpeggiator, gate), PARAM_SMOOTH_NONE},
+
+    [PARAM_FILTER_TYPE] = {"filter.type", "filter", "type", "Type", PARAM_INT, 0.0f, 2.0f,
+        PARAM_CURVE_STEPPED, PARAM_TARGET_SYNTH, F(Synth, filter_type), PARAM_SMOOTH_NONE},
+    [PARAM_FILTER_CUTOFF] = {"filter.cutoff", "filter", "cutoff", "Cut", PARAM_FLOAT, 0.0f, 1.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, filter_cutoff), PARAM_SMOOTH_CONTROL},
+    [PARAM_FILTER_RESO] = {"filter.resonance", "filter", "resonance", "Res", PARAM_FLOAT, 0.0f, 0.95f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, filter_resonance), PARAM_SMOOTH_CONTROL},
+
+    [PARAM_AMP_ATTACK] = {"amp_env.attack", "amp_env", "attack", "A", PARAM_FLOAT, 0.001f, 2.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, attack), PARAM_SMOOTH_NONE},
+    [PARAM_AMP_DECAY] = {"amp_env.decay", "amp_env", "decay", "D", PARAM_FLOAT, 0.001f, 2.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, decay), PARAM_SMOOTH_NONE},
+    [PARAM_AMP_SUSTAIN] = {"amp_env.sustain", "amp_env", "sustain", "S", PARAM_FLOAT, 0.0f, 1.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, sustain), PARAM_SMOOTH_NONE},
+    [PARAM_AMP_RELEASE] = {"amp_env.release", "amp_env", "release", "R", PARAM_FLOAT, 0.001f, 3.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, release), PARAM_SMOOTH_NONE},
+
+    [PARAM_FENV_ATTACK] = {"filter_env.attack", "filter_env", "attack", "A", PARAM_FLOAT, 0.001f, 2.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, filter_env_attack), PARAM_SMOOTH_NONE},
+    [PARAM_FENV_DECAY] = {"filter_env.decay", "filter_env", "decay", "D", PARAM_FLOAT, 0.001f, 2.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, filter_env_decay), PARAM_SMOOTH_NONE},
+    [PARAM_FENV_SUSTAIN] = {"filter_env.sustain", "filter_env", "sustain", "S", PARAM_FLOAT, 0.0f, 1.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, filter_env_sustain), PARAM_SMOOTH_NONE},
+    [PARAM_FENV_RELEASE] = {"filter_env.release", "filter_env", "release", "R", PARAM_FLOAT, 0.001f, 3.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, filter_env_release), PARAM_SMOOTH_NONE},
+    [PARAM_FENV_AMOUNT] = {"filter_env.amount", "filter_env", "amount", "Amt", PARAM_FLOAT, -1.0f, 1.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, filter_env_amount), PARAM_SMOOTH_CONTROL},
+
+    [PARAM_LFO_TYPE] = {"lfo.type", "lfo", "type", "Wave", PARAM_INT, 0.0f, 3.0f,
+        PARAM_CURVE_STEPPED, PARAM_TARGET_SYNTH, F(Synth, lfo_type), PARAM_SMOOTH_NONE},
+    [PARAM_LFO_RATE] = {"lfo.rate", "lfo", "rate", "Rate", PARAM_FLOAT, 0.1f, 20.0f,
+        PARAM_CURVE_EXP, PARAM_TARGET_SYNTH, F(Synth, lfo_rate), PARAM_SMOOTH_NONE},
+    [PARAM_LFO_DEPTH] = {"lfo.depth", "lfo", "depth", "Depth", PARAM_FLOAT, 0.0f, 1.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, lfo_depth), PARAM_SMOOTH_CONTROL},
+
+    [PARAM_BEND_RANGE] = {"expression.bend_range", "expression", "bend_range", "Bend", PARAM_INT, 0.0f, 24.0f,
+        PARAM_CURVE_STEPPED, PARAM_TARGET_SYNTH, F(Synth, bend_range), PARAM_SMOOTH_NONE},
+    [PARAM_MPE_BEND_RANGE] = {"expression.mpe_bend_range", "expression", "mpe_bend_range", "MPE", PARAM_INT, 0.0f, 96.0f,
+        PARAM_CURVE_STEPPED, PARAM_TARGET_SYNTH, F(Synth, mpe_bend_range), PARAM_SMOOTH_NONE},
+    [PARAM_PRESSURE_AMOUNT] = {"expression.pressure", "expression", "pressure", "Prs", PARAM_FLOAT, 0.0f, 1.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, pressure_amount), PARAM_SMOOTH_NONE},
+    [PARAM_TIMBRE_AMOUNT] = {"expression.timbre", "expression", "timbre", "Tmbr", PARAM_FLOAT, 0.0f, 1.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, timbre_amount), PARAM_SMOOTH_NONE},
+
+    [PARAM_DELAY_TIME] = {"effects.delay_time", "effects", "delay_time", "Time", PARAM_FLOAT, 0.01f, DELAY_MAX_TIME,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_EFFECTS, F(Effects, delay.time), PARAM_SMOOTH_NONE},
+    [PARAM_DELAY_FEEDBACK] = {"effects.delay_feedback", "effects", "delay_feedback", "Fdbk", PARAM_FLOAT, 0.0f, 0.9f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_EFFECTS, F(Effects, delay.feedback), PARAM_SMOOTH_CONTROL},
+    [PARAM_DELAY_MIX] = {"effects.delay_mix", "effects", "delay_mix", "Mix", PARAM_FLOAT, 0.0f, 1.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_EFFECTS, F(Effects, delay.mix), PARAM_SMOOTH_CONTROL},
+    [PARAM_DELAY_PINGPONG] = {"effects.delay_pingpong", "effects", "delay_pingpong", "Mode", PARAM_INT, 0.0f, 1.0f,
+        PARAM_CURVE_STEPPED, PARAM_TARGET_EFFECTS, F(Effects, delay.pingpong), PARAM_SMOOTH_NONE},
+    [PARAM_REVERB_MIX] = {"effects.reverb_mix", "effects", "reverb_mix", "Mix", PARAM_FLOAT, 0.0f, 1.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_EFFECTS, F(Effects, reverb.mix), PARAM_SMOOTH_CONTROL},
+    [PARAM_REVERB_SIZE] = {"effects.reverb_size", "effects", "reverb_size", "Size", PARAM_FLOAT, 0.0f, 1.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_EFFECTS, F(Effects, reverb.roomsize), PARAM_SMOOTH_NONE},
+    [PARAM_DIST_DRIVE] = {"effects.dist_drive", "effects", "dist_drive", "Drv", PARAM_FLOAT, 1.0f, 10.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_EFFECTS, F(Effects, distortion.drive), PARAM_SMOOTH_CONTROL},
+    [PARAM_DIST_MIX] = {"effects.dist_mix", "effects", "dist_mix", "Mix", PARAM_FLOAT, 0.0f, 1.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_EFFECTS, F(Effects, distortion.mix), PARAM_SMOOTH_CONTROL},
+
+    [PARAM_VOLUME] = {"volume", "", "volume", "Vol", PARAM_FLOAT, 0.0f, 1.0f,
+        PARAM_CURVE_LINEAR, PARAM_TARGET_SYNTH, F(Synth, volume), PARAM_SMOOTH_CONTROL},
+};
+
+#undef F
+
+//------------------------------------------------------------------------------
+// Perfect hash for section/key lookup
+//
+// The table is generated at init: we search for a hash seed under which every
+// "section.key" string lands in its own slot, so a lookup is one hash, one
+// table read and one string compare to reject unknown keys.
+//------------------------------------------------------------------------------
+#define PARAM_HASH_SIZE 256   // must be a power of two, > 4x PARAM_COUNT
+#define PARAM_HASH_EMPTY 0xFF
+
+static unsigned char hash_slots[PARAM_HASH_SIZE];
+static unsigned int hash_seed = 0;
+static pthread_once_t hash_once = PTHREAD_ONCE_INIT;
+
+// FNV-1a over section, '.', key (no concatenation needed)
+static unsigned int param_hash(unsigned int seed, const char *section, int section_len,
+                               const char *key, int key_len) {
+    unsigned int h = 2166136261u ^ seed;
+    for (int i = 0; i < section_len; i++) {
+        h ^= (unsigned char)section[i];
+        h *= 16777619u;
+    }
+    h ^= '.';
+    h *= 16777619u;
+    for (int i = 0; i < key_len; i++) {
+        h ^= (unsigned char)key[i];
+        h *= 16777619u;
+    }
+    h ^= h >> 15;
+    return h & (PARAM_HASH_SIZE - 1);
+}
+
+static int try_seed(unsigned int seed) {
+    memset(hash_slots, PARAM_HASH_EMPTY, sizeof(hash_slots));
+    for (int i = 0; i < PARAM_COUNT; i++) {
+        const ParamDesc *d = &param_table[i];
+        unsigned int slot = param_hash(seed, d->section, (int)strlen(d->section),
+                                       d->key, (int)strlen(d->key));
+        if (hash_slots[slot] != PARAM_HASH_EMPTY) return 0;  // Collision
+        hash_slots[slot] = (unsigned char)i;
+    }
+    return 1;
+}
+
+static void build_hash(void) {
+    unsigned int seed = 1;
+    while (!try_seed(seed)) {
+        seed++;
+    }
+    hash_seed = seed;
+}
+
+void params_init(void) {
+    pthread_once(&hash_once, build_hash);
+}
+
+const ParamDesc* param_desc(ParamId id) {
+    if ((unsigned int)id >= PARAM_COUNT) return NULL;
+    return &param_table[id];
+}
+
+int param_find(const char *section, int section_len, const char *key, int key_len) {
+    params_init();
+
+    unsigned int slot = param_hash(hash_seed, section, section_len, key, key_len);
+    int id = hash_slots[slot];
+    if (id == PARAM_HASH_EMPTY) return -1;
+
+    // Verify (rejects unknown keys that happen to hash to a used slot)
+    const ParamDesc *d = &param_table[id];
+    if ((int)strlen(d->section) != section_len || memcmp(d->section, section, section_len) != 0) return -1;
+    if ((int)strlen(d->key) != key_len || memcmp(d->key, key, key_len) != 0) return -1;
+
+    return id;
+}
+
+int param_find_name(const char *name) {
+    const char *dot = strchr(name, '.');
+    if (!dot) return param_find("", 0, name, (int)strlen(name));
+    return param_find(name, (int)(dot - name), dot + 1, (int)strlen(dot + 1));
+}
+
+//------------------------------------------------------------------------------
+// Value access
+//------------------------------------------------------------------------------
+
+float param_clamp(ParamId id, float value) {
+    const ParamDesc *d = &param_table[id];
+    if (d->type == PARAM_INT) value = floorf(value + 0.5f);
+    if (value < d->min) value = d->min;
+    if (value > d->max) value = d->max;
+    return value;
+}
+
+static void* param_field(const ParamContext *ctx, const ParamDesc *d) {
+    char *base;
+    switch (d->target) {
+        case PARAM_TARGET_EFFECTS: base = (char *)ctx->effects; break;
+        case PARAM_TARGET_ARP:     base = (char *)ctx->arp; break;
+        default:                   base = (char *)ctx->synth; break;
+    }
+    return base ? base + d->offset : NULL;
+}
+
+float param_get(const ParamContext *ctx, ParamId id) {
+    const ParamDesc *d = &param_table[id];
+    void *field = param_field(ctx, d);
+    if (!field) return 0.0f;
+    if (d->type == PARAM_INT) return (float)*(int *)field;
+    return *(float *)field;
+}
+
+void param_set(const ParamContext *ctx, ParamId id, float value) {
+    const ParamDesc *d = &param_table[id];
+    void *field = param_field(ctx, d);
+    if (!field) return;
+    value = param_clamp(id, value);
+    // The engine may have given the delay a shorter line than the range offered
+    if (id == PARAM_DELAY_TIME && ctx->effects) {
+        float longest = delay_max_time(&ctx->effects->delay);
+        if (value > longest) value = longest;
+    }
+    if (d->type == PARAM_INT) {
+        *(int *)field = (int)value;
+    } else {
+        *(float *)field = value;
+    }
+}
+
+float param_to_normalized(ParamId id, float value) {
+    const ParamDesc *d = &param_table[id];
+    value = param_clamp(id, value);
+    if (d->curve == PARAM_CURVE_EXP) {
+        return logf(value / d->min) / logf(d->max / d->min);
+    }
+    return (value - d->min) / (d->max - d->min);
+}
+
+float param_from_normalized(ParamId id, float norm) {
+    const ParamDesc *d = &param_table[id];
+    if (norm < 0.0f) norm = 0.0f;
+    if (norm > 1.0f) norm = 1.0f;
+    if (d->curve == PARAM_CURVE_EXP) {
+        return d->min * powf(d->max / d->min, norm);
+    }
+    return param_clamp(id, d->min + norm * (d->max - d->min));
+}
+
+void param_set_normalized(const ParamContext *ctx, ParamId id, float norm) {
+    param_set(ctx, id, param_from_normalized(id, norm));
+}
@@ -0,0 +1,159 @@
+#ifndef PARAM_H
+#define PARAM_H
+
+#include "synth.h"
+#include "effects.h"
+#include "arp.h"
+#include <stddef.h>
+
+// Central parameter registry.
+// Every user-facing parameter is described once here; presets, UI sliders,
+// MIDI CC routing and patch snapshots are all driven from this table.
+
+// Parameter IDs (in preset file order)
+typedef enum {
+    // Oscillator
+    PARAM_WAVE1,
+    PARAM_WAVE2,
+    PARAM_OSC_MIX,
+    PARAM_OSC2_DETUNE,
+    PARAM_SUB_MIX,
+    PARAM_PULSE_WIDTH,
+    PARAM_PWM_RATE,
+    PARAM_PWM_DEPTH,
+    PARAM_UNISON_COUNT,
+    PARAM_UNISON_SPREAD,
+    PARAM_UNISON_WIDTH,
+    PARAM_PAN_SPREAD,
+    PARAM_WAVETABLE,
+    PARAM_WT_POSITION,
+
+    // Arpeggiator
+    PARAM_ARP_ENABLED,
+    PARAM_ARP_PATTERN,
+    PARAM_ARP_DIVISION,
+    PARAM_ARP_TEMPO,
+    PARAM_ARP_OCTAVES,
+    PARAM_ARP_GATE,
+
+    // Filter
+    PARAM_FILTER_TYPE,
+    PARAM_FILTER_CUTOFF,
+    PARAM_FILTER_RESO,
+
+    // Amplitude envelope
+    PARAM_AMP_ATTACK,
+    PARAM_AMP_DECAY,
+    PARAM_AMP_SUSTAIN,
+    PARAM_AMP_RELEASE,
+
+    // Filter envelope
+    PARAM_FENV_ATTACK,
+    PARAM_FENV_DECAY,
+    PARAM_FENV_SUSTAIN,
+    PARAM_FENV_RELEASE,
+    PARAM_FENV_AMOUNT,
+
+    // LFO
+    PARAM_LFO_TYPE,
+    PARAM_LFO_RATE,
+    PARAM_LFO_DEPTH,
+
+    // Expression (pitch bend, aftertouch, MPE)
+    PARAM_BEND_RANGE,
+    PARAM_MPE_BEND_RANGE,
+    PARAM_PRESSURE_AMOUNT,
+    PARAM_TIMBRE_AMOUNT,
+
+    // Effects
+    PARAM_DELAY_TIME,
+    PARAM_DELAY_FEEDBACK,
+    PARAM_DELAY_MIX,
+    PARAM_DELAY_PINGPONG,
+    PARAM_REVERB_MIX,
+    PARAM_REVERB_SIZE,
+    PARAM_DIST_DRIVE,
+    PARAM_DIST_MIX,
+
+    // Master
+    PARAM_VOLUME,
+
+    PARAM_COUNT
+} ParamId;
+
+typedef enum {
+    PARAM_FLOAT,
+    PARAM_INT           // Stored as int (includes enums)
+} ParamType;
+
+// Mapping between normalized 0-1 control position and value
+typedef enum {
+    PARAM_CURVE_LINEAR,
+    PARAM_CURVE_EXP,    // Equal ratios per step (rates); min must be > 0
+    PARAM_CURVE_STEPPED // Integer steps
+} ParamCurve;
+
+// Which engine struct the parameter lives in
+typedef enum {
+    PARAM_TARGET_SYNTH,
+    PARAM_TARGET_EFFECTS,
+    PARAM_TARGET_ARP
+} ParamTarget;
+
+// How the engine applies changes
+typedef enum {
+    PARAM_SMOOTH_NONE,      // Takes effect at the next control block
+    PARAM_SMOOTH_CONTROL    // Glides via a control-rate smoother
+} ParamSmoothing;
+
+typedef struct {
+    const char *name;       // Full name, "section.key" ("key" at top level)
+    const char *section;    // JSON object the key lives in ("" = top level)
+    const char *key;        // JSON key within the section
+    const char *label;      // Short UI label (panel title gives context)
+    ParamType type;
+    float min;
+    float max;
+    ParamCurve curve;
+    ParamTarget target;
+    size_t offset;          // Byte offset of the field within the target struct
+    ParamSmoothing smoothing;
+} ParamDesc;
+
+// Live engine state the parameters are read from and written to.
+// A NULL member skips its parameters (param_get returns 0, param_set does nothing).
+typedef struct {
+    Synth *synth;
+    Effects *effects;
+    Arpeggiator *arp;
+} ParamContext;
+
+// Build the name lookup table (thread-safe, runs once; lookups call it lazily)
+void params_init(void);
+
+// Get descriptor for a parameter ID (O(1))
+const ParamDesc* param_desc(ParamId id);
+
+// Resolve section/key to a parameter ID (strings need not be NUL-terminated)
+// Returns -1 if the key is unknown
+int param_find(const char *section, int section_len, const char *key, int key_len);
+
+// Resolve a full name such as "filter.cutoff" (returns -1 if unknown)
+int param_find_name(const char *name);
+
+// Clamp a value to the parameter's range (and round integer parameters)
+float param_clamp(ParamId id, float value);
+
+// Read/write the live engine value. param_set clamps and stores the new
+// target only (O(1)); the audio thread picks it up at the next control block.
+float param_get(const ParamContext *ctx, ParamId id);
+void param_set(const ParamContext *ctx, ParamId id, float value);
+
+// Convert between value and normalized 0-1 position using the parameter curve
+float param_to_normalized(ParamId id, float value);
+float param_from_normalized(ParamId id, float norm);
+
+// Set from a normalized 0-1 control position (UI sliders, MIDI CC)
+void param_set_normalized(const ParamContext *ctx, ParamId id, float norm);
+
+#endif // PARAM_H
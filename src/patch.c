@@ -0,0 +1,41 @@
+#include "patch.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+static Patch defaults;
+static pthread_once_t defaults_once = PTHREAD_ONCE_INIT;
+
+// Capture a freshly initialised engine (heap: a Synth is too big for a stack)
+static void build_defaults(void) {
+    Synth *s = calloc(1, sizeof(Synth));
+    Effects *fx = calloc(1, sizeof(Effects));
+    Arpeggiator arp;
+    if (!s || !fx) abort();
+    synth_init(s);
+    effects_init(fx);
+    arp_init(&arp);
+    patch_capture(&defaults, s, fx, &arp);
+    free(s);
+    free(fx);
+}
+
+const Patch *patch_defaults(void) {
+    pthread_once(&defaults_once, build_defaults);
+    return &defaults;
+}
+
+void patch_capture(Patch *p, const Synth *s, const Effects *fx, const Arpeggiator *arp) {
+    // param_get only reads through the context
+    ParamContext ctx = {(Synth *)s, (Effects *)fx, (Arpeggiator *)arp};
+    for (int i = 0; i < PARAM_COUNT; i++) {
+        p->values[i] = param_get(&ctx, (ParamId)i);
+    }
+    p->map.count = -1;
+}
+
+void patch_apply(const Patch *p, Synth *s, Effects *fx, Arpeggiator *arp) {
+    ParamContext ctx = {s, fx, arp};
+    for (int i = 0; i < PARAM_COUNT; i++) {
+        param_set(&ctx, (ParamId)i, p->values[i]);
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef PATCH_H
+#define PATCH_H
+
+#include "param.h"
+#include "synth.h"
+#include "effects.h"
+#include "arp.h"
+#include "midimap.h"
+
+// Staging copy of every preset parameter, indexed by ParamId, and the
+// controller assignments saved with the preset.
+// Presets are parsed into a Patch first and then applied to the engine once.
+typedef struct {
+    float values[PARAM_COUNT];
+    MidiMapList map;            // count -1: the preset has no midi_map section
+} Patch;
+
+// Copy current engine settings into a patch (with no map: loading it keeps
+// the current controller assignments)
+void patch_capture(Patch *p, const Synth *s, const Effects *fx, const Arpeggiator *arp);
+
+// Engine defaults for every parameter (no map; built once, thread-safe).
+// Presets are read on top of this, so keys a preset leaves out take their
+// default whether it is loaded from the bank or from its JSON file.
+const Patch *patch_defaults(void);
+
+// Apply a patch to the engine (values are clamped to the registry ranges)
+void patch_apply(const Patch *p, Synth *s, Effects *fx, Arpeggiator *arp);
+
+#endif // PATCH_H
@@ -0,0 +1,233 @@
+#define _GNU_SOURCE
+
+#include "perfctr.h"
+#include <string.h>
+
+static const char *scope_names[PERF_SCOPE_COUNT] = {
+    "block", "voices", "part", "effects", "limiter"
+};
+
+const char *perf_scope_name(PerfScope scope) {
+    return scope_names[scope];
+}
+
+#ifndef PERF_COUNTERS
+
+int perf_available(void) {
+    return 0;
+}
+
+void perf_stats(PerfScope scope, PerfStats *out) {
+    (void)scope;
+    memset(out, 0, sizeof(PerfStats));
+}
+
+void perf_reset(void) {
+}
+
+void perf_report(FILE *f) {
+    (void)f;
+}
+
+#else
+
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+typedef struct {
+    int ready;                  // Open attempted
+    int leader;                 // Group fd (-1: no counters on this thread)
+    int mask;                   // Events in the group (1 << PerfEvent)
+    int slot[PERF_EVENT_COUNT]; // Position in the group read, or -1
+    int count;                  // Events in the group
+    uint64_t start[PERF_SCOPE_COUNT][PERF_EVENT_COUNT];
+} PerfThread;
+
+static PerfStats stats[PERF_SCOPE_COUNT];
+static int any_available;       // Union of every thread's mask
+
+static __thread PerfThread thread;
+
+static void event_attr(PerfEvent event, struct perf_event_attr *attr) {
+    memset(attr, 0, sizeof(*attr));
+    attr->size = sizeof(*attr);
+    attr->exclude_kernel = 1;   // Also what perf_event_paranoid 2 allows
+    attr->exclude_hv = 1;
+    attr->read_format = PERF_FORMAT_GROUP;
+    switch (event) {
+    case PERF_CYCLES:
+        attr->type = PERF_TYPE_HARDWARE;
+        attr->config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case PERF_INSTRUCTIONS:
+        attr->type = PERF_TYPE_HARDWARE;
+        attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case PERF_L1D_MISSES:
+        attr->type = PERF_TYPE_HW_CACHE;
+        attr->config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                       (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    default:
+        attr->type = PERF_TYPE_HARDWARE;
+        attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    }
+}
+
+// Open this thread's group: the first event that opens leads, the rest join
+// it or are left out
+static PerfThread *thread_counters(void) {
+    PerfThread *t = &thread;
+    if (t->ready) return t;
+    t->ready = 1;
+    t->leader = -1;
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        struct perf_event_attr attr;
+        event_attr((PerfEvent)e, &attr);
+        int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, t->leader, 0);
+        if (fd < 0) {
+            t->slot[e] = -1;
+            continue;
+        }
+        if (t->leader < 0) t->leader = fd;
+        t->slot[e] = t->count++;
+        t->mask |= 1 << e;
+    }
+    __atomic_fetch_or(&any_available, t->mask, __ATOMIC_RELAXED);
+    return t;
+}
+
+static int read_group(PerfThread *t, uint64_t *values) {
+    uint64_t buffer[1 + PERF_EVENT_COUNT];
+    ssize_t size = (ssize_t)((1 + t->count) * sizeof(uint64_t));
+    if (read(t->leader, buffer, size) != size) return -1;
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        values[e] = (t->slot[e] >= 0) ? buffer[1 + t->slot[e]] : 0;
+    }
+    return 0;
+}
+
+void perf_begin(PerfScope scope) {
+    PerfThread *t = thread_counters();
+    if (t->leader < 0) return;
+    if (read_group(t, t->start[scope]) < 0) {
+        t->start[scope][PERF_CYCLES] = UINT64_MAX;
+    }
+}
+
+static int bucket(uint64_t cycles) {
+    int k = 0;
+    while (cycles > 1 && k < PERF_BUCKETS - 1) {
+        cycles >>= 1;
+        k++;
+    }
+    return k;
+}
+
+void perf_end(PerfScope scope) {
+    PerfThread *t = &thread;
+    if (!t->ready || t->leader < 0 || t->start[scope][PERF_CYCLES] == UINT64_MAX) return;
+    uint64_t now[PERF_EVENT_COUNT];
+    if (read_group(t, now) < 0) return;
+
+    // Several workers may finish the same scope at once
+    PerfStats *s = &stats[scope];
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        __atomic_fetch_add(&s->total[e], now[e] - t->start[scope][e], __ATOMIC_RELAXED);
+    }
+    uint64_t cycles = now[PERF_CYCLES] - t->start[scope][PERF_CYCLES];
+    __atomic_fetch_add(&s->histogram[bucket(cycles)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&s->calls, 1, __ATOMIC_RELAXED);
+}
+
+int perf_available(void) {
+    return thread_counters()->mask;
+}
+
+void perf_stats(PerfScope scope, PerfStats *out) {
+    const PerfStats *s = &stats[scope];
+    out->calls = __atomic_load_n(&s->calls, __ATOMIC_RELAXED);
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        out->total[e] = __atomic_load_n(&s->total[e], __ATOMIC_RELAXED);
+    }
+    for (int k = 0; k < PERF_BUCKETS; k++) {
+        out->histogram[k] = __atomic_load_n(&s->histogram[k], __ATOMIC_RELAXED);
+    }
+}
+
+void perf_reset(void) {
+    memset(stats, 0, sizeof(stats));
+}
+
+// Smallest bucket by which this fraction of the calls had finished
+static int percentile(const PerfStats *s, double fraction) {
+    unsigned long want = (unsigned long)(s->calls * fraction);
+    unsigned long seen = 0;
+    for (int k = 0; k < PERF_BUCKETS; k++) {
+        seen += s->histogram[k];
+        if (seen > want) return k;
+    }
+    return PERF_BUCKETS - 1;
+}
+
+void perf_report(FILE *f) {
+    static const char *event_names[PERF_EVENT_COUNT] = {
+        "cycles", "instr", "L1D miss", "br miss"
+    };
+    int mask = __atomic_load_n(&any_available, __ATOMIC_RELAXED);
+    if (!mask) {
+        fprintf(f, "performance counters unavailable (no PMU, or perf_event_paranoid > 2)\n");
+        return;
+    }
+
+    fprintf(f, "%-8s %9s", "scope", "calls");
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) fprintf(f, " %11s", event_names[e]);
+    fprintf(f, " %6s\n", "IPC");
+
+    for (int i = 0; i < PERF_SCOPE_COUNT; i++) {
+        PerfStats s;
+        perf_stats((PerfScope)i, &s);
+        if (s.calls == 0) continue;
+
+        // Means per call
+        fprintf(f, "%-8s %9lu", scope_names[i], s.calls);
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            if (mask & (1 << e)) {
+                fprintf(f, " %11.0f", (double)s.total[e] / s.calls);
+            } else {
+                fprintf(f, " %11s", "n/a");
+            }
+        }
+        if ((mask & (1 << PERF_CYCLES)) && (mask & (1 << PERF_INSTRUCTIONS)) && s.total[PERF_CYCLES]) {
+            fprintf(f, " %6.2f\n", (double)s.total[PERF_INSTRUCTIONS] / s.total[PERF_CYCLES]);
+        } else {
+            fprintf(f, " %6s\n", "n/a");
+        }
+    }
+
+    if (!(mask & (1 << PERF_CYCLES))) return;
+    fprintf(f, "\ncycles per call (log2 buckets)\n");
+    for (int i = 0; i < PERF_SCOPE_COUNT; i++) {
+        PerfStats s;
+        perf_stats((PerfScope)i, &s);
+        if (s.calls == 0) continue;
+
+        unsigned long most = 0;
+        for (int k = 0; k < PERF_BUCKETS; k++) {
+            if (s.histogram[k] > most) most = s.histogram[k];
+        }
+        fprintf(f, "%s: p50 < 2^%d  p99 < 2^%d\n", scope_names[i],
+                percentile(&s, 0.5) + 1, percentile(&s, 0.99) + 1);
+        for (int k = 0; k < PERF_BUCKETS; k++) {
+            if (s.histogram[k] == 0) continue;
+            int bar = (int)(s.histogram[k] * 40 / most);
+            fprintf(f, "  2^%-2d %9lu %.*s\n", k, s.histogram[k], bar > 0 ? bar : 1,
+                    "########################################");
+        }
+    }
+}
+
+#endif // PERF_COUNTERS
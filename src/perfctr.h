@@ -0,0 +1,68 @@
+#ifndef PERFCTR_H
+#define PERFCTR_H
+
+#include <stdio.h>
+
+// Hardware performance counters (builds with -DPERF_COUNTERS, see make PERF=1).
+// PERF_BEGIN/PERF_END bracket a scope on the calling thread. Each thread
+// opens its own perf_event_open group (cycles, instructions, L1D read misses,
+// branch misses) on first use and reads it at both ends; the difference goes
+// into that scope's totals and a log2 histogram of cycles per call. Only user
+// space is counted, so the read() itself does not show up in the numbers.
+// Events the kernel or CPU will not provide are left out, and with none at
+// all the scopes cost one branch. Without PERF_COUNTERS the markers compile
+// to nothing.
+//
+// The reads are system calls: do not combine with RT_CHECK.
+
+typedef enum {
+    PERF_BLOCK,         // One engine_render call
+    PERF_VOICES,        // All parts for one chunk of a block (includes the wait)
+    PERF_PART,          // One part's voices, on whichever thread ran it
+    PERF_EFFECTS,       // Send effects for the same chunk
+    PERF_LIMITER,       // Master limiter for a block
+    PERF_SCOPE_COUNT
+} PerfScope;
+
+typedef enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_EVENT_COUNT
+} PerfEvent;
+
+#define PERF_BUCKETS 40         // Histogram buckets: calls by log2(cycles)
+
+typedef struct {
+    unsigned long calls;
+    unsigned long long total[PERF_EVENT_COUNT];
+    unsigned long histogram[PERF_BUCKETS];  // [k]: cycles in [2^k, 2^(k+1))
+} PerfStats;
+
+#ifdef PERF_COUNTERS
+void perf_begin(PerfScope scope);
+void perf_end(PerfScope scope);
+#define PERF_BEGIN(scope) perf_begin(scope)
+#define PERF_END(scope)   perf_end(scope)
+#else
+#define PERF_BEGIN(scope) ((void)0)
+#define PERF_END(scope)   ((void)0)
+#endif
+
+// Bitmask (1 << PerfEvent) of the events counting on the calling thread
+// (opens its group if needed; 0 without PERF_COUNTERS or without counters)
+int perf_available(void);
+
+// Totals and histogram for one scope, summed over every thread
+void perf_stats(PerfScope scope, PerfStats *out);
+
+// Clear every scope's totals (not while scopes are being measured)
+void perf_reset(void);
+
+const char *perf_scope_name(PerfScope scope);
+
+// Print per-scope means and histograms (prints nothing without PERF_COUNTERS)
+void perf_report(FILE *f);
+
+#endif // PERFCTR_H
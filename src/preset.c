@@ -1,5 +1,6 @@
 #include "preset.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <ctype.h>
@@ -27,7 +28,7 @@ static void write_json_string(FILE *f, const char *key, const char *value) {
     fprintf(f, "\"");
 }
 
-int preset_save(const char *filepath, const char *name, Synth *s, Effects *fx, Arpeggiator *arp) {
+int preset_write(const char *filepath, const char *name, const Patch *p, const MidiMap *map) {
     // Ensure presets directory exists
     mkdir(PRESET_DIR, 0755);
 
@@ -38,252 +39,292 @@ int preset_save(const char *filepath, const char *name, Synth *s, Effects *fx, A
 
     // Preset name
     write_json_string(f, "name", name ? name : "Untitled");
-    fprintf(f, ",\n");
-
-    // Oscillator section
-    fprintf(f, "  \"oscillator\": {\n");
-    fprintf(f, "    \"wave1\": %d,\n", s->wave_type);
-    fprintf(f, "    \"wave2\": %d,\n", s->wave_type2);
-    fprintf(f, "    \"mix\": %.4f,\n", s->osc_mix);
-    fprintf(f, "    \"detune\": %.4f,\n", s->osc2_detune);
-    fprintf(f, "    \"sub_mix\": %.4f,\n", s->sub_osc_mix);
-    fprintf(f, "    \"pulse_width\": %.4f,\n", s->pulse_width);
-    fprintf(f, "    \"pwm_rate\": %.4f,\n", s->pwm_rate);
-    fprintf(f, "    \"pwm_depth\": %.4f,\n", s->pwm_depth);
-    fprintf(f, "    \"unison_count\": %d,\n", s->unison_count);
-    fprintf(f, "    \"unison_spread\": %.4f,\n", s->unison_spread);
-    fprintf(f, "    \"wavetable_type\": %d,\n", s->wavetable_type);
-    fprintf(f, "    \"wt_position\": %.4f\n", s->wt_position);
-    fprintf(f, "  },\n");
-
-    // Arpeggiator section
-    fprintf(f, "  \"arpeggiator\": {\n");
-    fprintf(f, "    \"enabled\": %d,\n", arp->enabled);
-    fprintf(f, "    \"pattern\": %d,\n", arp->pattern);
-    fprintf(f, "    \"division\": %d,\n", arp->division);
-    fprintf(f, "    \"tempo\": %.4f,\n", arp->tempo);
-    fprintf(f, "    \"octaves\": %d,\n", arp->octaves);
-    fprintf(f, "    \"gate\": %.4f\n", arp->gate);
-    fprintf(f, "  },\n");
-
-    // Filter section
-    fprintf(f, "  \"filter\": {\n");
-    fprintf(f, "    \"type\": %d,\n", s->filter_type);
-    fprintf(f, "    \"cutoff\": %.4f,\n", s->filter_cutoff);
-    fprintf(f, "    \"resonance\": %.4f\n", s->filter_resonance);
-    fprintf(f, "  },\n");
-
-    // Amplitude envelope
-    fprintf(f, "  \"amp_env\": {\n");
-    fprintf(f, "    \"attack\": %.4f,\n", s->attack);
-    fprintf(f, "    \"decay\": %.4f,\n", s->decay);
-    fprintf(f, "    \"sustain\": %.4f,\n", s->sustain);
-    fprintf(f, "    \"release\": %.4f\n", s->release);
-    fprintf(f, "  },\n");
-
-    // Filter envelope
-    fprintf(f, "  \"filter_env\": {\n");
-    fprintf(f, "    \"attack\": %.4f,\n", s->filter_env_attack);
-    fprintf(f, "    \"decay\": %.4f,\n", s->filter_env_decay);
-    fprintf(f, "    \"sustain\": %.4f,\n", s->filter_env_sustain);
-    fprintf(f, "    \"release\": %.4f,\n", s->filter_env_release);
-    fprintf(f, "    \"amount\": %.4f\n", s->filter_env_amount);
-    fprintf(f, "  },\n");
-
-    // LFO
-    fprintf(f, "  \"lfo\": {\n");
-    fprintf(f, "    \"type\": %d,\n", s->lfo_type);
-    fprintf(f, "    \"rate\": %.4f,\n", s->lfo_rate);
-    fprintf(f, "    \"depth\": %.4f\n", s->lfo_depth);
-    fprintf(f, "  },\n");
-
-    // Effects
-    fprintf(f, "  \"effects\": {\n");
-    fprintf(f, "    \"delay_time\": %.4f,\n", fx->delay.time);
-    fprintf(f, "    \"delay_feedback\": %.4f,\n", fx->delay.feedback);
-    fprintf(f, "    \"delay_mix\": %.4f,\n", fx->delay.mix);
-    fprintf(f, "    \"reverb_mix\": %.4f,\n", fx->reverb.mix);
-    fprintf(f, "    \"reverb_size\": %.4f,\n", fx->reverb.roomsize);
-    fprintf(f, "    \"dist_drive\": %.4f,\n", fx->distortion.drive);
-    fprintf(f, "    \"dist_mix\": %.4f\n", fx->distortion.mix);
-    fprintf(f, "  },\n");
-
-    // Master
-    fprintf(f, "  \"volume\": %.4f\n", s->volume);
-
-    fprintf(f, "}\n");
+
+    // Parameters in registry order; a change of section opens a new object
+    const char *section = NULL;
+    for (int i = 0; i < PARAM_COUNT; i++) {
+        const ParamDesc *d = param_desc((ParamId)i);
+        const char *indent = d->section[0] ? "    " : "  ";
+
+        if (!section || strcmp(section, d->section) != 0) {
+            if (section && section[0]) fprintf(f, "\n  }");
+            fprintf(f, ",\n");
+            if (d->section[0]) fprintf(f, "  \"%s\": {\n", d->section);
+            section = d->section;
+        } else {
+            fprintf(f, ",\n");
+        }
+
+        if (d->type == PARAM_INT) {
+            fprintf(f, "%s\"%s\": %d", indent, d->key, (int)p->values[i]);
+        } else {
+            fprintf(f, "%s\"%s\": %.4f", indent, d->key, p->values[i]);
+        }
+    }
+    if (section && section[0]) fprintf(f, "\n  }");
+
+    // Controller assignments
+    if (map) {
+        char key[32], value[96];
+        int iter = 0;
+        int count = 0;
+        fprintf(f, ",\n  \"midi_map\": {");
+        while (midimap_next(map, &iter, key, sizeof(key), value, sizeof(value))) {
+            fprintf(f, "%s\n    \"%s\": \"%s\"", count++ ? "," : "", key, value);
+        }
+        fprintf(f, "\n  }");
+    }
+
+    fprintf(f, "\n}\n");
 
     fclose(f);
     return 0;
 }
 
-// Simple JSON parser helpers
-static int skip_whitespace(FILE *f) {
-    int c;
-    while ((c = fgetc(f)) != EOF && isspace(c));
-    return c;
+int preset_save(const char *filepath, const char *name, Synth *s, Effects *fx, Arpeggiator *arp,
+                const MidiMap *map) {
+    Patch patch;
+    patch_capture(&patch, s, fx, arp);
+    return preset_write(filepath, name, &patch, map);
 }
 
-static int read_string(FILE *f, char *buf, int buf_size) {
-    int i = 0;
-    int c;
-    while ((c = fgetc(f)) != EOF && c != '"' && i < buf_size - 1) {
-        if (c == '\\') {
-            c = fgetc(f);
-            if (c == EOF) break;
-        }
-        buf[i++] = c;
+//------------------------------------------------------------------------------
+// Preset reader: the whole file is read in one go and tokenized in place.
+// Tokens point into the file buffer (no copies); keys are resolved through the
+// parameter hash table and values collected into a Patch.
+//------------------------------------------------------------------------------
+
+typedef enum {
+    TOK_EOF,
+    TOK_LBRACE,
+    TOK_RBRACE,
+    TOK_COLON,
+    TOK_COMMA,
+    TOK_STRING,
+    TOK_NUMBER,
+    TOK_ERROR
+} TokenType;
+
+typedef struct {
+    TokenType type;
+    const char *start;  // For strings: first char after the opening quote
+    int len;
+} Token;
+
+typedef struct {
+    const char *p;
+    const char *end;
+} Lexer;
+
+// Read an entire file into a NUL-terminated buffer (caller frees)
+static char *read_file(const char *filepath, long *size_out) {
+    FILE *f = fopen(filepath, "rb");
+    if (!f) return NULL;
+
+    if (fseek(f, 0, SEEK_END) != 0) {
+        fclose(f);
+        return NULL;
+    }
+    long size = ftell(f);
+    rewind(f);
+    if (size < 0) {
+        fclose(f);
+        return NULL;
     }
-    buf[i] = '\0';
-    return (c == '"') ? 0 : -1;
+
+    char *buf = malloc(size + 1);
+    if (!buf) {
+        fclose(f);
+        return NULL;
+    }
+
+    size_t got = fread(buf, 1, size, f);
+    fclose(f);
+    buf[got] = '\0';
+    *size_out = (long)got;
+    return buf;
 }
 
-static float read_number(FILE *f) {
-    float val = 0;
-    fscanf(f, "%f", &val);
-    return val;
+static Token next_token(Lexer *lx) {
+    Token t = {TOK_EOF, lx->p, 0};
+
+    while (lx->p < lx->end && isspace((unsigned char)*lx->p)) lx->p++;
+    if (lx->p >= lx->end) return t;
+
+    const char *p = lx->p;
+    t.start = p;
+    t.len = 1;
+
+    switch (*p) {
+        case '{': t.type = TOK_LBRACE; lx->p++; return t;
+        case '}': t.type = TOK_RBRACE; lx->p++; return t;
+        case ':': t.type = TOK_COLON;  lx->p++; return t;
+        case ',': t.type = TOK_COMMA;  lx->p++; return t;
+        case '"': {
+            const char *q = p + 1;
+            while (q < lx->end && *q != '"') {
+                if (*q == '\\' && q + 1 < lx->end) q++;  // Skip escaped char
+                q++;
+            }
+            if (q >= lx->end) {
+                t.type = TOK_ERROR;
+                lx->p = lx->end;
+                return t;
+            }
+            t.type = TOK_STRING;
+            t.start = p + 1;
+            t.len = (int)(q - (p + 1));
+            lx->p = q + 1;
+            return t;
+        }
+        default: {
+            // Number (or bare literal) - runs until a delimiter
+            const char *q = p;
+            while (q < lx->end && !isspace((unsigned char)*q) &&
+                   *q != ',' && *q != '}' && *q != ':') {
+                q++;
+            }
+            t.type = TOK_NUMBER;
+            t.len = (int)(q - p);
+            lx->p = q;
+            return t;
+        }
+    }
 }
 
-static int read_int(FILE *f) {
-    int val = 0;
-    fscanf(f, "%d", &val);
-    return val;
+// Copy a string token into buf, removing escapes
+static void copy_string(const Token *t, char *buf, int buf_size) {
+    int n = 0;
+    for (int i = 0; i < t->len && n < buf_size - 1; i++) {
+        char c = t->start[i];
+        if (c == '\\' && i + 1 < t->len) {
+            c = t->start[++i];
+        }
+        buf[n++] = c;
+    }
+    buf[n] = '\0';
 }
 
-int preset_load(const char *filepath, char *name, int name_size, Synth *s, Effects *fx, Arpeggiator *arp) {
-    FILE *f = fopen(filepath, "r");
-    if (!f) return -1;
+static int in_midi_map(const char *section, int section_len) {
+    return section_len == 8 && memcmp(section, "midi_map", 8) == 0;
+}
 
-    char key[64];
-    char section[64] = "";
-    int c;
+int preset_read(const char *filepath, char *name, int name_size, Patch *p) {
+    long size;
+    char *data = read_file(filepath, &size);
+    if (!data) return -1;
 
     if (name && name_size > 0) name[0] = '\0';
 
-    while ((c = skip_whitespace(f)) != EOF) {
-        if (c == '{' || c == ',' || c == '}') continue;
-
-        if (c == '"') {
-            // Read key
-            if (read_string(f, key, sizeof(key)) < 0) break;
-
-            // Skip to colon
-            while ((c = fgetc(f)) != EOF && c != ':');
-            if (c == EOF) break;
-
-            // Get value
-            c = skip_whitespace(f);
-
-            if (c == '{') {
-                // Nested object - set section name
-                strncpy(section, key, sizeof(section) - 1);
-                continue;
-            } else if (c == '"') {
-                // String value
-                char strval[64];
-                read_string(f, strval, sizeof(strval));
-                if (strcmp(key, "name") == 0 && name) {
-                    strncpy(name, strval, name_size - 1);
-                    name[name_size - 1] = '\0';
-                }
-            } else {
-                // Number value
-                ungetc(c, f);
-                float val = read_number(f);
-
-                // Apply based on section and key
-                if (strcmp(section, "oscillator") == 0) {
-                    if (strcmp(key, "wave1") == 0) synth_set_wave_type(s, (WaveType)(int)val);
-                    else if (strcmp(key, "wave2") == 0) synth_set_wave_type2(s, (WaveType)(int)val);
-                    else if (strcmp(key, "mix") == 0) synth_set_osc_mix(s, val);
-                    else if (strcmp(key, "detune") == 0) synth_set_osc2_detune(s, val);
-                    else if (strcmp(key, "sub_mix") == 0) synth_set_sub_osc_mix(s, val);
-                    else if (strcmp(key, "pulse_width") == 0) synth_set_pulse_width(s, val);
-                    else if (strcmp(key, "pwm_rate") == 0) synth_set_pwm_rate(s, val);
-                    else if (strcmp(key, "pwm_depth") == 0) synth_set_pwm_depth(s, val);
-                    else if (strcmp(key, "unison_count") == 0) synth_set_unison_count(s, (int)val);
-                    else if (strcmp(key, "unison_spread") == 0) synth_set_unison_spread(s, val);
-                    else if (strcmp(key, "wavetable_type") == 0) synth_set_wavetable(s, (WavetableType)(int)val);
-                    else if (strcmp(key, "wt_position") == 0) synth_set_wt_position(s, val);
-                } else if (strcmp(section, "filter") == 0) {
-                    if (strcmp(key, "type") == 0) s->filter_type = (FilterType)(int)val;
-                    else if (strcmp(key, "cutoff") == 0) s->filter_cutoff = val;
-                    else if (strcmp(key, "resonance") == 0) s->filter_resonance = val;
-                    synth_set_filter(s, s->filter_cutoff, s->filter_resonance, s->filter_type);
-                } else if (strcmp(section, "amp_env") == 0) {
-                    if (strcmp(key, "attack") == 0) s->attack = val;
-                    else if (strcmp(key, "decay") == 0) s->decay = val;
-                    else if (strcmp(key, "sustain") == 0) s->sustain = val;
-                    else if (strcmp(key, "release") == 0) s->release = val;
-                    synth_set_adsr(s, s->attack, s->decay, s->sustain, s->release);
-                } else if (strcmp(section, "filter_env") == 0) {
-                    if (strcmp(key, "attack") == 0) s->filter_env_attack = val;
-                    else if (strcmp(key, "decay") == 0) s->filter_env_decay = val;
-                    else if (strcmp(key, "sustain") == 0) s->filter_env_sustain = val;
-                    else if (strcmp(key, "release") == 0) s->filter_env_release = val;
-                    else if (strcmp(key, "amount") == 0) synth_set_filter_env_amount(s, val);
-                    synth_set_filter_env_adsr(s, s->filter_env_attack, s->filter_env_decay,
-                                              s->filter_env_sustain, s->filter_env_release);
-                } else if (strcmp(section, "lfo") == 0) {
-                    if (strcmp(key, "type") == 0) synth_set_lfo_type(s, (LFOWaveType)(int)val);
-                    else if (strcmp(key, "rate") == 0) synth_set_lfo_rate(s, val);
-                    else if (strcmp(key, "depth") == 0) synth_set_lfo_depth(s, val);
-                } else if (strcmp(section, "arpeggiator") == 0) {
-                    if (strcmp(key, "enabled") == 0) arp->enabled = (int)val;
-                    else if (strcmp(key, "pattern") == 0) arp->pattern = (ArpPattern)(int)val;
-                    else if (strcmp(key, "division") == 0) arp->division = (ArpDivision)(int)val;
-                    else if (strcmp(key, "tempo") == 0) arp->tempo = val;
-                    else if (strcmp(key, "octaves") == 0) arp->octaves = (int)val;
-                    else if (strcmp(key, "gate") == 0) arp->gate = val;
-                } else if (strcmp(section, "effects") == 0) {
-                    if (strcmp(key, "delay_time") == 0) fx->delay.time = val;
-                    else if (strcmp(key, "delay_feedback") == 0) fx->delay.feedback = val;
-                    else if (strcmp(key, "delay_mix") == 0) fx->delay.mix = val;
-                    else if (strcmp(key, "reverb_mix") == 0) fx->reverb.mix = val;
-                    else if (strcmp(key, "reverb_size") == 0) fx->reverb.roomsize = val;
-                    else if (strcmp(key, "dist_drive") == 0) fx->distortion.drive = val;
-                    else if (strcmp(key, "dist_mix") == 0) fx->distortion.mix = val;
-                } else if (strcmp(key, "volume") == 0) {
-                    synth_set_volume(s, val);
-                }
+    Lexer lx = {data, data + size};
+    const char *section = "";
+    int section_len = 0;
+    int depth = 0;
+    int result = 0;
+
+    for (;;) {
+        Token t = next_token(&lx);
+        if (t.type == TOK_EOF) break;
+        if (t.type == TOK_ERROR) {
+            result = -1;
+            break;
+        }
+
+        if (t.type == TOK_LBRACE) {
+            depth++;
+            continue;
+        }
+        if (t.type == TOK_RBRACE) {
+            depth--;
+            // Leaving a section returns to the top level
+            if (depth <= 1) {
+                section = "";
+                section_len = 0;
+            }
+            continue;
+        }
+        if (t.type != TOK_STRING) continue;
+
+        // Key, then colon, then value
+        Token key = t;
+        if (next_token(&lx).type != TOK_COLON) continue;
+        Token val = next_token(&lx);
+
+        if (val.type == TOK_LBRACE) {
+            // Nested object - becomes the current section
+            depth++;
+            section = key.start;
+            section_len = key.len;
+            if (in_midi_map(section, section_len)) {
+                p->map.count = 0;   // The preset's assignments replace the base's
+            }
+        } else if (val.type == TOK_STRING) {
+            if (section_len == 0 && key.len == 4 && memcmp(key.start, "name", 4) == 0 && name) {
+                copy_string(&val, name, name_size);
+            } else if (in_midi_map(section, section_len)) {
+                char key_buf[32], val_buf[96];
+                copy_string(&key, key_buf, sizeof(key_buf));
+                copy_string(&val, val_buf, sizeof(val_buf));
+                midimap_list_parse(&p->map, key_buf, val_buf);
+            }
+        } else if (val.type == TOK_NUMBER) {
+            int id = param_find(section, section_len, key.start, key.len);
+            if (id >= 0) {
+                // strtof stops at the delimiter that ends the token
+                p->values[id] = strtof(val.start, NULL);
             }
         }
     }
 
-    fclose(f);
-    return 0;
+    free(data);
+    return result;
 }
 
-int preset_get_name(int slot, char *name, int name_size) {
-    char path[64];
-    preset_filename(slot, path, sizeof(path));
-
-    FILE *f = fopen(path, "r");
-    if (!f) return -1;
-
-    char key[64];
-    int c;
-
-    name[0] = '\0';
-
-    // Simple parse just to find "name" field
-    while ((c = skip_whitespace(f)) != EOF) {
-        if (c == '"') {
-            if (read_string(f, key, sizeof(key)) < 0) break;
+int preset_load(const char *filepath, char *name, int name_size, Synth *s, Effects *fx, Arpeggiator *arp) {
+    // Keys missing from the file take their defaults, as in the bank
+    Patch patch = *patch_defaults();
 
-            while ((c = fgetc(f)) != EOF && c != ':');
-            if (c == EOF) break;
+    if (preset_read(filepath, name, name_size, &patch) < 0) return -1;
 
-            c = skip_whitespace(f);
+    patch_apply(&patch, s, fx, arp);
+    return 0;
+}
 
-            if (strcmp(key, "name") == 0 && c == '"') {
-                read_string(f, name, name_size);
-                fclose(f);
-                return 0;
+int preset_read_string(const char *filepath, const char *key, char *value, int value_size) {
+    long size;
+    char *data = read_file(filepath, &size);
+    if (!data) return -1;
+
+    value[0] = '\0';
+
+    // Only top-level keys are of interest
+    int key_len = (int)strlen(key);
+    Lexer lx = {data, data + size};
+    int depth = 0;
+    int result = -1;
+    for (;;) {
+        Token t = next_token(&lx);
+        if (t.type == TOK_EOF || t.type == TOK_ERROR) break;
+        if (t.type == TOK_LBRACE) depth++;
+        else if (t.type == TOK_RBRACE) depth--;
+        else if (t.type == TOK_STRING && depth == 1 &&
+                 t.len == key_len && memcmp(t.start, key, key_len) == 0) {
+            if (next_token(&lx).type != TOK_COLON) continue;
+            Token val = next_token(&lx);
+            if (val.type == TOK_STRING) {
+                copy_string(&val, value, value_size);
+                result = 0;
             }
+            break;
         }
     }
 
-    fclose(f);
-    return -1;
+    free(data);
+    return result;
+}
+
+int preset_get_name(int slot, char *name, int name_size) {
+    char path[64];
+    preset_filename(slot, path, sizeof(path));
+    return preset_read_string(path, "name", name, name_size);
 }
@@ -4,15 +4,27 @@
 #include "synth.h"
 #include "effects.h"
 #include "arp.h"
+#include "patch.h"
+#include "midimap.h"
 
 #define PRESET_DIR "presets"
 #define MAX_PRESETS 99
 #define PRESET_NAME_LEN 32
 
-// Save preset to JSON file (returns 0 on success)
-int preset_save(const char *filepath, const char *name, Synth *s, Effects *fx, Arpeggiator *arp);
+// Write a patch (and MIDI mapping, if map is not NULL) to a JSON file (returns 0 on success)
+int preset_write(const char *filepath, const char *name, const Patch *p, const MidiMap *map);
 
-// Load preset from JSON file (returns 0 on success)
+// Save current engine settings to a JSON file (returns 0 on success)
+int preset_save(const char *filepath, const char *name, Synth *s, Effects *fx, Arpeggiator *arp,
+                const MidiMap *map);
+
+// Parse preset file into a patch without touching the engine (returns 0 on success)
+// Only keys present in the file are written; other values in *p are kept.
+// A "midi_map" section replaces p->map (mappings that do not parse are skipped).
+int preset_read(const char *filepath, char *name, int name_size, Patch *p);
+
+// Load preset from JSON file (returns 0 on success). Keys missing from the
+// file take their defaults (see patch_defaults).
 int preset_load(const char *filepath, char *name, int name_size, Synth *s, Effects *fx, Arpeggiator *arp);
 
 // Generate preset filename (e.g., "presets/001.json")
@@ -24,4 +36,7 @@ int preset_exists(int slot);
 // Get preset name without loading full preset (returns 0 on success)
 int preset_get_name(int slot, char *name, int name_size);
 
+// Read a top-level string field such as "name" or "tags" (returns 0 on success)
+int preset_read_string(const char *filepath, const char *key, char *value, int value_size);
+
 #endif // PRESET_H
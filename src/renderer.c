@@ -0,0 +1,116 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "renderer.h"
+#include "arena.h"
+#include "rtcheck.h"
+#include "trace.h"
+#include <string.h>
+#include <sched.h>
+
+#define MASK (RENDERER_RING - 1)
+
+static int clamp_depth(int depth) {
+    if (depth < RENDERER_BLOCK) depth = RENDERER_BLOCK;
+    if (depth > RENDERER_RING - RENDERER_BLOCK) depth = RENDERER_RING - RENDERER_BLOCK;
+    return depth;
+}
+
+// Top the ring up to the depth, one block at a time
+static void fill(Renderer *r) {
+    unsigned int write = r->write_pos;
+    for (;;) {
+        unsigned int read = __atomic_load_n(&r->read_pos, __ATOMIC_ACQUIRE);
+        int depth = __atomic_load_n(&r->depth, __ATOMIC_RELAXED);
+        if ((int)(write - read) + RENDERER_BLOCK > depth) break;
+
+        // Blocks never straddle the wrap (the ring is a whole number of them)
+        engine_render(r->engine, &r->ring[(write & MASK) * 2], RENDERER_BLOCK);
+        write += RENDERER_BLOCK;
+        __atomic_store_n(&r->write_pos, write, __ATOMIC_RELEASE);
+    }
+
+    Telemetry *t = r->engine->telemetry;
+    if (t) {
+        unsigned int read = __atomic_load_n(&r->read_pos, __ATOMIC_ACQUIRE);
+        __atomic_store_n(&t->ring_depth, __atomic_load_n(&r->depth, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+        __atomic_store_n(&t->ring_frames, (int32_t)(write - read), __ATOMIC_RELAXED);
+        __atomic_store_n(&t->underruns, (uint32_t)renderer_underruns(r), __ATOMIC_RELAXED);
+    }
+}
+
+static void *render_thread(void *arg) {
+    Renderer *r = (Renderer *)arg;
+    TRACE_THREAD("render");
+    while (__atomic_load_n(&r->running, __ATOMIC_ACQUIRE)) {
+        fill(r);
+        sem_wait(&r->wake);
+    }
+    return NULL;
+}
+
+int renderer_start(Renderer *r, Engine *e, int depth) {
+    memset(r, 0, sizeof(Renderer));
+    r->engine = e;
+    r->depth = clamp_depth(depth);
+    if (sem_init(&r->wake, 0, 0) != 0) return -1;
+
+    // The audio callback reads the ring; keep it resident (best effort)
+    arena_lock_region(r, sizeof(Renderer));
+
+    r->running = 1;
+    if (pthread_create(&r->thread, NULL, render_thread, r) != 0) {
+        r->running = 0;
+        sem_destroy(&r->wake);
+        return -1;
+    }
+
+    // The render thread now has the audio deadline, so give it audio priority
+    // when allowed (the part workers it wakes run at the same level)
+    struct sched_param sp;
+    sp.sched_priority = sched_get_priority_min(SCHED_FIFO) + 1;
+    pthread_setschedparam(r->thread, SCHED_FIFO, &sp);
+    return 0;
+}
+
+void renderer_stop(Renderer *r) {
+    if (!r->running) return;
+
+    __atomic_store_n(&r->running, 0, __ATOMIC_RELEASE);
+    sem_post(&r->wake);
+    pthread_join(r->thread, NULL);
+    sem_destroy(&r->wake);
+}
+
+void renderer_set_depth(Renderer *r, int depth) {
+    __atomic_store_n(&r->depth, clamp_depth(depth), __ATOMIC_RELAXED);
+    sem_post(&r->wake);
+}
+
+void renderer_read(Renderer *r, float *out, int frames) {
+    rtcheck_enter();
+    TRACE_THREAD("audio callback");
+    TRACE_BEGIN("callback");
+    unsigned int read = r->read_pos;
+    unsigned int write = __atomic_load_n(&r->write_pos, __ATOMIC_ACQUIRE);
+    int ready = (int)(write - read);
+    int n = (ready < frames) ? ready : frames;
+
+    for (int i = 0; i < n; i++) {
+        unsigned int j = (read + i) & MASK;
+        out[i * 2] = r->ring[j * 2];
+        out[i * 2 + 1] = r->ring[j * 2 + 1];
+    }
+    if (n < frames) {
+        memset(out + n * 2, 0, (frames - n) * 2 * sizeof(float));
+        __atomic_add_fetch(&r->underruns, 1, __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&r->read_pos, read + n, __ATOMIC_RELEASE);
+    sem_post(&r->wake);
+    TRACE_END("callback");
+    rtcheck_leave();
+}
+
+unsigned long renderer_underruns(const Renderer *r) {
+    return __atomic_load_n(&r->underruns, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,46 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include "engine.h"
+#include <pthread.h>
+#include <semaphore.h>
+
+// Render thread between the engine and the audio device.
+// The engine renders in fixed RENDERER_BLOCK frames, whatever the device
+// period, into a ring kept `depth` frames ahead of playback. The audio
+// callback only copies out of the ring, so the depth (the buffer size on the
+// SET page) can change while playing without touching the stream, and a
+// callback that finds the ring short is counted as an underrun.
+
+#define RENDERER_BLOCK 64       // Frames per engine_render call
+#define RENDERER_RING  4096     // Ring capacity in frames (power of two)
+
+typedef struct {
+    Engine *engine;
+    pthread_t thread;
+    sem_t wake;                 // Posted by the reader after each copy
+    int running;
+
+    float ring[RENDERER_RING * 2];  // Interleaved stereo
+    unsigned int write_pos;     // Frames rendered (render thread)
+    unsigned int read_pos;      // Frames played (audio callback)
+    int depth;                  // Frames to keep rendered ahead
+    unsigned long underruns;    // Callbacks the ring could not fill
+} Renderer;
+
+// Start rendering `depth` frames ahead. Returns 0, or -1 if the thread
+// could not be started.
+int renderer_start(Renderer *r, Engine *e, int depth);
+void renderer_stop(Renderer *r);
+
+// Change how far ahead the engine renders (any thread). A deeper ring fills
+// while playing; a shallower one drains.
+void renderer_set_depth(Renderer *r, int depth);
+
+// Copy the next frames of interleaved stereo out (audio callback, never
+// blocks). Frames the ring does not hold yet are zero-filled.
+void renderer_read(Renderer *r, float *out, int frames);
+
+unsigned long renderer_underruns(const Renderer *r);
+
+#endif // RENDERER_H
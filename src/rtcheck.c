@@ -0,0 +1,303 @@
+#define _GNU_SOURCE
+
+#include "rtcheck.h"
+
+#ifndef RT_CHECK
+
+unsigned long rtcheck_violations(void) {
+    return 0;
+}
+
+void rtcheck_report(FILE *f) {
+    fprintf(f, "real-time checks not built in (make rtcheck)\n");
+}
+
+#else
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// glibc's own allocator entry points, so the wrappers need no dlsym
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *p, size_t size);
+extern void __libc_free(void *p);
+
+typedef struct {
+    const char *call;
+    void *stack[RTCHECK_DEPTH];
+    int frames;
+    int ready;                  // Filled in (set last, release)
+} Violation;
+
+static Violation violations[RTCHECK_LOG];
+static unsigned long violation_count;
+
+static __thread int rt_depth;   // Nesting of rtcheck_enter on this thread
+static __thread int trapping;   // Inside trap (backtrace may allocate)
+
+static pthread_once_t prime_once = PTHREAD_ONCE_INIT;
+
+// The first backtrace loads the unwinder, which allocates; do it unmarked
+static void prime(void) {
+    void *stack[2];
+    backtrace(stack, 2);
+}
+
+void rtcheck_enter(void) {
+    pthread_once(&prime_once, prime);
+    rt_depth++;
+}
+
+void rtcheck_leave(void) {
+    rt_depth--;
+}
+
+static void trap(const char *call) {
+    if (rt_depth == 0 || trapping) return;
+    trapping = 1;
+    unsigned long n = __atomic_fetch_add(&violation_count, 1, __ATOMIC_RELAXED);
+    if (n < RTCHECK_LOG) {
+        Violation *v = &violations[n];
+        v->call = call;
+        v->frames = backtrace(v->stack, RTCHECK_DEPTH);
+        __atomic_store_n(&v->ready, 1, __ATOMIC_RELEASE);
+    }
+    trapping = 0;
+}
+
+void rtcheck_violation(const char *what) {
+    trap(what);
+}
+
+unsigned long rtcheck_violations(void) {
+    return __atomic_load_n(&violation_count, __ATOMIC_RELAXED);
+}
+
+void rtcheck_report(FILE *f) {
+    unsigned long count = rtcheck_violations();
+    fprintf(f, "%lu real-time violation%s\n", count, count == 1 ? "" : "s");
+    for (unsigned long i = 0; i < count && i < RTCHECK_LOG; i++) {
+        Violation *v = &violations[i];
+        if (!__atomic_load_n(&v->ready, __ATOMIC_ACQUIRE)) continue;
+        fprintf(f, "#%lu: %s on a real-time thread\n", i + 1, v->call);
+        fflush(f);
+        backtrace_symbols_fd(v->stack, v->frames, fileno(f));
+    }
+}
+
+//------------------------------------------------------------------------------
+// Interposed calls: trap, then do the real thing
+//------------------------------------------------------------------------------
+
+#define NEXT(name) static __typeof__(name) *next_##name; \
+    if (!next_##name) next_##name = (__typeof__(name) *)dlsym(RTLD_NEXT, #name)
+
+void *malloc(size_t size) {
+    trap("malloc");
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    trap("calloc");
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, size_t size) {
+    trap("realloc");
+    return __libc_realloc(p, size);
+}
+
+void free(void *p) {
+    if (p) trap("free");
+    __libc_free(p);
+}
+
+int pthread_mutex_lock(pthread_mutex_t *mutex) {
+    trap("pthread_mutex_lock");
+    NEXT(pthread_mutex_lock);
+    return next_pthread_mutex_lock(mutex);
+}
+
+int open(const char *path, int flags, ...) {
+    trap("open");
+    NEXT(open);
+    va_list ap;
+    va_start(ap, flags);
+    int mode = (flags & O_CREAT) ? va_arg(ap, int) : 0;
+    va_end(ap);
+    return next_open(path, flags, mode);
+}
+
+FILE *fopen(const char *path, const char *mode) {
+    trap("fopen");
+    NEXT(fopen);
+    return next_fopen(path, mode);
+}
+
+int close(int fd) {
+    trap("close");
+    NEXT(close);
+    return next_close(fd);
+}
+
+#if __GLIBC_PREREQ(2, 33)
+int stat(const char *path, struct stat *st) {
+    trap("stat");
+    NEXT(stat);
+    return next_stat(path, st);
+}
+
+int fstat(int fd, struct stat *st) {
+    trap("fstat");
+    NEXT(fstat);
+    return next_fstat(fd, st);
+}
+#else
+// Older glibc inlines stat and fstat into these
+int __xstat(int ver, const char *path, struct stat *st) {
+    trap("stat");
+    NEXT(__xstat);
+    return next___xstat(ver, path, st);
+}
+
+int __fxstat(int ver, int fd, struct stat *st) {
+    trap("fstat");
+    NEXT(__fxstat);
+    return next___fxstat(ver, fd, st);
+}
+#endif
+
+ssize_t read(int fd, void *buf, size_t count) {
+    trap("read");
+    NEXT(read);
+    return next_read(fd, buf, count);
+}
+
+ssize_t write(int fd, const void *buf, size_t count) {
+    trap("write");
+    NEXT(write);
+    return next_write(fd, buf, count);
+}
+
+size_t fread(void *data, size_t size, size_t count, FILE *f) {
+    trap("fread");
+    NEXT(fread);
+    return next_fread(data, size, count, f);
+}
+
+size_t fwrite(const void *data, size_t size, size_t count, FILE *f) {
+    trap("fwrite");
+    NEXT(fwrite);
+    return next_fwrite(data, size, count, f);
+}
+
+// The variadic wrappers go to the real v* calls so one call traps once
+int printf(const char *format, ...) {
+    trap("printf");
+    NEXT(vprintf);
+    va_list ap;
+    va_start(ap, format);
+    int n = next_vprintf(format, ap);
+    va_end(ap);
+    return n;
+}
+
+int fprintf(FILE *f, const char *format, ...) {
+    trap("fprintf");
+    NEXT(vfprintf);
+    va_list ap;
+    va_start(ap, format);
+    int n = next_vfprintf(f, format, ap);
+    va_end(ap);
+    return n;
+}
+
+int vprintf(const char *format, va_list ap) {
+    trap("vprintf");
+    NEXT(vprintf);
+    return next_vprintf(format, ap);
+}
+
+int vfprintf(FILE *f, const char *format, va_list ap) {
+    trap("vfprintf");
+    NEXT(vfprintf);
+    return next_vfprintf(f, format, ap);
+}
+
+int puts(const char *s) {
+    trap("puts");
+    NEXT(puts);
+    return next_puts(s);
+}
+
+int fputs(const char *s, FILE *f) {
+    trap("fputs");
+    NEXT(fputs);
+    return next_fputs(s, f);
+}
+
+int putchar(int c) {
+    trap("putchar");
+    NEXT(putchar);
+    return next_putchar(c);
+}
+
+int fputc(int c, FILE *f) {
+    trap("fputc");
+    NEXT(fputc);
+    return next_fputc(c, f);
+}
+
+// putchar is inlined into this when optimising
+int putc(int c, FILE *f) {
+    trap("putc");
+    NEXT(putc);
+    return next_putc(c, f);
+}
+
+int nanosleep(const struct timespec *request, struct timespec *remaining) {
+    trap("nanosleep");
+    NEXT(nanosleep);
+    return next_nanosleep(request, remaining);
+}
+
+int usleep(useconds_t usec) {
+    trap("usleep");
+    NEXT(usleep);
+    return next_usleep(usec);
+}
+
+int socket(int domain, int type, int protocol) {
+    trap("socket");
+    NEXT(socket);
+    return next_socket(domain, type, protocol);
+}
+
+int connect(int fd, const struct sockaddr *addr, socklen_t len) {
+    trap("connect");
+    NEXT(connect);
+    return next_connect(fd, addr, len);
+}
+
+ssize_t send(int fd, const void *buf, size_t len, int flags) {
+    trap("send");
+    NEXT(send);
+    return next_send(fd, buf, len, flags);
+}
+
+ssize_t recv(int fd, void *buf, size_t len, int flags) {
+    trap("recv");
+    NEXT(recv);
+    return next_recv(fd, buf, len, flags);
+}
+
+#endif // RT_CHECK
@@ -0,0 +1,40 @@
+#ifndef RTCHECK_H
+#define RTCHECK_H
+
+#include <stdio.h>
+
+// Real-time safety checker (debug builds with -DRT_CHECK, see make rtcheck).
+// Code that must never block marks itself with rtcheck_enter/rtcheck_leave:
+// the audio callback, the engine's render (including taking its lock) and
+// the part workers. While a thread is marked, these calls are trapped:
+//   memory   malloc calloc realloc free
+//   locks    pthread_mutex_lock
+//   files    open fopen close stat fstat read write fread fwrite
+//   output   printf fprintf vprintf vfprintf puts fputs putchar fputc putc
+//   sleeps   nanosleep usleep
+//   sockets  socket connect send recv
+// The call still goes ahead, but a backtrace goes into a lock-free log that
+// rtcheck_report prints later from an ordinary thread. Other calls are not
+// checked. Marked code that has to wait anyway (a try-lock that failed) logs
+// it with rtcheck_violation. In normal builds the marks compile to nothing.
+
+#define RTCHECK_LOG   64        // Violations kept with their backtraces
+#define RTCHECK_DEPTH 16        // Frames per backtrace
+
+#ifdef RT_CHECK
+void rtcheck_enter(void);
+void rtcheck_leave(void);
+void rtcheck_violation(const char *what);
+#else
+#define rtcheck_enter() ((void)0)
+#define rtcheck_leave() ((void)0)
+#define rtcheck_violation(what) ((void)0)
+#endif
+
+// Violations trapped so far (always 0 without RT_CHECK)
+unsigned long rtcheck_violations(void);
+
+// Print the logged violations with symbolised backtraces (not real-time)
+void rtcheck_report(FILE *f);
+
+#endif // RTCHECK_H
@@ -0,0 +1,32 @@
+#include "scope.h"
+#include <string.h>
+
+void scope_init(ScopeRing *r) {
+    memset(r->data, 0, sizeof(r->data));
+    r->written = 0;
+}
+
+void scope_write(ScopeRing *r, const float *samples, int frames, int stride) {
+    unsigned int pos = r->written;  // Only this thread writes it
+    for (int i = 0; i < frames; i++) {
+        r->data[(pos + i) & (SCOPE_RING_SIZE - 1)] = samples[i * stride];
+    }
+    __atomic_store_n(&r->written, pos + frames, __ATOMIC_RELEASE);
+}
+
+int scope_read(const ScopeRing *r, float *out, int count) {
+    if (count <= 0 || count > SCOPE_RING_SIZE / 2) return 0;
+
+    unsigned int end = __atomic_load_n(&r->written, __ATOMIC_ACQUIRE);
+    if (end < (unsigned int)count) return 0;
+
+    unsigned int start = end - count;
+    for (int i = 0; i < count; i++) {
+        out[i] = r->data[(start + i) & (SCOPE_RING_SIZE - 1)];
+    }
+
+    // The copy is good unless the writer has since reached its oldest sample
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    unsigned int now = __atomic_load_n(&r->written, __ATOMIC_RELAXED);
+    return (now - start <= SCOPE_RING_SIZE) ? count : 0;
+}
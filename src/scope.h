@@ -0,0 +1,27 @@
+#ifndef SCOPE_H
+#define SCOPE_H
+
+// Output tap for the oscilloscope and spectrum display.
+// A single-writer ring: the audio thread appends each finished block with
+// one copy and a release store of the write count; readers copy out the
+// newest samples without a lock and detect when the writer lapped them.
+
+#define SCOPE_RING_SIZE 8192    // Samples kept (power of two)
+
+typedef struct {
+    float data[SCOPE_RING_SIZE];
+    unsigned int written;       // Total samples written (wraps; accessed atomically)
+} ScopeRing;
+
+void scope_init(ScopeRing *r);
+
+// Append frames from an interleaved buffer, taking every stride-th sample
+// (audio thread)
+void scope_write(ScopeRing *r, const float *samples, int frames, int stride);
+
+// Copy the newest count samples, oldest first (any thread). Returns count, or
+// 0 if nothing has been written yet or the writer overwrote them while
+// copying.
+int scope_read(const ScopeRing *r, float *out, int count);
+
+#endif // SCOPE_H
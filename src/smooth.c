@@ -0,0 +1,30 @@
+#include "smooth.h"
+#include "oscillator.h"  // for sample_rate
+#include <math.h>
+
+float smoother_coeff(float time_ms) {
+    float time_samples = time_ms * 0.001f * sample_rate;
+    if (time_samples < 1.0f) {
+        return 1.0f;
+    }
+    return 1.0f - expf(-(float)CONTROL_BLOCK / time_samples);
+}
+
+void smoother_init(Smoother *sm, float value, float time_ms) {
+    sm->value = value;
+    sm->coeff = smoother_coeff(time_ms);
+}
+
+float smoother_next(Smoother *sm, float target) {
+    float diff = target - sm->value;
+    if (fabsf(diff) < 1e-6f) {
+        sm->value = target;  // Snap to avoid denormals and endless tails
+    } else {
+        sm->value += diff * sm->coeff;
+    }
+    return sm->value;
+}
+
+void smoother_reset(Smoother *sm, float value) {
+    sm->value = value;
+}
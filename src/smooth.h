@@ -0,0 +1,30 @@
+#ifndef SMOOTH_H
+#define SMOOTH_H
+
+// Samples between smoothing/parameter updates in the audio thread
+#define CONTROL_BLOCK 32
+
+// Default smoothing time for continuous parameters
+#define SMOOTH_TIME_MS 20.0f
+
+// One-pole parameter smoother.
+// Control code only writes the target (a plain field in Synth/Effects); the
+// audio thread calls smoother_next once per control block to glide towards it.
+typedef struct {
+    float value;    // Current smoothed value
+    float coeff;    // Fraction of the remaining distance covered per update
+} Smoother;
+
+// time_ms is the time constant; the smoother is advanced every CONTROL_BLOCK samples
+void smoother_init(Smoother *sm, float value, float time_ms);
+
+// Per-update coefficient for a time constant (for smoothing arrays of values)
+float smoother_coeff(float time_ms);
+
+// Advance one control block towards target and return the new value
+float smoother_next(Smoother *sm, float target);
+
+// Jump straight to a value (no glide)
+void smoother_reset(Smoother *sm, float value);
+
+#endif // SMOOTH_H
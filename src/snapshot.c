@@ -0,0 +1,472 @@
+#include "snapshot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Per-part settings kept outside the Synth
+typedef struct {
+    int32_t enabled;
+    int32_t channel;
+    float fx_send;
+    int32_t xfade_length;
+    int32_t xfade_remaining;    // > 0: the outgoing Synth follows
+    char preset_name[PART_NAME_LEN];
+} SnapshotPart;
+
+// Float line chunk: count, encoding, then the data
+#define CHUNK_RAW       0       // count floats
+#define CHUNK_ZERO_RUN  1       // {zeros, literals, float[literals]} until count
+
+static uint32_t fnv1a(const unsigned char *data, size_t size) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        h ^= data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint32_t layout_hash(void) {
+    const uint32_t sizes[] = {
+        sizeof(Synth), sizeof(Voice), sizeof(Arpeggiator), sizeof(SnapshotPart),
+        sizeof(Delay), sizeof(Reverb), sizeof(Distortion), sizeof(MidiMap), sizeof(Limiter),
+        MAX_PARTS, NUM_VOICES, PARAM_COUNT,
+    };
+    return fnv1a((const unsigned char *)sizes, sizeof(sizes));
+}
+
+//------------------------------------------------------------------------------
+// Wavetable pointers
+//
+// Oscillators point at the shared wavetables, whose address differs between
+// processes. Blobs store the table index in the pointer's place.
+//------------------------------------------------------------------------------
+
+static void osc_to_index(Oscillator *o) {
+    uintptr_t index = 0;
+    for (int t = 0; t < WT_COUNT; t++) {
+        if (o->wavetable == wavetable_get((WavetableType)t)) index = (uintptr_t)t;
+    }
+    o->wavetable = (const Wavetable *)index;
+}
+
+static void osc_from_index(Oscillator *o) {
+    o->wavetable = wavetable_get((WavetableType)(uintptr_t)o->wavetable);
+}
+
+static void synth_swizzle(Synth *s, void (*fix)(Oscillator *)) {
+    for (int i = 0; i < NUM_VOICES; i++) {
+        Voice *v = &s->voices[i];
+        fix(&v->osc);
+        fix(&v->osc2);
+        fix(&v->sub_osc);
+        for (int u = 0; u < MAX_UNISON - 1; u++) {
+            fix(&v->unison_oscs[u]);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Writing
+//------------------------------------------------------------------------------
+
+typedef struct {
+    unsigned char *base;
+    size_t pos;
+    size_t size;
+    int ok;
+} Writer;
+
+static void put(Writer *w, const void *data, size_t n) {
+    if (!w->ok || w->size - w->pos < n) {
+        w->ok = 0;
+        return;
+    }
+    memcpy(w->base + w->pos, data, n);
+    w->pos += n;
+}
+
+static void put_u32(Writer *w, uint32_t v) {
+    put(w, &v, sizeof(v));
+}
+
+static void put_synth(Writer *w, const Synth *s) {
+    Synth copy = *s;
+    synth_swizzle(&copy, osc_to_index);
+    put(w, &copy, sizeof(copy));
+}
+
+// Ring region ending just before 'end' (start may wrap)
+static void put_line(Writer *w, const float *line, int line_size, int end, int count, int compress) {
+    put_u32(w, (uint32_t)count);
+    put_u32(w, compress ? CHUNK_ZERO_RUN : CHUNK_RAW);
+    if (!w->ok) return;
+
+    size_t mark = w->pos;
+    int start = end - count;
+    if (start < 0) start += line_size;
+
+    if (compress) {
+        // Zero runs cost nothing; fall back to raw if the encoding grows
+        size_t raw_size = (size_t)count * sizeof(float);
+        int i = 0;
+        while (w->ok && i < count && w->pos - mark < raw_size) {
+            uint32_t zeros = 0, literals = 0;
+            const uint32_t *bits = (const uint32_t *)line;
+            while (i + (int)zeros < count && bits[(start + i + zeros) % line_size] == 0) zeros++;
+            int lit_start = i + (int)zeros;
+            while (lit_start + (int)literals < count &&
+                   bits[(start + lit_start + literals) % line_size] != 0) literals++;
+
+            put_u32(w, zeros);
+            put_u32(w, literals);
+            for (uint32_t k = 0; k < literals; k++) {
+                put(w, &line[(start + lit_start + k) % line_size], sizeof(float));
+            }
+            i = lit_start + (int)literals;
+        }
+        if (!w->ok || i >= count) return;
+
+        // Incompressible: rewrite as raw
+        w->pos = mark;
+        memcpy(w->base + mark - sizeof(uint32_t), &(uint32_t){CHUNK_RAW}, sizeof(uint32_t));
+    }
+
+    for (int i = 0; i < count; i++) {
+        put(w, &line[(start + i) % line_size], sizeof(float));
+    }
+}
+
+// Stereo lines go out as float lines of twice the length
+static void put_stereo_line(Writer *w, const Stereo *line, int line_size, int end, int count,
+                            int compress) {
+    put_line(w, (const float *)line, line_size * 2, end * 2, count * 2, compress);
+}
+
+static int delay_live_samples(const Delay *d) {
+    int samples = (int)(d->time * sample_rate);
+    if (samples >= d->length) samples = d->length - 1;
+    return samples;
+}
+
+static void put_effects(Writer *w, const Effects *fx, int compress) {
+    const Delay *d = &fx->delay;
+    put(w, &d->write_pos, sizeof(d->write_pos));
+    put(w, &d->time, sizeof(d->time));
+    put(w, &d->feedback, sizeof(d->feedback));
+    put(w, &d->mix, sizeof(d->mix));
+    put(w, &d->pingpong, sizeof(d->pingpong));
+    put(w, &d->feedback_smooth, sizeof(d->feedback_smooth));
+    put(w, &d->mix_smooth, sizeof(d->mix_smooth));
+
+    const Reverb *r = &fx->reverb;
+    put(w, &r->mix, sizeof(r->mix));
+    put(w, &r->roomsize, sizeof(r->roomsize));
+    put(w, &r->mix_smooth, sizeof(r->mix_smooth));
+    for (int i = 0; i < NUM_COMB_FILTERS; i++) {
+        put(w, &r->combs[i].size, sizeof(int));
+        put(w, &r->combs[i].spread, sizeof(int));
+        put(w, &r->combs[i].pos, sizeof(int));
+        put(w, &r->combs[i].feedback, sizeof(float));
+    }
+    for (int i = 0; i < NUM_ALLPASS_FILTERS; i++) {
+        put(w, &r->allpasses[i].size, sizeof(int));
+        put(w, &r->allpasses[i].spread, sizeof(int));
+        put(w, &r->allpasses[i].pos, sizeof(int));
+        put(w, &r->allpasses[i].feedback, sizeof(float));
+    }
+
+    put(w, &fx->distortion, sizeof(fx->distortion));
+
+    // Only the part of each line the read positions can still reach
+    put_stereo_line(w, d->buffer, d->length, d->write_pos, delay_live_samples(d), compress);
+    for (int i = 0; i < NUM_COMB_FILTERS; i++) {
+        const CombFilter *c = &r->combs[i];
+        put_stereo_line(w, c->buffer, c->mask + 1, c->pos, c->size + c->spread, compress);
+    }
+    for (int i = 0; i < NUM_ALLPASS_FILTERS; i++) {
+        const AllpassFilter *a = &r->allpasses[i];
+        put_stereo_line(w, a->buffer, a->mask + 1, a->pos, a->size + a->spread, compress);
+    }
+}
+
+size_t snapshot_max_size(const Engine *e) {
+    // Line lengths are fixed when the engine is created
+    size_t lines = 2 * sizeof(uint32_t) * (1 + NUM_COMB_FILTERS + NUM_ALLPASS_FILTERS);
+    lines += effects_memory(e->max_delay);
+    return sizeof(SnapshotHeader) +
+           MAX_PARTS * (sizeof(SnapshotPart) + 2 * sizeof(Synth) + sizeof(Arpeggiator)) +
+           sizeof(Effects) + lines + sizeof(Limiter) + sizeof(MidiMap);
+}
+
+size_t snapshot_capture(Engine *e, void *buf, size_t size, int flags) {
+    Writer w = {(unsigned char *)buf, sizeof(SnapshotHeader), size, size >= sizeof(SnapshotHeader)};
+    int compress = (flags & SNAPSHOT_COMPRESS) != 0;
+
+    engine_lock(e);
+    for (int i = 0; i < MAX_PARTS; i++) {
+        const Part *p = &e->multi.parts[i];
+        SnapshotPart sp;
+        memset(&sp, 0, sizeof(sp));
+        sp.enabled = p->enabled;
+        sp.channel = p->channel;
+        sp.fx_send = p->fx_send;
+        sp.xfade_length = p->xfade.length;
+        sp.xfade_remaining = p->xfade.remaining;
+        memcpy(sp.preset_name, p->preset_name, sizeof(sp.preset_name));
+
+        put(&w, &sp, sizeof(sp));
+        put_synth(&w, &p->synth);
+        put(&w, &p->arp, sizeof(p->arp));
+        if (sp.xfade_remaining > 0) put_synth(&w, &p->xfade.synth);
+    }
+    put_effects(&w, &e->effects, compress);
+    put(&w, &e->limiter, sizeof(e->limiter));
+    put(&w, &e->midimap, sizeof(e->midimap));
+    engine_unlock(e);
+
+    if (!w.ok) return 0;
+
+    SnapshotHeader h;
+    h.magic = SNAPSHOT_MAGIC;
+    h.version = SNAPSHOT_VERSION;
+    h.layout_hash = layout_hash();
+    h.sample_rate = (uint32_t)sample_rate;
+    h.size = (uint32_t)w.pos;
+    h.flags = (uint32_t)flags;
+    h.checksum = fnv1a(w.base + sizeof(h), w.pos - sizeof(h));
+    memcpy(w.base, &h, sizeof(h));
+    return w.pos;
+}
+
+//------------------------------------------------------------------------------
+// Reading
+//
+// A blob is decoded into a staging copy first, so a damaged one leaves the
+// engine untouched; the lock is only held for the final copy.
+//------------------------------------------------------------------------------
+
+typedef struct {
+    const unsigned char *base;
+    size_t pos;
+    size_t size;
+    int ok;
+} Reader;
+
+typedef struct {
+    SnapshotPart part[MAX_PARTS];
+    Synth synth[MAX_PARTS];
+    Arpeggiator arp[MAX_PARTS];
+    Synth xfade[MAX_PARTS];
+    Effects effects;
+    Limiter limiter;
+    MidiMap midimap;
+} Staging;
+
+static void get(Reader *r, void *dst, size_t n) {
+    if (!r->ok || r->size - r->pos < n) {
+        r->ok = 0;
+        return;
+    }
+    memcpy(dst, r->base + r->pos, n);
+    r->pos += n;
+}
+
+static uint32_t get_u32(Reader *r) {
+    uint32_t v = 0;
+    get(r, &v, sizeof(v));
+    return v;
+}
+
+static void get_synth(Reader *r, Synth *s) {
+    get(r, s, sizeof(*s));
+    if (r->ok) synth_swizzle(s, osc_from_index);
+}
+
+// Inverse of put_line (the line must already be cleared)
+static void get_line(Reader *r, float *line, int line_size, int end, int expect) {
+    uint32_t count = get_u32(r);
+    uint32_t encoding = get_u32(r);
+    if (!r->ok || count != (uint32_t)expect || end < 0 || end >= line_size) {
+        r->ok = 0;
+        return;
+    }
+
+    int start = end - (int)count;
+    if (start < 0) start += line_size;
+
+    uint32_t i = 0;
+    while (r->ok && i < count) {
+        uint32_t literals = count;
+        if (encoding == CHUNK_ZERO_RUN) {
+            uint32_t zeros = get_u32(r);
+            literals = get_u32(r);
+            if (zeros > count - i || literals > count - i - zeros) {
+                r->ok = 0;
+                return;
+            }
+            i += zeros;
+        } else if (encoding != CHUNK_RAW) {
+            r->ok = 0;
+            return;
+        }
+        for (uint32_t k = 0; k < literals && r->ok; k++, i++) {
+            get(r, &line[(start + i) % line_size], sizeof(float));
+        }
+    }
+}
+
+static void get_stereo_line(Reader *r, Stereo *line, int line_size, int end, int expect) {
+    get_line(r, (float *)line, line_size * 2, end * 2, expect * 2);
+}
+
+static void get_effects(Reader *r, Effects *fx) {
+    Delay *d = &fx->delay;
+    get(r, &d->write_pos, sizeof(d->write_pos));
+    get(r, &d->time, sizeof(d->time));
+    get(r, &d->feedback, sizeof(d->feedback));
+    get(r, &d->mix, sizeof(d->mix));
+    get(r, &d->pingpong, sizeof(d->pingpong));
+    get(r, &d->feedback_smooth, sizeof(d->feedback_smooth));
+    get(r, &d->mix_smooth, sizeof(d->mix_smooth));
+
+    Reverb *rv = &fx->reverb;
+    get(r, &rv->mix, sizeof(rv->mix));
+    get(r, &rv->roomsize, sizeof(rv->roomsize));
+    get(r, &rv->mix_smooth, sizeof(rv->mix_smooth));
+    for (int i = 0; i < NUM_COMB_FILTERS; i++) {
+        CombFilter *c = &rv->combs[i];
+        get(r, &c->size, sizeof(int));
+        get(r, &c->spread, sizeof(int));
+        get(r, &c->pos, sizeof(int));
+        get(r, &c->feedback, sizeof(float));
+        if (c->size < 1 || c->spread < 0 || c->size + c->spread > c->mask) r->ok = 0;
+    }
+    for (int i = 0; i < NUM_ALLPASS_FILTERS; i++) {
+        AllpassFilter *a = &rv->allpasses[i];
+        get(r, &a->size, sizeof(int));
+        get(r, &a->spread, sizeof(int));
+        get(r, &a->pos, sizeof(int));
+        get(r, &a->feedback, sizeof(float));
+        if (a->size < 1 || a->spread < 0 || a->size + a->spread > a->mask) r->ok = 0;
+    }
+
+    get(r, &fx->distortion, sizeof(fx->distortion));
+    if (!r->ok || d->write_pos < 0 || d->write_pos >= d->length) {
+        r->ok = 0;
+        return;
+    }
+
+    get_stereo_line(r, d->buffer, d->length, d->write_pos, delay_live_samples(d));
+    for (int i = 0; i < NUM_COMB_FILTERS; i++) {
+        CombFilter *c = &rv->combs[i];
+        get_stereo_line(r, c->buffer, c->mask + 1, c->pos, c->size + c->spread);
+    }
+    for (int i = 0; i < NUM_ALLPASS_FILTERS; i++) {
+        AllpassFilter *a = &rv->allpasses[i];
+        get_stereo_line(r, a->buffer, a->mask + 1, a->pos, a->size + a->spread);
+    }
+}
+
+int snapshot_restore(Engine *e, const void *buf, size_t size) {
+    SnapshotHeader h;
+    if (size < sizeof(h)) return -1;
+    memcpy(&h, buf, sizeof(h));
+    if (h.magic != SNAPSHOT_MAGIC || h.version != SNAPSHOT_VERSION ||
+        h.layout_hash != layout_hash() || h.sample_rate != (uint32_t)sample_rate ||
+        h.size != size) {
+        return -1;
+    }
+    const unsigned char *payload = (const unsigned char *)buf + sizeof(h);
+    if (fnv1a(payload, size - sizeof(h)) != h.checksum) return -1;
+
+    Staging *st = calloc(1, sizeof(Staging));
+    if (!st) return -1;
+
+    // Lines like the engine's (its lengths never change), zeroed: silent
+    Arena lines;
+    if (arena_init(&lines, effects_memory(e->max_delay)) < 0) {
+        free(st);
+        return -1;
+    }
+    effects_init(&st->effects);
+    effects_alloc(&st->effects, &lines, e->max_delay);
+
+    Reader r = {(const unsigned char *)buf, sizeof(h), size, 1};
+    for (int i = 0; i < MAX_PARTS && r.ok; i++) {
+        SnapshotPart *sp = &st->part[i];
+        get(&r, sp, sizeof(*sp));
+        get_synth(&r, &st->synth[i]);
+        get(&r, &st->arp[i], sizeof(st->arp[i]));
+        if (sp->xfade_remaining > 0) get_synth(&r, &st->xfade[i]);
+        sp->preset_name[PART_NAME_LEN - 1] = '\0';
+    }
+    get_effects(&r, &st->effects);
+    get(&r, &st->limiter, sizeof(st->limiter));
+    get(&r, &st->midimap, sizeof(st->midimap));
+
+    if (!r.ok || r.pos != size) {
+        arena_free(&lines);
+        free(st);
+        return -1;
+    }
+
+    engine_lock(e);
+    for (int i = 0; i < MAX_PARTS; i++) {
+        Part *p = &e->multi.parts[i];
+        const SnapshotPart *sp = &st->part[i];
+        p->enabled = sp->enabled;
+        p->channel = sp->channel;
+        p->fx_send = sp->fx_send;
+        memcpy(p->preset_name, sp->preset_name, sizeof(p->preset_name));
+        p->synth = st->synth[i];
+        p->arp = st->arp[i];
+        p->xfade.length = sp->xfade_length;
+        p->xfade.remaining = sp->xfade_remaining > 0 ? sp->xfade_remaining : 0;
+        if (p->xfade.remaining > 0) p->xfade.synth = st->xfade[i];
+    }
+    effects_copy(&e->effects, &st->effects);
+    e->limiter = st->limiter;
+    e->midimap = st->midimap;
+    e->idle = 0;            // The restored lines may still be ringing
+    e->quiet_frames = 0;
+    engine_unlock(e);
+
+    arena_free(&lines);
+    free(st);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// Files
+//------------------------------------------------------------------------------
+
+int snapshot_save(Engine *e, const char *path, int flags) {
+    size_t max = snapshot_max_size(e);
+    void *buf = malloc(max);
+    if (!buf) return -1;
+
+    size_t size = snapshot_capture(e, buf, max, flags);
+    int result = -1;
+    FILE *f = size ? fopen(path, "wb") : NULL;
+    if (f) {
+        if (fwrite(buf, 1, size, f) == size) result = 0;
+        if (fclose(f) != 0) result = -1;
+    }
+    free(buf);
+    return result;
+}
+
+int snapshot_load(Engine *e, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+
+    size_t max = snapshot_max_size(e);
+    void *buf = malloc(max + 1);
+    size_t size = buf ? fread(buf, 1, max + 1, f) : 0;
+    fclose(f);
+
+    int result = (size > 0 && size <= max) ? snapshot_restore(e, buf, size) : -1;
+    free(buf);
+    return result;
+}
@@ -0,0 +1,61 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "engine.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Engine state snapshots.
+// Captures everything that shapes the next sample: every part's voices
+// (oscillator phases, envelope stages, filter memories, expression), the
+// arpeggiators, any running preset crossfade, the effects with their delay
+// and reverb lines, the master limiter and the MIDI map. Restoring one makes
+// the engine continue exactly where the captured one was, so snapshots serve
+// A/B comparisons, crash reproduction and deterministic starts for the
+// offline renderer.
+//
+// Blob layout (native byte order, fixed section order):
+//   SnapshotHeader
+//   per part: SnapshotPart, Synth, Arpeggiator[, Synth if crossfading]
+//   effects: scalar state, then the delay line's live region and the used
+//            length of each comb/allpass line as float chunks (stereo lines
+//            interleaved)
+//   Limiter
+//   MidiMap
+//
+// The structs are stored raw, so a blob only restores into a build with the
+// same layout (layout_hash) and at the same sample rate. A delay line of a
+// different length takes the blob as long as the live region fits.
+
+#define SNAPSHOT_MAGIC      0x504E5342u   // "BSNP"
+#define SNAPSHOT_VERSION    3
+
+// Capture flags
+#define SNAPSHOT_COMPRESS   1             // Zero-run encode the audio lines
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t layout_hash;       // Struct sizes and counts of this build
+    uint32_t sample_rate;
+    uint32_t size;              // Whole blob, header included
+    uint32_t flags;
+    uint32_t checksum;          // FNV-1a of everything after the header
+} SnapshotHeader;
+
+// Largest blob snapshot_capture can produce for this engine
+size_t snapshot_max_size(const Engine *e);
+
+// Capture the engine into buf (takes the engine lock only while copying).
+// Returns the blob size, or 0 if buf is too small.
+size_t snapshot_capture(Engine *e, void *buf, size_t size, int flags);
+
+// Restore a captured blob (takes the lock). Returns 0, or -1 with the engine
+// untouched if the blob is damaged or from another layout/sample rate.
+int snapshot_restore(Engine *e, const void *buf, size_t size);
+
+// File helpers (file I/O outside the lock). Return 0 or -1.
+int snapshot_save(Engine *e, const char *path, int flags);
+int snapshot_load(Engine *e, const char *path);
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,98 @@
+#include "spectrum.h"
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define HALF (SPECTRUM_SIZE / 2)
+
+void spectrum_init(Spectrum *s) {
+    for (int i = 0; i < SPECTRUM_SIZE; i++) {
+        s->window[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / SPECTRUM_SIZE);
+    }
+    for (int k = 0; k < HALF; k++) {
+        s->tw_re[k] = cosf(2.0f * (float)M_PI * k / SPECTRUM_SIZE);
+        s->tw_im[k] = -sinf(2.0f * (float)M_PI * k / SPECTRUM_SIZE);
+    }
+
+    int bits = 0;
+    while ((1 << bits) < HALF) bits++;
+    for (int i = 0; i < HALF; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        }
+        s->bitrev[i] = (unsigned short)r;
+    }
+
+    for (int k = 0; k < SPECTRUM_BINS; k++) {
+        s->db[k] = SPECTRUM_FLOOR;
+    }
+}
+
+// In-place radix-2 FFT of the HALF-point complex work buffer (input already
+// in bit-reversed order). Its twiddles are every second one of the full size.
+static void fft_half(Spectrum *s) {
+    float *re = s->re, *im = s->im;
+    for (int len = 2; len <= HALF; len <<= 1) {
+        int half = len >> 1;
+        int step = SPECTRUM_SIZE / len;
+        for (int i = 0; i < HALF; i += len) {
+            for (int j = 0; j < half; j++) {
+                float wr = s->tw_re[j * step];
+                float wi = s->tw_im[j * step];
+                int a = i + j, b = a + half;
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
+void spectrum_process(Spectrum *s, const float *samples, float fall_db) {
+    // Pack even samples as real, odd as imaginary
+    for (int i = 0; i < HALF; i++) {
+        int r = s->bitrev[i];
+        s->re[r] = samples[2 * i] * s->window[2 * i];
+        s->im[r] = samples[2 * i + 1] * s->window[2 * i + 1];
+    }
+    fft_half(s);
+
+    // Split into the spectrum of the real signal:
+    // X[k] = E[k] + W^k O[k], E/O from Z[k] and conj(Z[HALF-k])
+    // Full-scale sine -> 0 dB (Hann gain 0.5, one-sided)
+    const float scale = 4.0f / SPECTRUM_SIZE;
+    for (int k = 0; k < SPECTRUM_BINS; k++) {
+        int a = k & (HALF - 1);             // Z[HALF] wraps to Z[0]
+        int b = (HALF - k) & (HALF - 1);
+        float zr = s->re[a], zi = s->im[a];
+        float cr = s->re[b], ci = -s->im[b];
+
+        float er = 0.5f * (zr + cr), ei = 0.5f * (zi + ci);
+        float or_ = 0.5f * (zi - ci), oi = -0.5f * (zr - cr);
+
+        float wr, wi;
+        if (k < HALF) {
+            wr = s->tw_re[k];
+            wi = s->tw_im[k];
+        } else {
+            wr = -1.0f;
+            wi = 0.0f;
+        }
+        float xr = er + wr * or_ - wi * oi;
+        float xi = ei + wr * oi + wi * or_;
+
+        float mag = sqrtf(xr * xr + xi * xi) * scale;
+        float db = (mag > 1e-9f) ? 20.0f * log10f(mag) : SPECTRUM_FLOOR;
+        if (db < SPECTRUM_FLOOR) db = SPECTRUM_FLOOR;
+
+        // Rise at once, fall gradually
+        float held = s->db[k] - fall_db;
+        s->db[k] = (db > held) ? db : held;
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+// Spectrum analyser for the display (UI thread only).
+// Hann-windowed real FFT of the newest SPECTRUM_SIZE output samples: the
+// real input is packed into a half-length complex FFT and split afterwards,
+// so a frame costs one 512-point transform. Levels are kept in dB with a
+// peak-hold fall so the bars read steadily at the display frame rate.
+
+#define SPECTRUM_SIZE   1024                    // Transform length (power of two)
+#define SPECTRUM_BINS   (SPECTRUM_SIZE / 2 + 1) // DC..Nyquist
+#define SPECTRUM_FLOOR  -90.0f                  // dB shown as empty
+
+typedef struct {
+    float window[SPECTRUM_SIZE];
+    float tw_re[SPECTRUM_SIZE / 2];     // exp(-2*pi*i*k/SIZE)
+    float tw_im[SPECTRUM_SIZE / 2];
+    unsigned short bitrev[SPECTRUM_SIZE / 2];
+    float re[SPECTRUM_SIZE / 2];        // Work buffers
+    float im[SPECTRUM_SIZE / 2];
+    float db[SPECTRUM_BINS];            // Displayed level per bin
+} Spectrum;
+
+void spectrum_init(Spectrum *s);
+
+// Analyse SPECTRUM_SIZE samples (oldest first) into s->db.
+// fall_db is how far a bin may drop since the last frame.
+void spectrum_process(Spectrum *s, const float *samples, float fall_db);
+
+#endif // SPECTRUM_H
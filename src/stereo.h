@@ -0,0 +1,34 @@
+#ifndef STEREO_H
+#define STEREO_H
+
+#include <math.h>
+
+// Stereo sample: left and right as one 2-lane vector (GCC vector
+// extension), so stereo voices, filters and effects do each operation once
+// for both channels (a NEON d-register on the Pi, SSE on x86).
+// An array of them has the same layout as interleaved stereo.
+
+typedef float Stereo __attribute__((vector_size(2 * sizeof(float))));
+
+static inline Stereo stereo(float left, float right) {
+    return (Stereo){left, right};
+}
+
+static inline Stereo stereo_mono(float x) {
+    return (Stereo){x, x};
+}
+
+static inline Stereo stereo_swap(Stereo x) {
+    return (Stereo){x[1], x[0]};
+}
+
+// Constant-power pan gains for a position from -1 (left) to +1 (right),
+// unity in both channels at the centre (setup rate: uses cos/sin)
+static inline Stereo stereo_pan(float position) {
+    if (position < -1.0f) position = -1.0f;
+    if (position > 1.0f) position = 1.0f;
+    float angle = (position + 1.0f) * 0.25f * 3.14159265f;
+    return (Stereo){1.41421356f * cosf(angle), 1.41421356f * sinf(angle)};
+}
+
+#endif // STEREO_H
@@ -1,5 +1,25 @@
 #include "synth.h"
 #include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+// Target field for each smoothed parameter
+static const size_t smooth_targets[SMOOTH_COUNT] = {
+    [SMOOTH_OSC_MIX]           = offsetof(Synth, osc_mix),
+    [SMOOTH_SUB_OSC_MIX]       = offsetof(Synth, sub_osc_mix),
+    [SMOOTH_PULSE_WIDTH]       = offsetof(Synth, pulse_width),
+    [SMOOTH_PWM_DEPTH]         = offsetof(Synth, pwm_depth),
+    [SMOOTH_WT_POSITION]       = offsetof(Synth, wt_position),
+    [SMOOTH_FILTER_CUTOFF]     = offsetof(Synth, filter_cutoff),
+    [SMOOTH_FILTER_RESO]       = offsetof(Synth, filter_resonance),
+    [SMOOTH_FILTER_ENV_AMOUNT] = offsetof(Synth, filter_env_amount),
+    [SMOOTH_LFO_DEPTH]         = offsetof(Synth, lfo_depth),
+    [SMOOTH_VOLUME]            = offsetof(Synth, volume),
+};
+
+static float smooth_target(const Synth *s, SmoothedParam p) {
+    return *(const float *)((const char *)s + smooth_targets[p]);
+}
 
 void synth_init(Synth *s) {
     for (int i = 0; i < NUM_VOICES; i++) {
@@ -17,6 +37,9 @@ void synth_init(Synth *s) {
 
     s->unison_count = 1;    // No unison by default
     s->unison_spread = 20.0f; // 20 cents spread
+    s->unison_width = 0.5f;
+    s->shed = 0;
+    s->pan_spread = 0.25f;
 
     s->wavetable_type = WT_BASIC;
     s->wt_position = 0.0f;
@@ -43,6 +66,104 @@ void synth_init(Synth *s) {
     s->lfo_type = LFO_SINE;
 
     s->volume = 0.5f;
+
+    // Expression defaults: standard wheel range, MPE off
+    s->bend_range = 2;
+    s->mpe_bend_range = 48;
+    s->pressure_amount = 0.5f;
+    s->timbre_amount = 0.5f;
+    s->mpe_members = 0;
+
+    tuning_tables_init();
+    tuning_init_equal(&s->tuning);
+
+    for (int i = 0; i < SMOOTH_COUNT; i++) {
+        smoother_init(&s->smooth[i], smooth_target(s, (SmoothedParam)i), SMOOTH_TIME_MS);
+    }
+
+    memset(&s->expr, 0, sizeof(s->expr));
+    memset(s->expr.voice_channel, -1, sizeof(s->expr.voice_channel));
+    s->expr.coeff = smoother_coeff(EXPR_SMOOTH_MS);
+}
+
+// Advance every voice's expression one control block. Branch-free over
+// fixed-size arrays so it vectorises across voices.
+static void expr_update(ExprLanes *e) {
+    const float coeff = e->coeff;
+    for (int lane = 0; lane < EXPR_COUNT; lane++) {
+        const float global = e->global[lane];
+        const float *note = e->note[lane];
+        float *value = e->value[lane];
+        for (int i = 0; i < NUM_VOICES; i++) {
+            float diff = global + note[i] - value[i];
+            // Snap when close to avoid denormals and endless tails
+            value[i] = (fabsf(diff) < 1e-5f) ? global + note[i] : value[i] + diff * coeff;
+        }
+    }
+}
+
+// Copy the current global settings into a voice (smoothed values where available)
+static void push_voice_params(Synth *s, int index) {
+    Voice *v = &s->voices[index];
+    const Smoother *sm = s->smooth;
+
+    osc_set_type(&v->osc, s->wave_type);
+    osc_set_type(&v->osc2, s->wave_type2);
+    osc_set_type(&v->sub_osc, s->wave_type);  // Sub uses same waveform as osc1
+    v->osc_mix = sm[SMOOTH_OSC_MIX].value;
+    v->osc2_detune = s->osc2_detune;
+    v->sub_osc_mix = sm[SMOOTH_SUB_OSC_MIX].value;
+
+    filter_set_resonance(&v->filter, sm[SMOOTH_FILTER_RESO].value);
+    filter_set_type(&v->filter, s->filter_type);
+    v->base_filter_cutoff = sm[SMOOTH_FILTER_CUTOFF].value;
+    env_set_adsr(&v->env, s->attack, s->decay, s->sustain, s->release);
+
+    // Filter envelope settings
+    env_set_adsr(&v->filter_env, s->filter_env_attack, s->filter_env_decay,
+                 s->filter_env_sustain, s->filter_env_release);
+    v->filter_env_amount = sm[SMOOTH_FILTER_ENV_AMOUNT].value;
+
+    // LFO settings
+    lfo_set_rate(&v->filter_lfo, s->lfo_rate);
+    lfo_set_depth(&v->filter_lfo, sm[SMOOTH_LFO_DEPTH].value);
+    lfo_set_type(&v->filter_lfo, s->lfo_type);
+
+    // PWM settings
+    v->pulse_width = sm[SMOOTH_PULSE_WIDTH].value;
+    lfo_set_rate(&v->pwm_lfo, s->pwm_rate);
+    lfo_set_depth(&v->pwm_lfo, sm[SMOOTH_PWM_DEPTH].value);
+
+    // Unison settings
+    v->unison_count = s->unison_count;
+    v->unison_spread = s->unison_spread;
+    v->shed = s->shed;
+    voice_set_stereo(v, s->unison_width, s->pan_spread);
+
+    // Wavetable settings
+    osc_set_wavetable(&v->osc, s->wavetable_type);
+    osc_set_wt_position(&v->osc, sm[SMOOTH_WT_POSITION].value);
+
+    // Expression: bend retunes the oscillators only while it moves
+    const ExprLanes *e = &s->expr;
+    if (e->value[EXPR_BEND][index] != v->bend) {
+        voice_set_bend(v, e->value[EXPR_BEND][index]);
+    }
+    v->expr_gain = 1.0f + e->value[EXPR_PRESSURE][index] * s->pressure_amount;
+    v->expr_cutoff = e->value[EXPR_TIMBRE][index] * s->timbre_amount;
+}
+
+void synth_control_update(Synth *s) {
+    for (int i = 0; i < SMOOTH_COUNT; i++) {
+        smoother_next(&s->smooth[i], smooth_target(s, (SmoothedParam)i));
+    }
+    expr_update(&s->expr);
+
+    for (int i = 0; i < NUM_VOICES; i++) {
+        if (voice_is_active(&s->voices[i])) {
+            push_voice_params(s, i);
+        }
+    }
 }
 
 // Find a free voice or steal the oldest one
@@ -64,70 +185,129 @@ static Voice* find_voice(Synth *s) {
     return oldest;
 }
 
-// Find voice playing a specific note (must be active and not in release)
-static Voice* find_voice_by_note(Synth *s, int note) {
+// Find voice playing a specific note (must be active and not in release).
+// channel is the member channel the note arrived on, -1 outside MPE.
+static Voice* find_voice_by_note(Synth *s, int channel, int note) {
     for (int i = 0; i < NUM_VOICES; i++) {
-        if (s->voices[i].note == note && voice_is_active(&s->voices[i])) {
+        if (s->voices[i].note == note && s->expr.voice_channel[i] == channel &&
+            voice_is_active(&s->voices[i])) {
             return &s->voices[i];
         }
     }
     return NULL;
 }
 
+int synth_is_member_channel(const Synth *s, int channel) {
+    return channel > MPE_ZONE_MASTER && channel <= MPE_ZONE_MASTER + s->mpe_members;
+}
+
 void synth_note_on(Synth *s, int note, int velocity) {
+    synth_note_on_channel(s, -1, note, velocity);
+}
+
+void synth_note_on_channel(Synth *s, int channel, int note, int velocity) {
     if (velocity == 0) {
-        synth_note_off(s, note);
+        synth_note_off_channel(s, channel, note);
         return;
     }
+    if (note < 0 || note >= TUNING_NOTES || !s->tuning.mapped[note]) return;
+
+    // Nothing sounding means nothing to glide from: start at the targets
+    if (!synth_is_active(s)) {
+        for (int i = 0; i < SMOOTH_COUNT; i++) {
+            smoother_reset(&s->smooth[i], smooth_target(s, (SmoothedParam)i));
+        }
+    }
 
     Voice *v = find_voice(s);
+    int index = (int)(v - s->voices);
+
+    // The voice follows its member channel; it starts at that channel's
+    // current expression rather than gliding from the previous note
+    ExprLanes *e = &s->expr;
+    int member = synth_is_member_channel(s, channel);
+    e->voice_channel[index] = (signed char)(member ? channel : -1);
+    for (int lane = 0; lane < EXPR_COUNT; lane++) {
+        e->note[lane][index] = member ? e->channel[lane][channel] : 0.0f;
+        e->value[lane][index] = e->global[lane] + e->note[lane][index];
+    }
+    v->bend = e->value[EXPR_BEND][index];
 
     // Apply global settings to voice
-    osc_set_type(&v->osc, s->wave_type);
-    osc_set_type(&v->osc2, s->wave_type2);
-    osc_set_type(&v->sub_osc, s->wave_type);  // Sub uses same waveform as osc1
-    v->osc_mix = s->osc_mix;
-    v->osc2_detune = s->osc2_detune;
-    v->sub_osc_mix = s->sub_osc_mix;
-    filter_set_cutoff(&v->filter, s->filter_cutoff);
-    filter_set_resonance(&v->filter, s->filter_resonance);
-    filter_set_type(&v->filter, s->filter_type);
-    v->base_filter_cutoff = s->filter_cutoff;
-    env_set_adsr(&v->env, s->attack, s->decay, s->sustain, s->release);
+    push_voice_params(s, index);
+    filter_set_cutoff(&v->filter, v->base_filter_cutoff);
 
-    // Filter envelope settings
-    env_set_adsr(&v->filter_env, s->filter_env_attack, s->filter_env_decay,
-                 s->filter_env_sustain, s->filter_env_release);
-    v->filter_env_amount = s->filter_env_amount;
+    voice_note_on(v, note, velocity, s->tuning.increment[note]);
+}
 
-    // LFO settings
-    lfo_set_rate(&v->filter_lfo, s->lfo_rate);
-    lfo_set_depth(&v->filter_lfo, s->lfo_depth);
-    lfo_set_type(&v->filter_lfo, s->lfo_type);
+void synth_note_off(Synth *s, int note) {
+    synth_note_off_channel(s, -1, note);
+}
 
-    // PWM settings
-    v->pulse_width = s->pulse_width;
-    lfo_set_rate(&v->pwm_lfo, s->pwm_rate);
-    lfo_set_depth(&v->pwm_lfo, s->pwm_depth);
+void synth_note_off_channel(Synth *s, int channel, int note) {
+    if (!synth_is_member_channel(s, channel)) channel = -1;
 
-    // Unison settings
-    v->unison_count = s->unison_count;
-    v->unison_spread = s->unison_spread;
+    Voice *v = find_voice_by_note(s, channel, note);
+    if (v != NULL) {
+        voice_note_off(v);
+    }
+}
 
-    // Wavetable settings
-    osc_set_wavetable(&v->osc, s->wavetable_type);
-    osc_set_wt_position(&v->osc, s->wt_position);
+void synth_expression(Synth *s, int channel, ExprLane lane, float value) {
+    ExprLanes *e = &s->expr;
 
-    voice_note_on(v, note, velocity);
+    if (synth_is_member_channel(s, channel)) {
+        if (lane == EXPR_BEND) value *= (float)s->mpe_bend_range;
+        e->channel[lane][channel] = value;
+        for (int i = 0; i < NUM_VOICES; i++) {
+            if (e->voice_channel[i] == channel) e->note[lane][i] = value;
+        }
+    } else {
+        if (lane == EXPR_BEND) value *= (float)s->bend_range;
+        e->global[lane] = value;
+    }
 }
 
-void synth_note_off(Synth *s, int note) {
-    Voice *v = find_voice_by_note(s, note);
-    if (v != NULL) {
-        voice_note_off(v);
+void synth_note_pressure(Synth *s, int note, float value) {
+    for (int i = 0; i < NUM_VOICES; i++) {
+        if (s->voices[i].note == note) s->expr.note[EXPR_PRESSURE][i] = value;
     }
 }
 
+void synth_set_mpe_members(Synth *s, int members) {
+    if (members < 0) members = 0;
+    if (members > SYNTH_MIDI_CHANNELS - 1) members = SYNTH_MIDI_CHANNELS - 1;
+
+    // A held note's channel was matched against the old zone, so its note-off
+    // would no longer find it: release held notes and detach every voice
+    if (members != s->mpe_members) {
+        for (int i = 0; i < NUM_VOICES; i++) {
+            if (s->voices[i].note >= 0) voice_note_off(&s->voices[i]);
+        }
+        memset(s->expr.voice_channel, -1, sizeof(s->expr.voice_channel));
+    }
+
+    s->mpe_members = members;
+    s->bend_range = 2;
+    s->mpe_bend_range = 48;
+
+    // Member channel state from a previous zone no longer applies
+    memset(s->expr.channel, 0, sizeof(s->expr.channel));
+}
+
+void synth_set_bend_range(Synth *s, int channel, int semitones) {
+    if (semitones < 0) semitones = 0;
+    if (synth_is_member_channel(s, channel)) {
+        s->mpe_bend_range = (semitones > 96) ? 96 : semitones;
+    } else {
+        s->bend_range = (semitones > 24) ? 24 : semitones;
+    }
+}
+
+void synth_set_tuning(Synth *s, const Tuning *t) {
+    s->tuning = *t;
+}
+
 void synth_panic(Synth *s) {
     // Force all voices off immediately
     for (int i = 0; i < NUM_VOICES; i++) {
@@ -138,152 +318,106 @@ void synth_panic(Synth *s) {
         s->voices[i].filter_env.stage = 0;
         s->voices[i].filter_env.level = 0.0f;
     }
+
+    // Centre bend and clear pressure/timbre
+    ExprLanes *e = &s->expr;
+    memset(e->note, 0, sizeof(e->note));
+    memset(e->global, 0, sizeof(e->global));
+    memset(e->channel, 0, sizeof(e->channel));
+}
+
+int synth_is_active(const Synth *s) {
+    for (int i = 0; i < NUM_VOICES; i++) {
+        if (voice_is_active(&s->voices[i])) return 1;
+    }
+    return 0;
 }
 
-float synth_process(Synth *s) {
-    float mix = 0.0f;
-    int active_count = 0;
+Stereo synth_process(Synth *s) {
+    Stereo mix = stereo_mono(0.0f);
 
+    // Every voice at the same level however many are sounding; the master
+    // limiter catches the peaks of big chords
     for (int i = 0; i < NUM_VOICES; i++) {
         if (voice_is_active(&s->voices[i])) {
             mix += voice_process(&s->voices[i]);
-            active_count++;
         }
     }
 
-    // Normalize by number of active voices to prevent clipping
-    if (active_count > 0) {
-        mix /= (float)active_count;
-    }
-
-    return mix * s->volume;
+    return mix * (SYNTH_VOICE_GAIN * s->smooth[SMOOTH_VOLUME].value);
 }
 
 void synth_set_wave_type(Synth *s, WaveType type) {
     s->wave_type = type;
-    // Update active voices
-    for (int i = 0; i < NUM_VOICES; i++) {
-        osc_set_type(&s->voices[i].osc, type);
-    }
 }
 
 void synth_set_wave_type2(Synth *s, WaveType type) {
     s->wave_type2 = type;
-    // Update active voices
-    for (int i = 0; i < NUM_VOICES; i++) {
-        osc_set_type(&s->voices[i].osc2, type);
-    }
 }
 
 void synth_set_osc_mix(Synth *s, float mix) {
     if (mix < 0.0f) mix = 0.0f;
     if (mix > 1.0f) mix = 1.0f;
     s->osc_mix = mix;
-    // Update active voices
-    for (int i = 0; i < NUM_VOICES; i++) {
-        s->voices[i].osc_mix = mix;
-    }
 }
 
 void synth_set_osc2_detune(Synth *s, float cents) {
     if (cents < -100.0f) cents = -100.0f;
     if (cents > 100.0f) cents = 100.0f;
     s->osc2_detune = cents;
-    // Update active voices
-    for (int i = 0; i < NUM_VOICES; i++) {
-        s->voices[i].osc2_detune = cents;
-    }
 }
 
 void synth_set_sub_osc_mix(Synth *s, float mix) {
     if (mix < 0.0f) mix = 0.0f;
     if (mix > 1.0f) mix = 1.0f;
     s->sub_osc_mix = mix;
-    // Update active voices
-    for (int i = 0; i < NUM_VOICES; i++) {
-        s->voices[i].sub_osc_mix = mix;
-    }
 }
 
 void synth_set_pulse_width(Synth *s, float width) {
     if (width < 0.05f) width = 0.05f;
     if (width > 0.95f) width = 0.95f;
     s->pulse_width = width;
-    // Update active voices
-    for (int i = 0; i < NUM_VOICES; i++) {
-        s->voices[i].pulse_width = width;
-    }
 }
 
 void synth_set_pwm_rate(Synth *s, float rate) {
     if (rate < 0.1f) rate = 0.1f;
     if (rate > 20.0f) rate = 20.0f;
     s->pwm_rate = rate;
-    // Update active voices
-    for (int i = 0; i < NUM_VOICES; i++) {
-        lfo_set_rate(&s->voices[i].pwm_lfo, rate);
-    }
 }
 
 void synth_set_pwm_depth(Synth *s, float depth) {
     if (depth < 0.0f) depth = 0.0f;
     if (depth > 0.45f) depth = 0.45f;  // Max 45% to stay within 5-95% range
     s->pwm_depth = depth;
-    // Update active voices
-    for (int i = 0; i < NUM_VOICES; i++) {
-        lfo_set_depth(&s->voices[i].pwm_lfo, depth);
-    }
 }
 
 void synth_set_unison_count(Synth *s, int count) {
     if (count < 1) count = 1;
     if (count > MAX_UNISON) count = MAX_UNISON;
     s->unison_count = count;
-    // Update active voices
-    for (int i = 0; i < NUM_VOICES; i++) {
-        s->voices[i].unison_count = count;
-    }
 }
 
 void synth_set_unison_spread(Synth *s, float spread) {
     if (spread < 0.0f) spread = 0.0f;
     if (spread > 100.0f) spread = 100.0f;
     s->unison_spread = spread;
-    // Update active voices
-    for (int i = 0; i < NUM_VOICES; i++) {
-        s->voices[i].unison_spread = spread;
-    }
 }
 
 void synth_set_wavetable(Synth *s, WavetableType type) {
     if (type >= WT_COUNT) type = WT_BASIC;
     s->wavetable_type = type;
-    // Update active voices
-    for (int i = 0; i < NUM_VOICES; i++) {
-        osc_set_wavetable(&s->voices[i].osc, type);
-    }
 }
 
 void synth_set_wt_position(Synth *s, float position) {
     if (position < 0.0f) position = 0.0f;
     if (position > 1.0f) position = 1.0f;
     s->wt_position = position;
-    // Update active voices
-    for (int i = 0; i < NUM_VOICES; i++) {
-        osc_set_wt_position(&s->voices[i].osc, position);
-    }
 }
 
 void synth_set_filter(Synth *s, float cutoff, float resonance, FilterType type) {
     s->filter_cutoff = cutoff;
     s->filter_resonance = resonance;
     s->filter_type = type;
-    // Update active voices
-    for (int i = 0; i < NUM_VOICES; i++) {
-        filter_set_cutoff(&s->voices[i].filter, cutoff);
-        filter_set_resonance(&s->voices[i].filter, resonance);
-        filter_set_type(&s->voices[i].filter, type);
-    }
 }
 
 void synth_set_adsr(Synth *s, float a, float d, float s_level, float r) {
@@ -304,38 +438,22 @@ void synth_set_filter_env_amount(Synth *s, float amount) {
     if (amount < -1.0f) amount = -1.0f;
     if (amount > 1.0f) amount = 1.0f;
     s->filter_env_amount = amount;
-    // Update active voices
-    for (int i = 0; i < NUM_VOICES; i++) {
-        s->voices[i].filter_env_amount = amount;
-    }
 }
 
 void synth_set_lfo_rate(Synth *s, float rate) {
     if (rate < 0.1f) rate = 0.1f;
     if (rate > 20.0f) rate = 20.0f;
     s->lfo_rate = rate;
-    // Update active voices
-    for (int i = 0; i < NUM_VOICES; i++) {
-        lfo_set_rate(&s->voices[i].filter_lfo, rate);
-    }
 }
 
 void synth_set_lfo_depth(Synth *s, float depth) {
     if (depth < 0.0f) depth = 0.0f;
     if (depth > 1.0f) depth = 1.0f;
     s->lfo_depth = depth;
-    // Update active voices
-    for (int i = 0; i < NUM_VOICES; i++) {
-        lfo_set_depth(&s->voices[i].filter_lfo, depth);
-    }
 }
 
 void synth_set_lfo_type(Synth *s, LFOWaveType type) {
     s->lfo_type = type;
-    // Update active voices
-    for (int i = 0; i < NUM_VOICES; i++) {
-        lfo_set_type(&s->voices[i].filter_lfo, type);
-    }
 }
 
 void synth_set_volume(Synth *s, float vol) {
@@ -2,8 +2,57 @@
 #define SYNTH_H
 
 #include "voice.h"
+#include "smooth.h"
 
+// Voices per part. MPE wants one per member channel: build with
+// make VOICES=16 (about four times the voice cost at full polyphony).
+#ifndef NUM_VOICES
 #define NUM_VOICES 4
+#endif
+#define SYNTH_MIDI_CHANNELS 16
+#define MPE_ZONE_MASTER 0       // Lower zone master channel (MIDI channel 1)
+
+// Level of each voice, the same however many are sounding (-6 dB: a single
+// note has headroom, and the master limiter takes the peaks of big chords)
+#define SYNTH_VOICE_GAIN 0.5f
+
+// Expression smoothing time (pitch bend, pressure, timbre)
+#define EXPR_SMOOTH_MS 10.0f
+
+// Continuous parameters that glide in the audio thread
+typedef enum {
+    SMOOTH_OSC_MIX,
+    SMOOTH_SUB_OSC_MIX,
+    SMOOTH_PULSE_WIDTH,
+    SMOOTH_PWM_DEPTH,
+    SMOOTH_WT_POSITION,
+    SMOOTH_FILTER_CUTOFF,
+    SMOOTH_FILTER_RESO,
+    SMOOTH_FILTER_ENV_AMOUNT,
+    SMOOTH_LFO_DEPTH,
+    SMOOTH_VOLUME,
+    SMOOTH_COUNT
+} SmoothedParam;
+
+// Expression dimensions (pitch bend, aftertouch, MPE timbre)
+typedef enum {
+    EXPR_BEND,          // Semitones
+    EXPR_PRESSURE,      // 0 to 1
+    EXPR_TIMBRE,        // -1 to +1 (CC74, centre 64)
+    EXPR_COUNT
+} ExprLane;
+
+// Per-voice expression, stored lane by lane (one array across all voices per
+// dimension) so the control-rate smoothing is a plain loop the compiler
+// vectorises. A voice's level is its channel-wide input plus its own.
+typedef struct {
+    float note[EXPR_COUNT][NUM_VOICES];     // Per-note input (member channel, poly aftertouch)
+    float value[EXPR_COUNT][NUM_VOICES];    // Smoothed total, read by the voices
+    float global[EXPR_COUNT];               // Channel-wide input (master channel, or any channel without MPE)
+    float channel[EXPR_COUNT][SYNTH_MIDI_CHANNELS];  // Last member channel input, seeds new notes
+    signed char voice_channel[NUM_VOICES];  // Member channel a voice follows, -1 = none
+    float coeff;                            // Smoothing per control block
+} ExprLanes;
 
 typedef struct {
     Voice voices[NUM_VOICES];
@@ -24,6 +73,10 @@ typedef struct {
     int unison_count;       // 1-7 voices
     float unison_spread;    // Detune spread in cents (0-100)
 
+    // Stereo
+    float unison_width;     // Unison copies spread across the field (0-1)
+    float pan_spread;       // Voices placed by key across the field (0-1)
+
     // Wavetable
     WavetableType wavetable_type;   // Current wavetable
     float wt_position;              // Position within wavetable (0-1)
@@ -52,15 +105,74 @@ typedef struct {
 
     // Master volume
     float volume;
+
+    // Expression routing
+    int bend_range;             // Semitones for channel-wide pitch bend
+    int mpe_bend_range;         // Semitones for per-note bend on MPE member channels
+    float pressure_amount;      // Pressure -> level boost (0-1)
+    float timbre_amount;        // Timbre -> filter cutoff offset (0-1)
+
+    // MPE lower zone: master channel 1, member channels 2 to mpe_members + 1.
+    // Set by the MPE configuration message or the UI; 0 = MPE off.
+    int mpe_members;
+    ExprLanes expr;
+
+    // Phase step per MIDI note (12-TET unless a Scala scale is installed)
+    Tuning tuning;
+
+    // Smoothed copies of the continuous parameters above (audio thread only).
+    // The fields above are targets; voices read the smoothed values.
+    Smoother smooth[SMOOTH_COUNT];
+
+    // Quality reductions asked for by the engine's load governor
+    // (VOICE_SHED_* flags, passed to the voices at control rate)
+    int shed;
 } Synth;
 
 void synth_init(Synth *s);
 void synth_note_on(Synth *s, int note, int velocity);
 void synth_note_off(Synth *s, int note);
+
+// Notes from MIDI: on an MPE member channel the voice follows that channel's
+// expression; elsewhere channel is ignored (same as synth_note_on/off)
+void synth_note_on_channel(Synth *s, int channel, int note, int velocity);
+void synth_note_off_channel(Synth *s, int channel, int note);
+
+// Expression input: bend -1 to +1 (scaled by the bend range), pressure 0-1,
+// timbre -1 to +1. Member channels drive their own notes, any other channel
+// the whole synth.
+void synth_expression(Synth *s, int channel, ExprLane lane, float value);
+
+// Polyphonic aftertouch (0-1) for every voice playing a note
+void synth_note_pressure(Synth *s, int note, float value);
+
+// 1 if the channel is an MPE member channel
+int synth_is_member_channel(const Synth *s, int channel);
+
+// MPE zone size (0 = off, up to 15 member channels). Resets the bend ranges
+// to the MPE defaults (2 semitones master, 48 per note). Changing the size
+// releases held notes.
+void synth_set_mpe_members(Synth *s, int members);
+
+// Pitch bend range for a channel (member channels set the per-note range)
+void synth_set_bend_range(Synth *s, int channel, int semitones);
+
+// Install a tuning (copied; held notes keep their pitch). Keys the tuning
+// leaves unmapped are ignored.
+void synth_set_tuning(Synth *s, const Tuning *t);
 void synth_panic(Synth *s);  // All notes off
-float synth_process(Synth *s);
+Stereo synth_process(Synth *s);
+
+// Returns 1 if any voice is sounding
+int synth_is_active(const Synth *s);
+
+// Advance parameter smoothing by one control block and push the current
+// settings into active voices. Call from the audio thread every CONTROL_BLOCK samples.
+void synth_control_update(Synth *s);
 
 // Parameter setters
+// These only clamp and store the new target (O(1), no voice loops);
+// synth_control_update() carries the change into the voices.
 void synth_set_wave_type(Synth *s, WaveType type);
 void synth_set_wave_type2(Synth *s, WaveType type);
 void synth_set_osc_mix(Synth *s, float mix);
@@ -0,0 +1,92 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "telemetry.h"
+#include "arena.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define READ_TRIES 1000
+
+Telemetry *telemetry_create(const char *name, int rate) {
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0) return NULL;
+    if (ftruncate(fd, sizeof(Telemetry)) != 0) {
+        close(fd);
+        return NULL;
+    }
+    void *p = mmap(NULL, sizeof(Telemetry), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return NULL;
+
+    // Written every block: fault it in now and keep it resident
+    Telemetry *t = (Telemetry *)p;
+    memset(t, 0, sizeof(Telemetry));
+    arena_lock_region(t, sizeof(Telemetry));
+    t->version = TELEMETRY_VERSION;
+    t->size = sizeof(Telemetry);
+    t->pid = (int32_t)getpid();
+    t->rate = rate;
+    __atomic_store_n(&t->magic, TELEMETRY_MAGIC, __ATOMIC_RELEASE);
+    return t;
+}
+
+void telemetry_destroy(Telemetry *t, const char *name) {
+    if (!t) return;
+    __atomic_store_n(&t->magic, 0, __ATOMIC_RELEASE);
+    munmap(t, sizeof(Telemetry));
+    shm_unlink(name);
+}
+
+void telemetry_begin(Telemetry *t) {
+    __atomic_store_n(&t->seq, t->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void telemetry_end(Telemetry *t) {
+    __atomic_store_n(&t->seq, t->seq + 1, __ATOMIC_RELEASE);
+}
+
+const Telemetry *telemetry_attach(const char *name) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size != (off_t)sizeof(Telemetry)) {
+        close(fd);
+        return NULL;
+    }
+    void *p = mmap(NULL, sizeof(Telemetry), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return NULL;
+
+    const Telemetry *t = (const Telemetry *)p;
+    if (__atomic_load_n(&t->magic, __ATOMIC_ACQUIRE) != TELEMETRY_MAGIC ||
+        t->version != TELEMETRY_VERSION || t->size != sizeof(Telemetry)) {
+        munmap(p, sizeof(Telemetry));
+        return NULL;
+    }
+    return t;
+}
+
+void telemetry_detach(const Telemetry *t) {
+    if (t) munmap((void *)t, sizeof(Telemetry));
+}
+
+int telemetry_read(const Telemetry *t, Telemetry *out) {
+    for (int i = 0; i < READ_TRIES; i++) {
+        uint32_t before = __atomic_load_n(&t->seq, __ATOMIC_ACQUIRE);
+        if (before & 1) continue;
+        memcpy(out, (const void *)t, sizeof(Telemetry));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&t->seq, __ATOMIC_RELAXED) == before) {
+            // The ring fields are not covered by seq; take them whole
+            out->ring_depth = __atomic_load_n(&t->ring_depth, __ATOMIC_RELAXED);
+            out->ring_frames = __atomic_load_n(&t->ring_frames, __ATOMIC_RELAXED);
+            out->underruns = __atomic_load_n(&t->underruns, __ATOMIC_RELAXED);
+            return 0;
+        }
+    }
+    return -1;
+}
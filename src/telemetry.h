@@ -0,0 +1,71 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "governor.h"
+#include <stdint.h>
+
+// Live engine statistics in shared memory (/dev/shm), for monitors such as
+// buttersynth-top running in another session.
+// The engine rewrites the page at the end of every block under a sequence
+// lock: seq is odd while a block is being written, and a reader copies the
+// page and keeps the copy only if seq was even and unchanged around it. The
+// output ring fields are plain atomics written by the render thread, outside
+// the sequence. Readers map the page read-only and never call into the synth.
+
+#define TELEMETRY_NAME    "/buttersynth"   // shm_open name
+#define TELEMETRY_MAGIC   0x4d4c5442u      // "BTLM"
+#define TELEMETRY_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;              // sizeof(Telemetry) of the writer
+    int32_t pid;                // Publishing process
+    int32_t rate;               // Sample rate
+    uint32_t seq;               // Odd while a block is being written
+
+    // Engine, once per block (under seq)
+    double time;                // CLOCK_MONOTONIC seconds at the last publish
+    uint64_t blocks;
+    uint64_t frames;
+    float load;                 // Render time / block time, smoothed
+    float peak_load;
+    int32_t active_voices;
+    int32_t active_parts;
+    float midi_latency;         // Longest queue wait in the last block with MIDI, ms
+    float midi_latency_peak;
+    int32_t midi_queue;         // Events waiting when the last block started
+    int32_t midi_queue_peak;
+    uint64_t midi_dropped;
+    int32_t idle;
+    float limiter_gr;           // dB
+    int32_t quality;            // QualityLevel
+    uint64_t quality_steps[QUALITY_LEVELS];
+    uint64_t quality_restores;
+    uint64_t voices_stolen;
+
+    // Output ring (render thread, atomics outside seq)
+    int32_t ring_depth;         // Frames kept rendered ahead
+    int32_t ring_frames;        // Frames rendered and not yet played
+    uint32_t underruns;         // Callbacks the ring could not fill
+} Telemetry;
+
+// Create (or take over) the named page. Returns NULL if shared memory is
+// not available; the engine runs the same without it.
+Telemetry *telemetry_create(const char *name, int rate);
+void telemetry_destroy(Telemetry *t, const char *name);
+
+// Writer side of the sequence (one writer: the audio thread)
+void telemetry_begin(Telemetry *t);
+void telemetry_end(Telemetry *t);
+
+// Map the named page read-only. Returns NULL if no synth is publishing (or
+// it is another build's layout).
+const Telemetry *telemetry_attach(const char *name);
+void telemetry_detach(const Telemetry *t);
+
+// Consistent copy of the page. Returns 0, or -1 if the writer kept it busy
+// (or stopped halfway through a block).
+int telemetry_read(const Telemetry *t, Telemetry *out);
+
+#endif // TELEMETRY_H
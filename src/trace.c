@@ -0,0 +1,157 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "trace.h"
+#include <stdio.h>
+
+#ifndef TRACING
+
+int trace_dump(const char *path) {
+    (void)path;
+    return -1;
+}
+
+#else
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define MASK (TRACE_EVENTS - 1)
+
+typedef struct {
+    uint64_t ns;
+    const char *name;
+    char phase;                 // 'B' or 'E'
+} TraceEvent;
+
+typedef struct {
+    const char *name;           // Set once by trace_thread
+    unsigned int head;          // Events written (one writer: the owning thread)
+    int full;                   // head has gone round the ring at least once
+    TraceEvent events[TRACE_EVENTS];
+} TraceRing;
+
+static TraceRing rings[TRACE_THREADS];
+static int ring_count;          // Rings handed out (claimed atomically)
+
+static __thread TraceRing *ring;
+static __thread int ring_claimed;
+
+// This thread's ring, claimed on first use (NULL once they have run out)
+static TraceRing *thread_ring(void) {
+    if (!ring_claimed) {
+        ring_claimed = 1;
+        int index = __atomic_fetch_add(&ring_count, 1, __ATOMIC_RELAXED);
+        if (index < TRACE_THREADS) ring = &rings[index];
+    }
+    return ring;
+}
+
+static void record(const char *name, char phase) {
+    TraceRing *r = thread_ring();
+    if (!r) return;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    TraceEvent *ev = &r->events[r->head & MASK];
+    ev->ns = (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+    ev->name = name;
+    ev->phase = phase;
+    if ((r->head & MASK) == MASK) __atomic_store_n(&r->full, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&r->head, r->head + 1, __ATOMIC_RELEASE);
+}
+
+void trace_begin(const char *name) {
+    record(name, 'B');
+}
+
+void trace_end(const char *name) {
+    record(name, 'E');
+}
+
+void trace_thread(const char *name) {
+    TraceRing *r = thread_ring();
+    if (r && !r->name) __atomic_store_n(&r->name, name, __ATOMIC_RELEASE);
+}
+
+// Copy a ring's newest events, dropping any the writer lapped while copying.
+// Returns the count; they end up at out[0..count).
+static int snapshot_ring(TraceRing *r, TraceEvent *out) {
+    // Counters wrap; differences between them stay right
+    unsigned int head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    unsigned int avail = __atomic_load_n(&r->full, __ATOMIC_RELAXED) ? TRACE_EVENTS : head;
+    unsigned int first = head - avail;
+    for (unsigned int i = 0; i < avail; i++) {
+        out[i] = r->events[(first + i) & MASK];
+    }
+
+    // Anything the writer has since overwritten is gone from the front
+    unsigned int now = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    unsigned int lapped = (now - first > TRACE_EVENTS) ? now - first - TRACE_EVENTS : 0;
+    if (lapped >= avail) return 0;
+    int count = (int)(avail - lapped);
+    for (int i = 0; i < count; i++) {
+        out[i] = out[i + lapped];
+    }
+    return count;
+}
+
+static void write_escaped(FILE *f, const char *s) {
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        fputc(*s, f);
+    }
+}
+
+int trace_dump(const char *path) {
+    TraceEvent *events = malloc(sizeof(TraceEvent) * TRACE_EVENTS);
+    if (!events) return -1;
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        free(events);
+        return -1;
+    }
+
+    int threads = __atomic_load_n(&ring_count, __ATOMIC_RELAXED);
+    if (threads > TRACE_THREADS) threads = TRACE_THREADS;
+
+    int written = 0;
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"ButterySynth\"}}");
+    for (int t = 0; t < threads; t++) {
+        TraceRing *r = &rings[t];
+        const char *name = __atomic_load_n(&r->name, __ATOMIC_ACQUIRE);
+        fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"", t + 1);
+        if (name) {
+            write_escaped(f, name);
+        } else {
+            fprintf(f, "thread %d", t + 1);
+        }
+        fprintf(f, "\"}}");
+
+        // Ends whose begin fell off the ring would close the wrong span
+        int count = snapshot_ring(r, events);
+        int depth = 0;
+        for (int i = 0; i < count; i++) {
+            const TraceEvent *ev = &events[i];
+            if (ev->phase == 'E') {
+                if (depth == 0) continue;
+                depth--;
+            } else {
+                depth++;
+            }
+            fprintf(f, ",\n{\"name\":\"");
+            write_escaped(f, ev->name);
+            fprintf(f, "\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":1,\"tid\":%d}", ev->phase,
+                    (unsigned long long)(ev->ns / 1000), (unsigned int)(ev->ns % 1000), t + 1);
+            written++;
+        }
+    }
+    fprintf(f, "\n]}\n");
+
+    free(events);
+    if (fclose(f) != 0) return -1;
+    return written;
+}
+
+#endif // TRACING
@@ -0,0 +1,35 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Hot-path trace recorder (builds with -DTRACING, see make TRACE=1).
+// TRACE_BEGIN/TRACE_END mark a span on the calling thread. Each thread writes
+// its own ring of timestamped events (CLOCK_MONOTONIC) without locks or
+// system calls beyond the clock, keeping the newest TRACE_EVENTS; trace_dump
+// writes every ring as a Chrome trace JSON file that opens in Perfetto
+// (ui.perfetto.dev) or chrome://tracing. Without TRACING the markers compile
+// to nothing.
+//
+// Span names must be string literals (only the pointer is stored).
+
+#define TRACE_THREADS 16        // Threads that get a ring; later ones are not traced
+#define TRACE_EVENTS  16384     // Events kept per thread (power of two)
+
+#ifdef TRACING
+void trace_begin(const char *name);
+void trace_end(const char *name);
+void trace_thread(const char *name);
+#define TRACE_BEGIN(name) trace_begin(name)
+#define TRACE_END(name)   trace_end(name)
+#define TRACE_THREAD(name) trace_thread(name)
+#else
+#define TRACE_BEGIN(name)  ((void)0)
+#define TRACE_END(name)    ((void)0)
+#define TRACE_THREAD(name) ((void)0)
+#endif
+
+// Write the recorded events to a Chrome trace JSON file (not real-time;
+// recording carries on meanwhile). Returns the events written, or -1 if the
+// file could not be written or tracing is not built in.
+int trace_dump(const char *path);
+
+#endif // TRACE_H
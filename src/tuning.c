@@ -0,0 +1,250 @@
+#include "tuning.h"
+#include "oscillator.h"  // for sample_rate
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+//------------------------------------------------------------------------------
+// Cents -> ratio tables
+//
+// A pitch offset splits into whole semitones (one table entry each) and the
+// remaining 0-100 cents (1-cent steps, linearly interpolated).
+//------------------------------------------------------------------------------
+#define SEMITONE_RANGE 128
+
+static float semitone_ratio[2 * SEMITONE_RANGE + 1];
+static float cent_ratio[101];
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+static void build_tables(void) {
+    for (int i = 0; i <= 2 * SEMITONE_RANGE; i++) {
+        semitone_ratio[i] = powf(2.0f, (i - SEMITONE_RANGE) / 12.0f);
+    }
+    for (int i = 0; i <= 100; i++) {
+        cent_ratio[i] = powf(2.0f, i / 1200.0f);
+    }
+}
+
+void tuning_tables_init(void) {
+    pthread_once(&tables_once, build_tables);
+}
+
+float cents_to_ratio(float cents) {
+    float limit = (SEMITONE_RANGE - 1) * 100.0f;
+    if (cents > limit) cents = limit;
+    if (cents < -limit) cents = -limit;
+
+    int semis = (int)floorf(cents * 0.01f);
+    float rest = cents - semis * 100.0f;
+    int i = (int)rest;
+    if (i > 99) i = 99;
+    float frac = rest - i;
+
+    float fine = cent_ratio[i] + frac * (cent_ratio[i + 1] - cent_ratio[i]);
+    return semitone_ratio[semis + SEMITONE_RANGE] * fine;
+}
+
+//------------------------------------------------------------------------------
+// Tables
+//------------------------------------------------------------------------------
+
+static uint32_t freq_to_increment(double freq) {
+    double inc = freq / sample_rate * 4294967296.0;
+    if (inc < 0.0) inc = 0.0;
+    if (inc > 2147483647.0) inc = 2147483647.0;  // Nyquist
+    return (uint32_t)inc;
+}
+
+void tuning_init_equal(Tuning *t) {
+    for (int n = 0; n < TUNING_NOTES; n++) {
+        t->increment[n] = freq_to_increment(440.0 * pow(2.0, (n - 69) / 12.0));
+        t->mapped[n] = 1;
+    }
+    snprintf(t->name, sizeof(t->name), "12-TET");
+}
+
+//------------------------------------------------------------------------------
+// Scala files
+//------------------------------------------------------------------------------
+
+typedef struct {
+    int size;               // Map size, 0 = linear (every key a degree)
+    int first, last;        // Retuned key range
+    int middle;             // Key for degree 0
+    int ref_note;
+    double ref_freq;
+    int octave_degree;      // Degree the mapping repeats at
+    int map[TUNING_MAX_DEGREES];   // -1 = unmapped key
+} KeyMap;
+
+// Next line that is not a comment, trimmed. Returns NULL at end of file.
+static char *next_line(FILE *f, char *buf, int size) {
+    while (fgets(buf, size, f)) {
+        if (buf[0] == '!') continue;
+        char *s = buf;
+        while (*s == ' ' || *s == '\t') s++;
+        char *end = s + strlen(s);
+        while (end > s && (end[-1] == '\n' || end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) {
+            *--end = '\0';
+        }
+        return s;
+    }
+    return NULL;
+}
+
+// Scale degree in cents: "701.955" is cents, "3/2" or "2" a ratio
+static int parse_pitch(const char *s, double *cents) {
+    char *end;
+    if (strchr(s, '.') && (!strchr(s, '/') || strchr(s, '.') < strchr(s, '/'))) {
+        *cents = strtod(s, &end);
+        return end != s ? 0 : -1;
+    }
+    long num = strtol(s, &end, 10);
+    long den = 1;
+    if (end == s) return -1;
+    if (*end == '/') {
+        const char *d = end + 1;
+        den = strtol(d, &end, 10);
+        if (end == d) return -1;
+    }
+    if (num <= 0 || den <= 0) return -1;
+    *cents = 1200.0 * log2((double)num / (double)den);
+    return 0;
+}
+
+static int read_scl(const char *path, double *scale, int *count, char *name, int name_size) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+
+    char buf[256];
+    char *line = next_line(f, buf, sizeof(buf));   // Description (may be blank)
+    if (line) snprintf(name, name_size, "%s", line);
+    line = line ? next_line(f, buf, sizeof(buf)) : NULL;
+    int n = line ? atoi(line) : 0;
+    if (n < 1 || n > TUNING_MAX_DEGREES) {
+        fclose(f);
+        return -1;
+    }
+
+    for (int i = 0; i < n; i++) {
+        line = next_line(f, buf, sizeof(buf));
+        if (!line || parse_pitch(line, &scale[i]) < 0) {
+            fclose(f);
+            return -1;
+        }
+    }
+    fclose(f);
+    *count = n;
+    return 0;
+}
+
+static void keymap_default(KeyMap *k) {
+    k->size = 0;
+    k->first = 0;
+    k->last = TUNING_NOTES - 1;
+    k->middle = 60;
+    k->ref_note = 69;
+    k->ref_freq = 440.0;
+    k->octave_degree = 0;
+}
+
+static int read_kbm(const char *path, KeyMap *k) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+
+    char buf[256];
+    double header[7];
+    for (int i = 0; i < 7; i++) {
+        char *line = next_line(f, buf, sizeof(buf));
+        if (!line) {
+            fclose(f);
+            return -1;
+        }
+        header[i] = atof(line);
+    }
+    k->size = (int)header[0];
+    k->first = (int)header[1];
+    k->last = (int)header[2];
+    k->middle = (int)header[3];
+    k->ref_note = (int)header[4];
+    k->ref_freq = header[5];
+    k->octave_degree = (int)header[6];
+    if (k->size < 0 || k->size > TUNING_MAX_DEGREES || k->ref_freq <= 0.0) {
+        fclose(f);
+        return -1;
+    }
+
+    // Entries missing at the end of the file are unmapped
+    for (int i = 0; i < k->size; i++) {
+        char *line = next_line(f, buf, sizeof(buf));
+        k->map[i] = (!line || line[0] == 'x' || line[0] == '\0') ? -1 : atoi(line);
+    }
+    fclose(f);
+    return 0;
+}
+
+static int floor_div(int a, int b) {
+    int q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+// Scale degree a key plays (0 if unmapped)
+static int key_degree(const KeyMap *k, int note, int *degree) {
+    if (note < k->first || note > k->last) return 0;
+    int offset = note - k->middle;
+    if (k->size == 0) {
+        *degree = offset;
+        return 1;
+    }
+    int octave = floor_div(offset, k->size);
+    int index = offset - octave * k->size;
+    if (k->map[index] < 0) return 0;
+    *degree = octave * k->octave_degree + k->map[index];
+    return 1;
+}
+
+static double degree_cents(const double *scale, int count, int degree) {
+    int octave = floor_div(degree, count);
+    int step = degree - octave * count;
+    return octave * scale[count - 1] + (step ? scale[step - 1] : 0.0);
+}
+
+int tuning_load_scala(Tuning *t, const char *scl_path, const char *kbm_path) {
+    double scale[TUNING_MAX_DEGREES];
+    int count;
+    char name[TUNING_NAME_LEN] = "";
+    if (read_scl(scl_path, scale, &count, name, sizeof(name)) < 0) return -1;
+
+    KeyMap k;
+    keymap_default(&k);
+    if (kbm_path && read_kbm(kbm_path, &k) < 0) keymap_default(&k);
+    if (k.size > 0 && k.octave_degree == 0) k.octave_degree = count;
+
+    // The reference key must play a degree so the scale can be anchored
+    int ref_degree = 0;
+    if (!key_degree(&k, k.ref_note, &ref_degree)) {
+        KeyMap linear = k;
+        linear.size = 0;
+        linear.first = 0;
+        linear.last = TUNING_NOTES - 1;
+        key_degree(&linear, k.ref_note, &ref_degree);
+    }
+    double ref_cents = degree_cents(scale, count, ref_degree);
+
+    Tuning out;
+    for (int n = 0; n < TUNING_NOTES; n++) {
+        int degree;
+        out.mapped[n] = (unsigned char)key_degree(&k, n, &degree);
+        if (out.mapped[n]) {
+            double cents = degree_cents(scale, count, degree) - ref_cents;
+            out.increment[n] = freq_to_increment(k.ref_freq * pow(2.0, cents / 1200.0));
+        } else {
+            out.increment[n] = 0;
+        }
+    }
+    snprintf(out.name, sizeof(out.name), "%s", name[0] ? name : scl_path);
+    *t = out;
+    return 0;
+}
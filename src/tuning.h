@@ -0,0 +1,36 @@
+#ifndef TUNING_H
+#define TUNING_H
+
+#include <stdint.h>
+
+// Note tuning: a phase increment per MIDI note, so starting a note is a table
+// read instead of a powf. Built from 12-TET or a Scala scale (.scl) with an
+// optional keyboard mapping (.kbm). Parsing does file I/O and runs off the
+// audio thread; the finished table is copied into the synth.
+
+#define TUNING_NOTES 128
+#define TUNING_NAME_LEN 64
+#define TUNING_MAX_DEGREES 128
+
+typedef struct {
+    uint32_t increment[TUNING_NOTES];     // Phase step per sample (2^32 = one cycle)
+    unsigned char mapped[TUNING_NOTES];   // 0 = key left unmapped by the .kbm
+    char name[TUNING_NAME_LEN];           // Scale description
+} Tuning;
+
+// Equal temperament, A4 (note 69) = 440 Hz
+void tuning_init_equal(Tuning *t);
+
+// Load a Scala scale and optional keyboard mapping (kbm_path NULL or missing
+// file = note 60 on the first degree, A4 = 440 Hz). Returns 0, or -1 with t
+// unchanged if the scale cannot be read.
+int tuning_load_scala(Tuning *t, const char *scl_path, const char *kbm_path);
+
+// Frequency ratio for a pitch offset in cents (two table reads and a
+// multiply; range +-128 semitones)
+float cents_to_ratio(float cents);
+
+// Build the shared cents tables (thread-safe, runs once; called from synth_init)
+void tuning_tables_init(void);
+
+#endif // TUNING_H
@@ -1,7 +1,9 @@
 #include "ui.h"
 #include "preset.h"
+#include "param.h"
 #include <string.h>
 #include <stdio.h>
+#include <math.h>
 #include <stdbool.h>
 
 // Physical display dimensions (must match main.c)
@@ -37,90 +39,206 @@ static Vector2 GetTransformedTouch(void) {
 #define SLIDER_FG     (Color){100, 180, 255, 255}
 #define TEXT_COLOR    (Color){220, 220, 230, 255}
 #define WAVE_COLOR    (Color){80, 255, 120, 255}
+#define LEARN_COLOR   (Color){255, 180, 60, 255}
 
-// Control IDs
-enum {
-    CTRL_NONE = -1,
-    CTRL_WAVE_TYPE,
-    CTRL_WAVE_TYPE2,
-    CTRL_OSC_MIX,
-    CTRL_OSC2_DETUNE,
-    CTRL_SUB_OSC_MIX,
-    CTRL_FILTER_TYPE,
-    CTRL_FILTER_CUTOFF,
-    CTRL_FILTER_RESO,
-    CTRL_ATTACK,
-    CTRL_DECAY,
-    CTRL_SUSTAIN,
-    CTRL_RELEASE,
-    CTRL_DELAY_TIME,
-    CTRL_DELAY_MIX,
-    CTRL_REVERB_SIZE,
-    CTRL_REVERB_MIX,
-    CTRL_DIST_DRIVE,
-    CTRL_DIST_MIX,
-    CTRL_VOLUME,
-    CTRL_LFO_RATE,
-    CTRL_LFO_DEPTH,
-    CTRL_FILT_ENV_AMT,
-    CTRL_PULSE_WIDTH,
-    CTRL_PWM_RATE,
-    CTRL_PWM_DEPTH,
-    CTRL_UNISON_COUNT,
-    CTRL_UNISON_SPREAD
-};
+// Scope and spectrum display
+#define SCOPE_IDLE_SPAN   1024.0f   // Samples shown when no note is playing
+#define SCOPE_FALL_DB     1.5f      // Spectrum peak fall per frame
+#define SPECTRUM_LOW_HZ   30.0f     // Left edge of the log frequency axis
+#define GR_METER_RANGE    12.0f     // Gain reduction at full meter height, dB
+
+// Active control: a ParamId while dragging a parameter slider, or one of
+// the UI-only controls below
+#define CTRL_NONE -1
+#define CTRL_PART_SEND PARAM_COUNT
 
 static const char *WAVE_NAMES[] = {"SIN", "SQR", "SAW", "TRI", "NSE", "WT"};
 static const char *FILTER_NAMES[] = {"LP", "HP", "BP"};
+static const char *DELAY_MODES[] = {"ST", "PING"};
 static const char *WT_NAMES[] = {"Basic", "PWM", "Harm", "Fmt"};
 static const char *LFO_NAMES[] = {"SIN", "TRI", "SAW", "SQR"};
 static const char *PAGE_NAMES[] = {"OSC", "FLT", "FX", "MOD", "ARP", "PRE", "SET"};
 static const char *ARP_PATTERN_NAMES[] = {"Up", "Down", "UpDn", "Rand", "Play"};
 static const char *ARP_DIV_NAMES[] = {"1/4", "1/8", "1/16", "1/32"};
-static const char *BUFFER_NAMES[] = {"512", "256", "128"};
+static const char *BUFFER_NAMES[] = {"512", "256", "128", "AUTO"};
 
-void ui_init(UI *ui, Synth *synth, Effects *effects, Arpeggiator *arp) {
+void ui_init(UI *ui, Synth *synth, Effects *effects, Arpeggiator *arp, MidiMap *midimap) {
     ui->synth = synth;
     ui->effects = effects;
     ui->arp = arp;
+    ui->params = (ParamContext){synth, effects, arp};
+    ui->bank = NULL;
+    ui->midimap = midimap;
+    ui->multi = NULL;
+    ui->selected_part = 0;
     ui->current_page = 0;
-    ui->selected_wave = synth->wave_type;
-    ui->selected_wave2 = synth->wave_type2;
-    ui->selected_filter = synth->filter_type;
-    ui->selected_lfo = synth->lfo_type;
     ui->current_preset = 1;
     strcpy(ui->preset_name, "Init");
     ui->editing_name = false;
     ui->buffer_size = 1;  // Default to 256 (index 1)
+    ui->buffer_auto = true;
     ui->panic_triggered = false;
     ui->buffer_changed = false;
+    ui->load_requested = false;
+    ui->preset_xfade = true;
+    ui->midi_learn = false;
+    ui->learn_param = -1;
+    ui->tuning_reload = false;
+    ui->snapshot_save = false;
+    ui->snapshot_restore = false;
+    strcpy(ui->tuning_name, "12-TET");
     ui->active_control = CTRL_NONE;
-    ui->waveform_pos = 0;
+    ui->scope = NULL;
+    ui->scope_valid = false;
+    ui->limiter_gr = 0.0f;
+    ui->chrome_cached = false;
+    ui->chrome_pass = false;
+    ui->full_redraw = true;
+    ui->redraw_all = true;
+    ui->layout_key = 0;
+    ui->widget_count = 0;
+    ui->last_widget_count = 0;
+    ui->widgets_drawn = 0;
+    ui->frame_ms = 0.0f;
+    ui->frame_cpu = 0.0f;
+    ui->frame_redrawn = 0.0f;
+    ui->idle_audio = false;
+    ui->idle_ui = false;
+    ui->shown_preset = -1;
     ui->last_touch_x = 0;
     ui->last_touch_y = 0;
     ui->was_touching = false;
-    memset(ui->waveform_buffer, 0, sizeof(ui->waveform_buffer));
+    memset(ui->scope_buffer, 0, sizeof(ui->scope_buffer));
+    memset(ui->widget_state, 0, sizeof(ui->widget_state));
+    spectrum_init(&ui->spectrum);
+}
+
+//------------------------------------------------------------------------------
+// Dirty regions
+//
+// The controls area is not cleared between frames. Panel backgrounds, titles
+// and fixed labels ("chrome") are rendered once per page into ui->chrome and
+// blitted on full redraws. Everything that shows state is a widget: widgets
+// are numbered in draw order, and each frame a widget hashes what it would
+// show; only when that differs from the last frame is its area restored from
+// the chrome and repainted. Input handling always runs.
+
+// FNV-1a, for widget state
+static unsigned int hash_add(unsigned int h, const void *data, size_t size) {
+    const unsigned char *p = data;
+    if (h == 0) h = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
+
+static unsigned int hash_int(unsigned int h, int v) {
+    return hash_add(h, &v, sizeof(v));
+}
+
+static unsigned int hash_str(unsigned int h, const char *s) {
+    return hash_add(h, s, strlen(s));
+}
+
+// Chrome is drawn while building the cache, or directly on every frame when
+// there is no cache
+static bool chrome_visible(const UI *ui) {
+    return ui->chrome_pass || (ui->full_redraw && !ui->chrome_cached);
+}
+
+static void draw_panel(UI *ui, int x, int y, int w, int h, const char *title) {
+    if (!chrome_visible(ui)) return;
+    DrawRectangle(x, y, w, h, PANEL_COLOR);
+    if (title) DrawText(title, x + 10, y + 5, 16, TEXT_COLOR);
+}
+
+static void draw_label(UI *ui, const char *text, int x, int y, int size, Color color) {
+    if (chrome_visible(ui)) DrawText(text, x, y, size, color);
+}
+
+// Fixed button (chrome)
+static void draw_static_button(UI *ui, Rectangle btn, Color color, const char *text,
+                               int text_dx, int text_dy, int size, Color text_color) {
+    if (!chrome_visible(ui)) return;
+    DrawRectangleRec(btn, color);
+    DrawText(text, btn.x + text_dx, btn.y + text_dy, size, text_color);
 }
 
-// Draw a horizontal slider, returns new value if changed
-static float draw_slider(const char *label, float value, float min, float max,
-                        int x, int y, int ctrl_id, UI *ui) {
-    // Label
-    DrawText(label, x, y + 2, 16, TEXT_COLOR);
+// Put the chrome back under a widget before repainting it
+static void restore_area(UI *ui, Rectangle area) {
+    // Render textures are stored bottom-up
+    Rectangle src = {area.x, UI_CHROME_HEIGHT - area.y - area.height, area.width, -area.height};
+    DrawTextureRec(ui->chrome[ui->current_page].texture, src, (Vector2){area.x, area.y}, WHITE);
+}
 
-    // Slider background
+// Next widget in draw order, covering area and showing state. Returns true if
+// it has to be painted (its area has then been restored already).
+static bool widget_begin(UI *ui, Rectangle area, unsigned int state) {
+    if (ui->chrome_pass) return false;
+
+    state = hash_add(state, &area, sizeof(area));
+    int i = ui->widget_count++;
+    bool dirty = ui->full_redraw || i >= UI_MAX_WIDGETS || ui->widget_state[i] != state;
+    if (i < UI_MAX_WIDGETS) ui->widget_state[i] = state;
+    if (!dirty) return false;
+
+    if (!ui->full_redraw) restore_area(ui, area);
+    ui->widgets_drawn++;
+    return true;
+}
+
+// Touch press this frame (never while building the chrome)
+static bool pressed(const UI *ui) {
+    return !ui->chrome_pass && IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
+}
+
+//------------------------------------------------------------------------------
+// Widgets
+
+// Draw a horizontal slider at a normalized position; returns the new position
+// while it is being dragged (otherwise the one passed in). ctrl_id is a
+// ParamId for registry parameters (which can be MIDI-learned) or a CTRL_* id.
+// The value text is only formatted when the slider is repainted.
+static float draw_slider(UI *ui, const char *label, float norm, float value, bool integer,
+                         int x, int y, int ctrl_id) {
     Rectangle slider_rect = {x + LABEL_WIDTH, y, SLIDER_WIDTH, SLIDER_HEIGHT};
-    DrawRectangleRec(slider_rect, SLIDER_BG);
+    bool learning = ui->midi_learn && ctrl_id < PARAM_COUNT;
+    bool highlight = learning && ui->learn_param == ctrl_id;
+
+    unsigned int state = hash_int(0, (int)(SLIDER_WIDTH * norm));
+    state = hash_add(state, &value, sizeof(value));
+    state = hash_int(state, highlight);
+    Rectangle area = {x, y - 2, LABEL_WIDTH + SLIDER_WIDTH + 80, SLIDER_HEIGHT + 4};
+
+    if (widget_begin(ui, area, state)) {
+        DrawText(label, x, y + 2, 16, TEXT_COLOR);
+        DrawRectangleRec(slider_rect, SLIDER_BG);
+        DrawRectangle(x + LABEL_WIDTH, y, (int)(SLIDER_WIDTH * norm), SLIDER_HEIGHT, SLIDER_FG);
+
+        char val_str[16];
+        if (integer) {
+            snprintf(val_str, sizeof(val_str), "%d", (int)value);
+        } else {
+            snprintf(val_str, sizeof(val_str), "%.2f", value);
+        }
+        DrawText(val_str, x + LABEL_WIDTH + SLIDER_WIDTH + 5, y + 2, 16, TEXT_COLOR);
 
-    // Slider fill
-    float norm = (value - min) / (max - min);
-    Rectangle fill_rect = {x + LABEL_WIDTH, y, SLIDER_WIDTH * norm, SLIDER_HEIGHT};
-    DrawRectangleRec(fill_rect, SLIDER_FG);
+        if (highlight) {
+            DrawRectangleLinesEx((Rectangle){slider_rect.x - 2, slider_rect.y - 2,
+                                             slider_rect.width + 4, slider_rect.height + 4},
+                                 2, LEARN_COLOR);
+        }
+    }
+    if (ui->chrome_pass) return norm;
 
-    // Value text
-    char val_str[16];
-    snprintf(val_str, sizeof(val_str), "%.2f", value);
-    DrawText(val_str, x + LABEL_WIDTH + SLIDER_WIDTH + 5, y + 2, 16, TEXT_COLOR);
+    // In learn mode a tap selects the parameter instead of changing it
+    if (ui->midi_learn) {
+        if (learning && pressed(ui) && CheckCollisionPointRec(GetTransformedTouch(), slider_rect)) {
+            ui->learn_param = ctrl_id;
+        }
+        return norm;
+    }
 
     // Touch/mouse handling
     bool pressing = IsMouseButtonDown(MOUSE_LEFT_BUTTON);
@@ -140,7 +258,7 @@ static float draw_slider(const char *label, float value, float min, float max,
             float new_norm = (mouse.x - slider_rect.x) / slider_rect.width;
             if (new_norm < 0) new_norm = 0;
             if (new_norm > 1) new_norm = 1;
-            return min + new_norm * (max - min);
+            return new_norm;
         }
     } else if (!pressing) {
         // Released - clear active control
@@ -149,31 +267,51 @@ static float draw_slider(const char *label, float value, float min, float max,
         }
     }
 
-    return value;
+    return norm;
 }
 
-// Draw button row, returns selected index
-static int draw_button_row(const char *label, const char **options, int count,
-                          int selected, int x, int y) {
-    DrawText(label, x, y + 5, 14, TEXT_COLOR);
+// Slider for a registry parameter (range, curve and label come from the table)
+static void draw_param_slider(UI *ui, ParamId id, int x, int y) {
+    const ParamDesc *d = param_desc(id);
+    float value = param_get(&ui->params, id);
+
+    float norm = param_to_normalized(id, value);
+    float new_norm = draw_slider(ui, d->label, norm, value, d->type == PARAM_INT, x, y, id);
+    if (new_norm != norm) {
+        param_set_normalized(&ui->params, id, new_norm);
+    }
+}
 
+// Draw button row, returns selected index. highlight outlines the row
+// (MIDI learn target).
+static int draw_button_row(UI *ui, const char *label, const char **options, int count,
+                           int selected, bool highlight, int x, int y) {
     int btn_x = x + LABEL_WIDTH;
     int btn_width = 44;
     int btn_height = 22;
 
-    for (int i = 0; i < count; i++) {
-        Rectangle btn = {btn_x + i * (btn_width + 3), y, btn_width, btn_height};
-
-        Color btn_color = (i == selected) ? SLIDER_FG : SLIDER_BG;
-        DrawRectangleRec(btn, btn_color);
-
-        int text_width = MeasureText(options[i], 10);
-        DrawText(options[i], btn.x + (btn_width - text_width) / 2, btn.y + 6, 10,
-                 (i == selected) ? BG_COLOR : TEXT_COLOR);
+    Rectangle area = {x, y - 2, LABEL_WIDTH + count * (btn_width + 3) + 1, btn_height + 4};
+    unsigned int state = hash_int(hash_int(0, selected), highlight);
+    if (widget_begin(ui, area, state)) {
+        DrawText(label, x, y + 5, 14, TEXT_COLOR);
+        for (int i = 0; i < count; i++) {
+            Rectangle btn = {btn_x + i * (btn_width + 3), y, btn_width, btn_height};
+            DrawRectangleRec(btn, (i == selected) ? SLIDER_FG : SLIDER_BG);
+
+            int text_width = MeasureText(options[i], 10);
+            DrawText(options[i], btn.x + (btn_width - text_width) / 2, btn.y + 6, 10,
+                     (i == selected) ? BG_COLOR : TEXT_COLOR);
+        }
+        if (highlight) {
+            DrawRectangleLines(btn_x - 2, y - 2, count * (btn_width + 3) + 1, btn_height + 4, LEARN_COLOR);
+        }
+    }
 
-        // Touch handling
-        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-            Vector2 mouse = GetTransformedTouch();
+    // Touch handling
+    if (pressed(ui)) {
+        Vector2 mouse = GetTransformedTouch();
+        for (int i = 0; i < count; i++) {
+            Rectangle btn = {btn_x + i * (btn_width + 3), y, btn_width, btn_height};
             if (CheckCollisionPointRec(mouse, btn)) {
                 return i;
             }
@@ -183,31 +321,187 @@ static int draw_button_row(const char *label, const char **options, int count,
     return selected;
 }
 
+// Button row for an integer (enum) parameter
+static void draw_param_buttons(UI *ui, ParamId id, const char **options, int count, int x, int y) {
+    int selected = (int)param_get(&ui->params, id);
+    bool highlight = ui->midi_learn && ui->learn_param == (int)id;
+    int new_sel = draw_button_row(ui, param_desc(id)->label, options, count, selected, highlight, x, y);
+    if (new_sel != selected) {
+        if (ui->midi_learn) {
+            ui->learn_param = id;
+        } else {
+            param_set(&ui->params, id, (float)new_sel);
+        }
+    }
+}
+
+// Oscillator waveform select: SIN..NSE on one row, WT on a second row
+static void draw_wave_select(UI *ui, ParamId id, int x, int y) {
+    int selected = (int)param_get(&ui->params, id);
+    int new_wave = draw_button_row(ui, param_desc(id)->label, WAVE_NAMES, 5, selected, false, x, y);
+    // Second row: WT only (aligned under SIN)
+    int wt_sel = draw_button_row(ui, "", WAVE_NAMES + 5, 1, (selected == WAVE_WAVETABLE) ? 0 : -1,
+                                 false, x, y + 25);
+    if (wt_sel == 0 && selected != WAVE_WAVETABLE) {
+        new_wave = WAVE_WAVETABLE;
+    }
+    if (new_wave != selected) {
+        param_set(&ui->params, id, (float)new_wave);
+    }
+}
+
+// Point the editor at another part (its synth, arp and preset name)
+static void select_part(UI *ui, int index) {
+    Part *p = &ui->multi->parts[index];
+    ui->selected_part = index;
+    ui->synth = &p->synth;
+    ui->arp = &p->arp;
+    ui->params = (ParamContext){&p->synth, ui->effects, &p->arp};
+    snprintf(ui->preset_name, sizeof(ui->preset_name), "%s", p->preset_name);
+    ui->active_control = CTRL_NONE;
+    ui->learn_param = -1;
+}
+
+// Period in samples of the lowest sounding note across the parts, 0 if none
+// (caller holds the engine lock). A sub oscillator halves the fundamental.
+static float lowest_period(const UI *ui) {
+    float longest = 0.0f;
+    int parts = ui->multi ? MAX_PARTS : 1;
+    for (int p = 0; p < parts; p++) {
+        if (ui->multi && !ui->multi->parts[p].enabled) continue;
+        const Synth *s = ui->multi ? &ui->multi->parts[p].synth : ui->synth;
+        for (int i = 0; i < NUM_VOICES; i++) {
+            const Voice *v = &s->voices[i];
+            if (!voice_is_active(v) || v->osc.increment == 0) continue;
+            float period = PHASE_CYCLE / (float)v->osc.increment;
+            if (v->sub_osc_mix > 0.0f) period *= 2.0f;
+            if (period > longest) longest = period;
+        }
+    }
+    return longest;
+}
+
+// Master limiter gain reduction: a bar hanging from the top right of the
+// scope, with the amount while it is limiting
+static void draw_gr_meter(UI *ui, int x, int y, int h) {
+    float gr = ui->limiter_gr;
+    if (gr < 0.05f) return;
+
+    float fill = gr / GR_METER_RANGE;
+    if (fill > 1.0f) fill = 1.0f;
+    DrawRectangle(x, y + 5, 4, (int)(fill * (h - 10)), LEARN_COLOR);
+
+    char gr_str[16];
+    snprintf(gr_str, sizeof(gr_str), "GR %.1f dB", gr);
+    DrawText(gr_str, x - 80, y + 5, 12, LEARN_COLOR);
+}
+
+// Oscilloscope: two cycles of the lowest note, starting at the steepest
+// rising zero crossing so the trace holds still from frame to frame.
+// Free-running when nothing is playing.
+static void draw_scope(UI *ui, int x, int y, int w, int h) {
+    DrawRectangle(x, y, w, h, PANEL_COLOR);
+    draw_gr_meter(ui, x + w - 6, y, h);
+    if (!ui->scope_valid) return;
+
+    const float *buf = ui->scope_buffer;
+    const int n = UI_SCOPE_SAMPLES;
+
+    float period = lowest_period(ui);
+    float span = (period > 0.0f) ? 2.0f * period : SCOPE_IDLE_SPAN;
+    if (span > n / 2) span = n / 2;
+
+    // Search one period ending where the newest complete window starts
+    float start = n - span - 2;
+    if (period > 0.0f) {
+        int last = (int)start;
+        int first = last - (int)period;
+        if (first < 1) first = 1;
+        float steepest = 0.0f;
+        for (int i = first; i <= last; i++) {
+            float a = buf[i - 1], b = buf[i];
+            if (a < 0.0f && b >= 0.0f && b - a > steepest) {
+                steepest = b - a;
+                start = (i - 1) + a / (a - b);
+            }
+        }
+    }
+
+    int cols = w - 10;
+    int center_y = y + h / 2;
+    float amp = h / 2 - 5;
+    int prev_y = center_y;
+    for (int c = 0; c <= cols; c++) {
+        float t = start + c * span / cols;
+        int i = (int)t;
+        float v = buf[i] + (buf[i + 1] - buf[i]) * (t - i);
+        int y_pos = center_y - (int)(v * amp);
+        if (c > 0) {
+            DrawLine(x + 4 + c, prev_y, x + 5 + c, y_pos, WAVE_COLOR);
+        }
+        prev_y = y_pos;
+    }
+}
+
+// Spectrum: log frequency from SPECTRUM_LOW_HZ to Nyquist, each column
+// showing the loudest bin it covers
+static void draw_spectrum(UI *ui, int x, int y, int w, int h) {
+    DrawRectangle(x, y, w, h, PANEL_COLOR);
+    if (!ui->scope_valid) return;
+
+    const float *db = ui->spectrum.db;
+    float bin_hz = sample_rate / SPECTRUM_SIZE;
+    float octaves = log2f(sample_rate * 0.5f / SPECTRUM_LOW_HZ);
+    int cols = w - 10;
+    int base_y = y + h - 5;
+    float range = h - 10;
+
+    int lo = (int)(SPECTRUM_LOW_HZ / bin_hz);
+    for (int c = 0; c < cols; c++) {
+        float hz = SPECTRUM_LOW_HZ * exp2f(octaves * (c + 1) / cols);
+        int hi = (int)(hz / bin_hz);
+        if (hi >= SPECTRUM_BINS) hi = SPECTRUM_BINS - 1;
+        if (hi < lo) hi = lo;
+
+        float level = db[lo];
+        for (int k = lo + 1; k <= hi; k++) {
+            if (db[k] > level) level = db[k];
+        }
+        lo = hi;
+
+        int bar = (int)((level - SPECTRUM_FLOOR) / -SPECTRUM_FLOOR * range);
+        if (bar > 0) {
+            DrawLine(x + 5 + c, base_y, x + 5 + c, base_y - bar, SLIDER_FG);
+        }
+    }
+}
+
 void ui_update(UI *ui) {
     // Input handling is done in ui_draw for touch controls
     (void)ui;  // Suppress unused warning
 }
 
-void ui_draw(UI *ui) {
+// Tabs, part selector and the current page's panels: chrome and widgets
+static void draw_controls(UI *ui) {
     Synth *s = ui->synth;
     Effects *fx = ui->effects;
 
-    ClearBackground(BG_COLOR);
-
-    // Page tabs at top
+    // Page tabs at top (chrome: each page's cache shows its own tab selected)
     int tab_width = 48;
     int tab_height = 30;
     int tab_y = 5;
-    for (int i = 0; i < 7; i++) {
+    for (int i = 0; i < UI_PAGE_COUNT; i++) {
         Rectangle tab = {PANEL_MARGIN + i * (tab_width + 5), tab_y, tab_width, tab_height};
-        Color tab_color = (i == ui->current_page) ? SLIDER_FG : SLIDER_BG;
-        DrawRectangleRec(tab, tab_color);
-        int tw = MeasureText(PAGE_NAMES[i], 14);
-        DrawText(PAGE_NAMES[i], tab.x + (tab_width - tw) / 2, tab.y + 8, 14,
-                 (i == ui->current_page) ? BG_COLOR : TEXT_COLOR);
+        if (chrome_visible(ui)) {
+            Color tab_color = (i == ui->current_page) ? SLIDER_FG : SLIDER_BG;
+            DrawRectangleRec(tab, tab_color);
+            int tw = MeasureText(PAGE_NAMES[i], 14);
+            DrawText(PAGE_NAMES[i], tab.x + (tab_width - tw) / 2, tab.y + 8, 14,
+                     (i == ui->current_page) ? BG_COLOR : TEXT_COLOR);
+        }
 
         // Touch handling for tabs
-        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        if (pressed(ui)) {
             Vector2 mouse = GetTransformedTouch();
             if (CheckCollisionPointRec(mouse, tab)) {
                 ui->current_page = i;
@@ -215,6 +509,43 @@ void ui_draw(UI *ui) {
         }
     }
 
+    // Part selector beside the tabs
+    if (ui->multi) {
+        int part_x = PANEL_MARGIN + UI_PAGE_COUNT * (tab_width + 5) + 20;
+        draw_label(ui, "PART", part_x, tab_y + 8, 14, TEXT_COLOR);
+        part_x += 45;
+
+        const char *part_name = ui->multi->parts[ui->selected_part].preset_name;
+        unsigned int state = hash_str(hash_int(0, ui->selected_part), part_name);
+        for (int i = 0; i < MAX_PARTS; i++) {
+            state = hash_int(state, ui->multi->parts[i].enabled);
+        }
+        Rectangle area = {part_x, tab_y, SCREEN_WIDTH - 90 - part_x, tab_height};
+        bool paint = widget_begin(ui, area, state);
+
+        for (int i = 0; i < MAX_PARTS; i++) {
+            Rectangle btn = {part_x + i * 35, tab_y, 30, tab_height};
+            bool selected = (i == ui->selected_part);
+            if (paint) {
+                Color col = selected ? SLIDER_FG : (ui->multi->parts[i].enabled ? SLIDER_BG : PANEL_COLOR);
+                DrawRectangleRec(btn, col);
+                char num[4];
+                snprintf(num, sizeof(num), "%d", i + 1);
+                DrawText(num, btn.x + 11, btn.y + 8, 14, selected ? BG_COLOR : TEXT_COLOR);
+            }
+
+            if (pressed(ui) && !ui->editing_name) {
+                Vector2 mouse = GetTransformedTouch();
+                if (CheckCollisionPointRec(mouse, btn) && !selected) {
+                    select_part(ui, i);
+                }
+            }
+        }
+        if (paint) {
+            DrawText(part_name, part_x + MAX_PARTS * 35 + 10, tab_y + 8, 14, WAVE_COLOR);
+        }
+    }
+
     int panel_y = tab_y + tab_height + 10;
     int panel_x = PANEL_MARGIN;
     int content_height = PANEL_HEIGHT - 10;
@@ -222,322 +553,205 @@ void ui_draw(UI *ui) {
     // Draw page content based on current page
     if (ui->current_page == 0) {
         // OSC PAGE: OSC1 + OSC2 + Mix
-        DrawRectangle(panel_x, panel_y, PANEL_WIDTH + 20, content_height, PANEL_COLOR);
-        DrawText("OSC 1", panel_x + 10, panel_y + 5, 16, TEXT_COLOR);
-        // First row: SIN, SQR, SAW, TRI, NSE
-        int new_wave = draw_button_row("Wave", WAVE_NAMES, 5, ui->selected_wave,
-                                       panel_x + 10, panel_y + 25);
-        // Second row: WT only (aligned under SIN)
-        int wt_sel = draw_button_row("", WAVE_NAMES + 5, 1,
-                                     (ui->selected_wave == 5) ? 0 : -1,
-                                     panel_x + 10, panel_y + 50);
-        if (wt_sel == 0 && ui->selected_wave != 5) {
-            new_wave = 5;  // WT selected
-        }
-        if (new_wave != ui->selected_wave) {
-            ui->selected_wave = new_wave;
-            synth_set_wave_type(s, (WaveType)new_wave);
-        }
+        draw_panel(ui, panel_x, panel_y, PANEL_WIDTH + 20, content_height, "OSC 1");
+        draw_wave_select(ui, PARAM_WAVE1, panel_x + 10, panel_y + 25);
 
         // Show wavetable controls if WT selected for OSC1
         if (s->wave_type == WAVE_WAVETABLE) {
-            int new_wt = draw_button_row("Table", WT_NAMES, 4, (int)s->wavetable_type,
-                                         panel_x + 10, panel_y + 75);
-            if (new_wt != (int)s->wavetable_type) {
-                synth_set_wavetable(s, (WavetableType)new_wt);
-            }
-            float new_pos = draw_slider("Pos", s->wt_position, 0.0f, 1.0f,
-                                        panel_x + 10, panel_y + 100, CTRL_NONE, ui);
-            if (new_pos != s->wt_position) {
-                synth_set_wt_position(s, new_pos);
-            }
+            draw_param_buttons(ui, PARAM_WAVETABLE, WT_NAMES, 4, panel_x + 10, panel_y + 75);
+            draw_param_slider(ui, PARAM_WT_POSITION, panel_x + 10, panel_y + 100);
         }
 
         panel_x += PANEL_WIDTH + 20 + PANEL_MARGIN;
-        DrawRectangle(panel_x, panel_y, PANEL_WIDTH + 20, content_height, PANEL_COLOR);
-        DrawText("OSC 2", panel_x + 10, panel_y + 5, 16, TEXT_COLOR);
-        // First row: SIN, SQR, SAW, TRI, NSE
-        int new_wave2 = draw_button_row("Wave", WAVE_NAMES, 5, ui->selected_wave2,
-                                        panel_x + 10, panel_y + 25);
-        // Second row: WT only (aligned under SIN)
-        int wt_sel2 = draw_button_row("", WAVE_NAMES + 5, 1,
-                                      (ui->selected_wave2 == 5) ? 0 : -1,
-                                      panel_x + 10, panel_y + 50);
-        if (wt_sel2 == 0 && ui->selected_wave2 != 5) {
-            new_wave2 = 5;  // WT selected
-        }
-        if (new_wave2 != ui->selected_wave2) {
-            ui->selected_wave2 = new_wave2;
-            synth_set_wave_type2(s, (WaveType)new_wave2);
-        }
+        draw_panel(ui, panel_x, panel_y, PANEL_WIDTH + 20, content_height, "OSC 2");
+        draw_wave_select(ui, PARAM_WAVE2, panel_x + 10, panel_y + 25);
 
         panel_x += PANEL_WIDTH + 20 + PANEL_MARGIN;
-        DrawRectangle(panel_x, panel_y, PANEL_WIDTH, content_height, PANEL_COLOR);
-        DrawText("MIX", panel_x + 10, panel_y + 5, 16, TEXT_COLOR);
-        float new_mix = draw_slider("O1/O2", s->osc_mix, 0.0f, 1.0f,
-                                    panel_x + 10, panel_y + 30, CTRL_OSC_MIX, ui);
-        if (new_mix != s->osc_mix) {
-            synth_set_osc_mix(s, new_mix);
-        }
-        float new_detune = draw_slider("Det", s->osc2_detune, -100.0f, 100.0f,
-                                       panel_x + 10, panel_y + 60, CTRL_OSC2_DETUNE, ui);
-        if (new_detune != s->osc2_detune) {
-            synth_set_osc2_detune(s, new_detune);
-        }
-        float new_sub = draw_slider("Sub", s->sub_osc_mix, 0.0f, 1.0f,
-                                    panel_x + 10, panel_y + 90, CTRL_SUB_OSC_MIX, ui);
-        if (new_sub != s->sub_osc_mix) {
-            synth_set_sub_osc_mix(s, new_sub);
-        }
-        s->volume = draw_slider("Vol", s->volume, 0.0f, 1.0f,
-                                panel_x + 10, panel_y + 120, CTRL_VOLUME, ui);
+        draw_panel(ui, panel_x, panel_y, PANEL_WIDTH, content_height, "MIX");
+        draw_param_slider(ui, PARAM_OSC_MIX, panel_x + 10, panel_y + 30);
+        draw_param_slider(ui, PARAM_OSC2_DETUNE, panel_x + 10, panel_y + 60);
+        draw_param_slider(ui, PARAM_SUB_MIX, panel_x + 10, panel_y + 90);
+        draw_param_slider(ui, PARAM_VOLUME, panel_x + 10, panel_y + 120);
 
         // UNISON panel (compact)
         panel_x += PANEL_WIDTH + PANEL_MARGIN;
-        DrawRectangle(panel_x, panel_y, SLIDER_WIDTH + LABEL_WIDTH + 70, content_height, PANEL_COLOR);
-        DrawText("UNI", panel_x + 10, panel_y + 5, 16, TEXT_COLOR);
-
-        // Unison count as slider (1-7)
-        float uni_val = draw_slider("Voc", (float)s->unison_count, 1.0f, 7.0f,
-                                    panel_x + 10, panel_y + 30, CTRL_UNISON_COUNT, ui);
-        int new_unison = (int)(uni_val + 0.5f);
-        if (new_unison != s->unison_count) {
-            synth_set_unison_count(s, new_unison);
-        }
-
-        // Spread slider
-        float new_spread = draw_slider("Sprd", s->unison_spread, 0.0f, 100.0f,
-                                       panel_x + 10, panel_y + 60, CTRL_UNISON_SPREAD, ui);
-        if (new_spread != s->unison_spread) {
-            synth_set_unison_spread(s, new_spread);
-        }
+        draw_panel(ui, panel_x, panel_y, SLIDER_WIDTH + LABEL_WIDTH + 70, content_height, "UNI");
+        draw_param_slider(ui, PARAM_UNISON_COUNT, panel_x + 10, panel_y + 30);
+        draw_param_slider(ui, PARAM_UNISON_SPREAD, panel_x + 10, panel_y + 60);
+        draw_param_slider(ui, PARAM_UNISON_WIDTH, panel_x + 10, panel_y + 90);
+        draw_param_slider(ui, PARAM_PAN_SPREAD, panel_x + 10, panel_y + 120);
 
     } else if (ui->current_page == 1) {
         // FILTER PAGE: Filter + Envelope
-        DrawRectangle(panel_x, panel_y, PANEL_WIDTH + 60, content_height, PANEL_COLOR);
-        DrawText("FILTER", panel_x + 10, panel_y + 5, 16, TEXT_COLOR);
-        int new_filter = draw_button_row("Type", FILTER_NAMES, 3, ui->selected_filter,
-                                         panel_x + 10, panel_y + 25);
-        if (new_filter != ui->selected_filter) {
-            ui->selected_filter = new_filter;
-            s->filter_type = (FilterType)new_filter;
-            synth_set_filter(s, s->filter_cutoff, s->filter_resonance, s->filter_type);
-        }
-        float new_cutoff = draw_slider("Cut", s->filter_cutoff, 0.0f, 1.0f,
-                                       panel_x + 10, panel_y + 55, CTRL_FILTER_CUTOFF, ui);
-        float new_reso = draw_slider("Res", s->filter_resonance, 0.0f, 0.95f,
-                                     panel_x + 10, panel_y + 85, CTRL_FILTER_RESO, ui);
-        if (new_cutoff != s->filter_cutoff || new_reso != s->filter_resonance) {
-            synth_set_filter(s, new_cutoff, new_reso, s->filter_type);
-        }
+        draw_panel(ui, panel_x, panel_y, PANEL_WIDTH + 60, content_height, "FILTER");
+        draw_param_buttons(ui, PARAM_FILTER_TYPE, FILTER_NAMES, 3, panel_x + 10, panel_y + 25);
+        draw_param_slider(ui, PARAM_FILTER_CUTOFF, panel_x + 10, panel_y + 55);
+        draw_param_slider(ui, PARAM_FILTER_RESO, panel_x + 10, panel_y + 85);
 
         panel_x += PANEL_WIDTH + 60 + PANEL_MARGIN;
-        DrawRectangle(panel_x, panel_y, PANEL_WIDTH + 60, content_height, PANEL_COLOR);
-        DrawText("ENVELOPE", panel_x + 10, panel_y + 5, 16, TEXT_COLOR);
-        float new_a = draw_slider("A", s->attack, 0.001f, 2.0f,
-                                  panel_x + 10, panel_y + 30, CTRL_ATTACK, ui);
-        float new_d = draw_slider("D", s->decay, 0.001f, 2.0f,
-                                  panel_x + 10, panel_y + 60, CTRL_DECAY, ui);
-        float new_sus = draw_slider("S", s->sustain, 0.0f, 1.0f,
-                                    panel_x + 10, panel_y + 90, CTRL_SUSTAIN, ui);
-        float new_r = draw_slider("R", s->release, 0.001f, 3.0f,
-                                  panel_x + 10, panel_y + 120, CTRL_RELEASE, ui);
-        if (new_a != s->attack || new_d != s->decay ||
-            new_sus != s->sustain || new_r != s->release) {
-            synth_set_adsr(s, new_a, new_d, new_sus, new_r);
-        }
+        draw_panel(ui, panel_x, panel_y, PANEL_WIDTH + 60, content_height, "ENVELOPE");
+        draw_param_slider(ui, PARAM_AMP_ATTACK, panel_x + 10, panel_y + 30);
+        draw_param_slider(ui, PARAM_AMP_DECAY, panel_x + 10, panel_y + 60);
+        draw_param_slider(ui, PARAM_AMP_SUSTAIN, panel_x + 10, panel_y + 90);
+        draw_param_slider(ui, PARAM_AMP_RELEASE, panel_x + 10, panel_y + 120);
 
     } else if (ui->current_page == 2) {
         // FX PAGE: Effects
-        DrawRectangle(panel_x, panel_y, PANEL_WIDTH + 40, content_height, PANEL_COLOR);
-        DrawText("DELAY", panel_x + 10, panel_y + 5, 16, TEXT_COLOR);
-        fx->delay.time = draw_slider("Time", fx->delay.time, 0.01f, 1.0f,
-                                     panel_x + 10, panel_y + 30, CTRL_DELAY_TIME, ui);
-        fx->delay.mix = draw_slider("Mix", fx->delay.mix, 0.0f, 1.0f,
-                                    panel_x + 10, panel_y + 60, CTRL_DELAY_MIX, ui);
+        draw_panel(ui, panel_x, panel_y, PANEL_WIDTH + 40, content_height, "DELAY");
+        draw_param_slider(ui, PARAM_DELAY_TIME, panel_x + 10, panel_y + 30);
+        draw_param_slider(ui, PARAM_DELAY_MIX, panel_x + 10, panel_y + 60);
+        draw_param_slider(ui, PARAM_DELAY_FEEDBACK, panel_x + 10, panel_y + 90);
+        draw_param_buttons(ui, PARAM_DELAY_PINGPONG, DELAY_MODES, 2, panel_x + 10, panel_y + 120);
 
         panel_x += PANEL_WIDTH + 40 + PANEL_MARGIN;
-        DrawRectangle(panel_x, panel_y, PANEL_WIDTH + 40, content_height, PANEL_COLOR);
-        DrawText("REVERB", panel_x + 10, panel_y + 5, 16, TEXT_COLOR);
-        fx->reverb.mix = draw_slider("Mix", fx->reverb.mix, 0.0f, 1.0f,
-                                     panel_x + 10, panel_y + 30, CTRL_REVERB_MIX, ui);
+        draw_panel(ui, panel_x, panel_y, PANEL_WIDTH + 40, content_height, "REVERB");
+        draw_param_slider(ui, PARAM_REVERB_MIX, panel_x + 10, panel_y + 30);
+        draw_param_slider(ui, PARAM_REVERB_SIZE, panel_x + 10, panel_y + 60);
 
         panel_x += PANEL_WIDTH + 40 + PANEL_MARGIN;
-        DrawRectangle(panel_x, panel_y, PANEL_WIDTH + 40, content_height, PANEL_COLOR);
-        DrawText("DISTORT", panel_x + 10, panel_y + 5, 16, TEXT_COLOR);
-        fx->distortion.mix = draw_slider("Mix", fx->distortion.mix, 0.0f, 1.0f,
-                                         panel_x + 10, panel_y + 30, CTRL_DIST_MIX, ui);
-        fx->distortion.drive = draw_slider("Drv", fx->distortion.drive, 1.0f, 10.0f,
-                                           panel_x + 10, panel_y + 60, CTRL_DIST_DRIVE, ui);
+        draw_panel(ui, panel_x, panel_y, PANEL_WIDTH + 40, content_height, "DISTORT");
+        draw_param_slider(ui, PARAM_DIST_MIX, panel_x + 10, panel_y + 30);
+        draw_param_slider(ui, PARAM_DIST_DRIVE, panel_x + 10, panel_y + 60);
 
     } else if (ui->current_page == 3) {
-        // MOD PAGE: LFO + Filter Envelope
-        DrawRectangle(panel_x, panel_y, PANEL_WIDTH + 60, content_height, PANEL_COLOR);
-        DrawText("LFO", panel_x + 10, panel_y + 5, 16, TEXT_COLOR);
-        int new_lfo = draw_button_row("Wave", LFO_NAMES, 4, ui->selected_lfo,
-                                      panel_x + 10, panel_y + 25);
-        if (new_lfo != ui->selected_lfo) {
-            ui->selected_lfo = new_lfo;
-            synth_set_lfo_type(s, (LFOWaveType)new_lfo);
-        }
-        float new_rate = draw_slider("Rate", s->lfo_rate, 0.1f, 20.0f,
-                                     panel_x + 10, panel_y + 55, CTRL_LFO_RATE, ui);
-        if (new_rate != s->lfo_rate) {
-            synth_set_lfo_rate(s, new_rate);
-        }
-        float new_depth = draw_slider("Depth", s->lfo_depth, 0.0f, 1.0f,
-                                      panel_x + 10, panel_y + 85, CTRL_LFO_DEPTH, ui);
-        if (new_depth != s->lfo_depth) {
-            synth_set_lfo_depth(s, new_depth);
-        }
+        // MOD PAGE: LFO + Filter Envelope + PWM + Expression
+        draw_panel(ui, panel_x, panel_y, PANEL_WIDTH + 20, content_height, "LFO");
+        draw_param_buttons(ui, PARAM_LFO_TYPE, LFO_NAMES, 4, panel_x + 10, panel_y + 25);
+        draw_param_slider(ui, PARAM_LFO_RATE, panel_x + 10, panel_y + 55);
+        draw_param_slider(ui, PARAM_LFO_DEPTH, panel_x + 10, panel_y + 85);
 
-        panel_x += PANEL_WIDTH + 60 + PANEL_MARGIN;
-        DrawRectangle(panel_x, panel_y, PANEL_WIDTH + 60, content_height, PANEL_COLOR);
-        DrawText("FILTER ENV", panel_x + 10, panel_y + 5, 16, TEXT_COLOR);
-        float new_amt = draw_slider("Amt", s->filter_env_amount, -1.0f, 1.0f,
-                                    panel_x + 10, panel_y + 30, CTRL_FILT_ENV_AMT, ui);
-        if (new_amt != s->filter_env_amount) {
-            synth_set_filter_env_amount(s, new_amt);
-        }
-        DrawText("(Uses Amp ADSR)", panel_x + 10, panel_y + 60, 12, TEXT_COLOR);
+        panel_x += PANEL_WIDTH + 20 + PANEL_MARGIN;
+        draw_panel(ui, panel_x, panel_y, PANEL_WIDTH + 20, content_height, "FILTER ENV");
+        draw_param_slider(ui, PARAM_FENV_AMOUNT, panel_x + 10, panel_y + 30);
+        draw_label(ui, "(Uses Amp ADSR)", panel_x + 10, panel_y + 60, 12, TEXT_COLOR);
 
         // PWM panel
-        panel_x += PANEL_WIDTH + 60 + PANEL_MARGIN;
-        DrawRectangle(panel_x, panel_y, PANEL_WIDTH + 60, content_height, PANEL_COLOR);
-        DrawText("PWM", panel_x + 10, panel_y + 5, 16, TEXT_COLOR);
-        float new_pw = draw_slider("Width", s->pulse_width, 0.05f, 0.95f,
-                                   panel_x + 10, panel_y + 30, CTRL_PULSE_WIDTH, ui);
-        if (new_pw != s->pulse_width) {
-            synth_set_pulse_width(s, new_pw);
-        }
-        float new_pwm_rate = draw_slider("Rate", s->pwm_rate, 0.1f, 20.0f,
-                                         panel_x + 10, panel_y + 60, CTRL_PWM_RATE, ui);
-        if (new_pwm_rate != s->pwm_rate) {
-            synth_set_pwm_rate(s, new_pwm_rate);
+        panel_x += PANEL_WIDTH + 20 + PANEL_MARGIN;
+        draw_panel(ui, panel_x, panel_y, PANEL_WIDTH + 20, content_height, "PWM");
+        draw_param_slider(ui, PARAM_PULSE_WIDTH, panel_x + 10, panel_y + 30);
+        draw_param_slider(ui, PARAM_PWM_RATE, panel_x + 10, panel_y + 60);
+        draw_param_slider(ui, PARAM_PWM_DEPTH, panel_x + 10, panel_y + 90);
+        draw_label(ui, "(Square waves)", panel_x + 10, panel_y + 120, 12, TEXT_COLOR);
+
+        // Expression panel: bend ranges, pressure/timbre depth, MPE zone
+        panel_x += PANEL_WIDTH + 20 + PANEL_MARGIN;
+        draw_panel(ui, panel_x, panel_y, SCREEN_WIDTH - PANEL_MARGIN - panel_x, content_height, "EXPR");
+        draw_param_slider(ui, PARAM_BEND_RANGE, panel_x + 10, panel_y + 30);
+        draw_param_slider(ui, PARAM_MPE_BEND_RANGE, panel_x + 10, panel_y + 55);
+        draw_param_slider(ui, PARAM_PRESSURE_AMOUNT, panel_x + 10, panel_y + 80);
+        draw_param_slider(ui, PARAM_TIMBRE_AMOUNT, panel_x + 10, panel_y + 105);
+
+        // MPE zone on/off (a controller's configuration message also sets it)
+        bool mpe_on = s->mpe_members > 0;
+        Rectangle mpe_btn = {panel_x + 10, panel_y + 140, 110, 28};
+        if (widget_begin(ui, mpe_btn, hash_int(0, s->mpe_members))) {
+            DrawRectangleRec(mpe_btn, mpe_on ? SLIDER_FG : SLIDER_BG);
+            char mpe_str[16];
+            if (mpe_on) {
+                snprintf(mpe_str, sizeof(mpe_str), "MPE %d ch", s->mpe_members);
+            } else {
+                snprintf(mpe_str, sizeof(mpe_str), "MPE OFF");
+            }
+            DrawText(mpe_str, mpe_btn.x + 10, mpe_btn.y + 7, 14, mpe_on ? BG_COLOR : TEXT_COLOR);
         }
-        float new_pwm_depth = draw_slider("Depth", s->pwm_depth, 0.0f, 0.45f,
-                                          panel_x + 10, panel_y + 90, CTRL_PWM_DEPTH, ui);
-        if (new_pwm_depth != s->pwm_depth) {
-            synth_set_pwm_depth(s, new_pwm_depth);
+
+        if (pressed(ui) && !ui->midi_learn) {
+            Vector2 mouse = GetTransformedTouch();
+            if (CheckCollisionPointRec(mouse, mpe_btn)) {
+                synth_set_mpe_members(s, mpe_on ? 0 : SYNTH_MIDI_CHANNELS - 1);
+            }
         }
-        DrawText("(Square waves)", panel_x + 10, panel_y + 120, 12, TEXT_COLOR);
 
     } else if (ui->current_page == 4) {
         // ARP PAGE: Arpeggiator controls
         Arpeggiator *arp = ui->arp;
 
-        DrawRectangle(panel_x, panel_y, PANEL_WIDTH + 60, content_height, PANEL_COLOR);
-        DrawText("ARPEGGIATOR", panel_x + 10, panel_y + 5, 16, TEXT_COLOR);
+        draw_panel(ui, panel_x, panel_y, PANEL_WIDTH + 60, content_height, "ARPEGGIATOR");
 
         // On/Off toggle
         Rectangle on_btn = {panel_x + 20, panel_y + 30, 60, 28};
         Rectangle off_btn = {panel_x + 85, panel_y + 30, 60, 28};
 
-        DrawRectangleRec(on_btn, arp->enabled ? SLIDER_FG : SLIDER_BG);
-        DrawText("ON", on_btn.x + 20, on_btn.y + 6, 14, arp->enabled ? BG_COLOR : TEXT_COLOR);
+        if (widget_begin(ui, (Rectangle){on_btn.x, on_btn.y, 125, 28}, hash_int(0, arp->enabled))) {
+            DrawRectangleRec(on_btn, arp->enabled ? SLIDER_FG : SLIDER_BG);
+            DrawText("ON", on_btn.x + 20, on_btn.y + 6, 14, arp->enabled ? BG_COLOR : TEXT_COLOR);
 
-        DrawRectangleRec(off_btn, !arp->enabled ? SLIDER_FG : SLIDER_BG);
-        DrawText("OFF", off_btn.x + 16, off_btn.y + 6, 14, !arp->enabled ? BG_COLOR : TEXT_COLOR);
+            DrawRectangleRec(off_btn, !arp->enabled ? SLIDER_FG : SLIDER_BG);
+            DrawText("OFF", off_btn.x + 16, off_btn.y + 6, 14, !arp->enabled ? BG_COLOR : TEXT_COLOR);
+        }
 
-        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        if (pressed(ui)) {
             Vector2 mouse = GetTransformedTouch();
-            if (CheckCollisionPointRec(mouse, on_btn)) arp->enabled = 1;
+            if (CheckCollisionPointRec(mouse, on_btn)) param_set(&ui->params, PARAM_ARP_ENABLED, 1.0f);
             if (CheckCollisionPointRec(mouse, off_btn)) {
-                arp->enabled = 0;
+                param_set(&ui->params, PARAM_ARP_ENABLED, 0.0f);
                 arp_clear(arp);
             }
         }
 
-        // Pattern selector
-        int new_pattern = draw_button_row("Ptrn", ARP_PATTERN_NAMES, 5, (int)arp->pattern,
-                                          panel_x + 10, panel_y + 65);
-        if (new_pattern != (int)arp->pattern) {
-            arp->pattern = (ArpPattern)new_pattern;
-        }
-
-        // Division selector
-        int new_div = draw_button_row("Div", ARP_DIV_NAMES, 4, (int)arp->division,
-                                      panel_x + 10, panel_y + 95);
-        if (new_div != (int)arp->division) {
-            arp->division = (ArpDivision)new_div;
-        }
+        // Pattern and division selectors
+        draw_param_buttons(ui, PARAM_ARP_PATTERN, ARP_PATTERN_NAMES, 5, panel_x + 10, panel_y + 65);
+        draw_param_buttons(ui, PARAM_ARP_DIVISION, ARP_DIV_NAMES, 4, panel_x + 10, panel_y + 95);
 
         // Tempo/Octaves/Gate panel
         panel_x += PANEL_WIDTH + 60 + PANEL_MARGIN;
-        DrawRectangle(panel_x, panel_y, PANEL_WIDTH + 60, content_height, PANEL_COLOR);
-        DrawText("TIMING", panel_x + 10, panel_y + 5, 16, TEXT_COLOR);
-
-        // Tempo slider (40-240 BPM)
-        float new_tempo = draw_slider("BPM", arp->tempo, 40.0f, 240.0f,
-                                      panel_x + 10, panel_y + 30, CTRL_NONE, ui);
-        if (new_tempo != arp->tempo) {
-            arp->tempo = new_tempo;
-        }
-
-        // Octaves slider (1-4)
-        float oct_val = draw_slider("Oct", (float)arp->octaves, 1.0f, 4.0f,
-                                    panel_x + 10, panel_y + 60, CTRL_NONE, ui);
-        int new_oct = (int)(oct_val + 0.5f);
-        if (new_oct != arp->octaves) {
-            arp->octaves = new_oct;
-        }
-
-        // Gate slider (0.1-1.0)
-        float new_gate = draw_slider("Gate", arp->gate, 0.1f, 1.0f,
-                                     panel_x + 10, panel_y + 90, CTRL_NONE, ui);
-        if (new_gate != arp->gate) {
-            arp->gate = new_gate;
-        }
+        draw_panel(ui, panel_x, panel_y, PANEL_WIDTH + 60, content_height, "TIMING");
+        draw_param_slider(ui, PARAM_ARP_TEMPO, panel_x + 10, panel_y + 30);
+        draw_param_slider(ui, PARAM_ARP_OCTAVES, panel_x + 10, panel_y + 60);
+        draw_param_slider(ui, PARAM_ARP_GATE, panel_x + 10, panel_y + 90);
 
         // Status display
         panel_x += PANEL_WIDTH + 60 + PANEL_MARGIN;
-        DrawRectangle(panel_x, panel_y, PANEL_WIDTH, content_height, PANEL_COLOR);
-        DrawText("STATUS", panel_x + 10, panel_y + 5, 16, TEXT_COLOR);
-
-        char status_str[64];
-        snprintf(status_str, sizeof(status_str), "Notes held: %d", arp->note_count);
-        DrawText(status_str, panel_x + 20, panel_y + 35, 14, TEXT_COLOR);
-
-        if (arp->enabled) {
-            DrawText("Arp ACTIVE", panel_x + 20, panel_y + 60, 14, WAVE_COLOR);
-            snprintf(status_str, sizeof(status_str), "Step: %d/%d",
-                     arp->current_step + 1, arp->note_count > 0 ? arp->note_count : 1);
-            DrawText(status_str, panel_x + 20, panel_y + 85, 14, TEXT_COLOR);
-        } else {
-            DrawText("Arp OFF", panel_x + 20, panel_y + 60, 14, TEXT_COLOR);
+        draw_panel(ui, panel_x, panel_y, PANEL_WIDTH, content_height, "STATUS");
+
+        unsigned int state = hash_int(hash_int(hash_int(0, arp->note_count), arp->enabled),
+                                      arp->current_step);
+        if (widget_begin(ui, (Rectangle){panel_x + 20, panel_y + 35, 200, 70}, state)) {
+            char status_str[64];
+            snprintf(status_str, sizeof(status_str), "Notes held: %d", arp->note_count);
+            DrawText(status_str, panel_x + 20, panel_y + 35, 14, TEXT_COLOR);
+
+            if (arp->enabled) {
+                DrawText("Arp ACTIVE", panel_x + 20, panel_y + 60, 14, WAVE_COLOR);
+                snprintf(status_str, sizeof(status_str), "Step: %d/%d",
+                         arp->current_step + 1, arp->note_count > 0 ? arp->note_count : 1);
+                DrawText(status_str, panel_x + 20, panel_y + 85, 14, TEXT_COLOR);
+            } else {
+                DrawText("Arp OFF", panel_x + 20, panel_y + 60, 14, TEXT_COLOR);
+            }
         }
 
     } else if (ui->current_page == 5) {
         // PRESET PAGE
-        DrawRectangle(panel_x, panel_y, PANEL_WIDTH + 150, content_height, PANEL_COLOR);
-        DrawText("PRESETS", panel_x + 10, panel_y + 5, 16, TEXT_COLOR);
-
-        // Preset number display with navigation
-        char preset_str[16];
-        snprintf(preset_str, sizeof(preset_str), "%03d", ui->current_preset);
+        draw_panel(ui, panel_x, panel_y, PANEL_WIDTH + 150, content_height, "PRESETS");
 
         int nav_y = panel_y + 35;
         int btn_size = 36;
 
-        // Previous button
+        // Previous/next buttons with the preset number between them
         Rectangle prev_btn = {panel_x + 20, nav_y, btn_size, btn_size};
-        DrawRectangleRec(prev_btn, SLIDER_BG);
-        DrawText("<", prev_btn.x + 12, prev_btn.y + 8, 20, TEXT_COLOR);
-
-        // Preset number
-        DrawText(preset_str, panel_x + 70, nav_y + 6, 24, SLIDER_FG);
-
-        // Next button
         Rectangle next_btn = {panel_x + 130, nav_y, btn_size, btn_size};
-        DrawRectangleRec(next_btn, SLIDER_BG);
-        DrawText(">", next_btn.x + 12, next_btn.y + 8, 20, TEXT_COLOR);
-
-        // Check if preset exists and get name
-        int exists = preset_exists(ui->current_preset);
-        static int last_preset = -1;
-        if (ui->current_preset != last_preset && !ui->editing_name) {
-            last_preset = ui->current_preset;
-            if (exists) {
+        draw_static_button(ui, prev_btn, SLIDER_BG, "<", 12, 8, 20, TEXT_COLOR);
+        draw_static_button(ui, next_btn, SLIDER_BG, ">", 12, 8, 20, TEXT_COLOR);
+
+        if (widget_begin(ui, (Rectangle){panel_x + 65, nav_y, 60, btn_size},
+                         hash_int(0, ui->current_preset))) {
+            char preset_str[16];
+            snprintf(preset_str, sizeof(preset_str), "%03d", ui->current_preset);
+            DrawText(preset_str, panel_x + 70, nav_y + 6, 24, SLIDER_FG);
+        }
+
+        // Check if preset exists and get name (bank first, then JSON)
+        char preset_path[64];
+        preset_filename(ui->current_preset, preset_path, sizeof(preset_path));
+        int bank_index = ui->bank ? bank_find_current(ui->bank, ui->current_preset, preset_path) : -1;
+        int exists = bank_index >= 0 || preset_exists(ui->current_preset);
+        if (ui->current_preset != ui->shown_preset && !ui->editing_name && !ui->chrome_pass) {
+            ui->shown_preset = ui->current_preset;
+            if (bank_index >= 0) {
+                strncpy(ui->preset_name, bank_entry(ui->bank, bank_index)->name, sizeof(ui->preset_name) - 1);
+                ui->preset_name[sizeof(ui->preset_name) - 1] = '\0';
+            } else if (exists) {
                 preset_get_name(ui->current_preset, ui->preset_name, sizeof(ui->preset_name));
             } else {
                 snprintf(ui->preset_name, sizeof(ui->preset_name), "Preset %03d", ui->current_preset);
@@ -546,26 +760,32 @@ void ui_draw(UI *ui) {
 
         // Display preset name (tappable for editing)
         Rectangle name_rect = {panel_x + 175, nav_y, 200, 30};
-        DrawRectangleRec(name_rect, ui->editing_name ? SLIDER_BG : PANEL_COLOR);
-        DrawRectangleLinesEx(name_rect, 1, ui->editing_name ? SLIDER_FG : SLIDER_BG);
-        DrawText(ui->preset_name, panel_x + 180, nav_y + 6, 18,
-                 ui->editing_name ? SLIDER_FG : (exists ? WAVE_COLOR : TEXT_COLOR));
-        if (!ui->editing_name) {
-            DrawText("[edit]", panel_x + 380, nav_y + 10, 12, TEXT_COLOR);
+        unsigned int name_state = hash_str(hash_int(hash_int(0, ui->editing_name), exists), ui->preset_name);
+        if (widget_begin(ui, (Rectangle){name_rect.x, name_rect.y, 250, name_rect.height}, name_state)) {
+            DrawRectangleRec(name_rect, ui->editing_name ? SLIDER_BG : PANEL_COLOR);
+            DrawRectangleLinesEx(name_rect, 1, ui->editing_name ? SLIDER_FG : SLIDER_BG);
+            DrawText(ui->preset_name, panel_x + 180, nav_y + 6, 18,
+                     ui->editing_name ? SLIDER_FG : (exists ? WAVE_COLOR : TEXT_COLOR));
+            if (!ui->editing_name) {
+                DrawText("[edit]", panel_x + 380, nav_y + 10, 12, TEXT_COLOR);
+            }
         }
 
         // Touch handling for navigation and name editing
-        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && !ui->editing_name) {
+        if (pressed(ui) && !ui->editing_name) {
             Vector2 mouse = GetTransformedTouch();
+            // Banks may hold more slots than the JSON directory
+            int max_slot = MAX_PRESETS;
+            if (ui->bank && bank_max_slot(ui->bank) > max_slot) max_slot = bank_max_slot(ui->bank);
             if (CheckCollisionPointRec(mouse, prev_btn)) {
                 ui->current_preset--;
-                if (ui->current_preset < 1) ui->current_preset = MAX_PRESETS;
-                last_preset = -1;
+                if (ui->current_preset < 1) ui->current_preset = max_slot;
+                ui->shown_preset = -1;
             }
             if (CheckCollisionPointRec(mouse, next_btn)) {
                 ui->current_preset++;
-                if (ui->current_preset > MAX_PRESETS) ui->current_preset = 1;
-                last_preset = -1;
+                if (ui->current_preset > max_slot) ui->current_preset = 1;
+                ui->shown_preset = -1;
             }
             if (CheckCollisionPointRec(mouse, name_rect)) {
                 ui->editing_name = true;
@@ -577,27 +797,19 @@ void ui_draw(UI *ui) {
         Rectangle load_btn = {panel_x + 20, action_y, 80, 35};
         Rectangle save_btn = {panel_x + 110, action_y, 80, 35};
 
-        Color load_color = exists ? SLIDER_FG : SLIDER_BG;
-
-        DrawRectangleRec(load_btn, load_color);
-        DrawText("LOAD", load_btn.x + 18, load_btn.y + 10, 14,
-                 exists ? BG_COLOR : TEXT_COLOR);
-
-        DrawRectangleRec(save_btn, SLIDER_FG);
-        DrawText("SAVE", save_btn.x + 18, save_btn.y + 10, 14, BG_COLOR);
+        if (widget_begin(ui, load_btn, hash_int(0, exists))) {
+            DrawRectangleRec(load_btn, exists ? SLIDER_FG : SLIDER_BG);
+            DrawText("LOAD", load_btn.x + 18, load_btn.y + 10, 14,
+                     exists ? BG_COLOR : TEXT_COLOR);
+        }
+        draw_static_button(ui, save_btn, SLIDER_FG, "SAVE", 18, 10, 14, BG_COLOR);
 
         // Touch handling for load/save
-        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && !ui->editing_name) {
+        if (pressed(ui) && !ui->editing_name) {
             Vector2 mouse = GetTransformedTouch();
             if (CheckCollisionPointRec(mouse, load_btn) && exists) {
-                char path[64];
-                preset_filename(ui->current_preset, path, sizeof(path));
-                if (preset_load(path, ui->preset_name, sizeof(ui->preset_name), s, fx, ui->arp) == 0) {
-                    ui->selected_wave = s->wave_type;
-                    ui->selected_wave2 = s->wave_type2;
-                    ui->selected_filter = s->filter_type;
-                    ui->selected_lfo = s->lfo_type;
-                }
+                // Loaded in the background and swapped in by the audio thread
+                ui->load_requested = true;
             }
             if (CheckCollisionPointRec(mouse, save_btn)) {
                 char path[64];
@@ -605,13 +817,18 @@ void ui_draw(UI *ui) {
                 if (ui->preset_name[0] == '\0') {
                     snprintf(ui->preset_name, sizeof(ui->preset_name), "Preset %03d", ui->current_preset);
                 }
-                preset_save(path, ui->preset_name, s, fx, ui->arp);
-                last_preset = -1;
+                preset_save(path, ui->preset_name, s, fx, ui->arp, ui->midimap);
+                if (ui->multi) {
+                    snprintf(ui->multi->parts[ui->selected_part].preset_name, PART_NAME_LEN,
+                             "%s", ui->preset_name);
+                }
+                ui->shown_preset = -1;
             }
         }
 
         // Status text
-        if (!ui->editing_name) {
+        if (widget_begin(ui, (Rectangle){panel_x + 20, panel_y + 135, 150, 14},
+                         hash_int(hash_int(0, exists), ui->editing_name)) && !ui->editing_name) {
             if (exists) {
                 DrawText("Tap LOAD to recall", panel_x + 20, panel_y + 135, 12, TEXT_COLOR);
             } else {
@@ -619,7 +836,8 @@ void ui_draw(UI *ui) {
             }
         }
 
-        // On-screen keyboard when editing name
+        // On-screen keyboard when editing name (opening or closing it
+        // changes the layout, so it is painted on a full redraw)
         if (ui->editing_name) {
             int kb_x = panel_x + PANEL_WIDTH + 180;
             int kb_y = panel_y + 10;
@@ -627,8 +845,11 @@ void ui_draw(UI *ui) {
             int key_h = 28;
             int key_gap = 3;
 
-            DrawRectangle(kb_x - 10, kb_y - 5, 380, 175, (Color){35, 35, 50, 255});
-            DrawText("EDIT NAME", kb_x, kb_y, 14, SLIDER_FG);
+            bool paint = widget_begin(ui, (Rectangle){kb_x - 10, kb_y - 5, 380, 175}, 0);
+            if (paint) {
+                DrawRectangle(kb_x - 10, kb_y - 5, 380, 175, (Color){35, 35, 50, 255});
+                DrawText("EDIT NAME", kb_x, kb_y, 14, SLIDER_FG);
+            }
             kb_y += 20;
 
             // Keyboard rows
@@ -644,11 +865,13 @@ void ui_draw(UI *ui) {
                 int rx = kb_x + row_offsets[row];
                 for (int col = 0; rows[row][col]; col++) {
                     Rectangle key = {rx + col * (key_w + key_gap), kb_y + row * (key_h + key_gap), key_w, key_h};
-                    DrawRectangleRec(key, SLIDER_BG);
-                    char ch[2] = {rows[row][col], 0};
-                    DrawText(ch, key.x + 11, key.y + 6, 16, TEXT_COLOR);
+                    if (paint) {
+                        DrawRectangleRec(key, SLIDER_BG);
+                        char ch[2] = {rows[row][col], 0};
+                        DrawText(ch, key.x + 11, key.y + 6, 16, TEXT_COLOR);
+                    }
 
-                    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+                    if (pressed(ui)) {
                         Vector2 mouse = GetTransformedTouch();
                         if (CheckCollisionPointRec(mouse, key)) {
                             int len = strlen(ui->preset_name);
@@ -665,22 +888,21 @@ void ui_draw(UI *ui) {
             int btn_y = kb_y + 4 * (key_h + key_gap);
 
             Rectangle space_btn = {kb_x, btn_y, 100, key_h};
-            DrawRectangleRec(space_btn, SLIDER_BG);
-            DrawText("SPACE", space_btn.x + 25, space_btn.y + 6, 14, TEXT_COLOR);
-
             Rectangle back_btn = {kb_x + 110, btn_y, 80, key_h};
-            DrawRectangleRec(back_btn, SLIDER_BG);
-            DrawText("<DEL", back_btn.x + 18, back_btn.y + 6, 14, TEXT_COLOR);
-
             Rectangle done_btn = {kb_x + 200, btn_y, 80, key_h};
-            DrawRectangleRec(done_btn, SLIDER_FG);
-            DrawText("DONE", done_btn.x + 18, done_btn.y + 6, 14, BG_COLOR);
-
             Rectangle clear_btn = {kb_x + 290, btn_y, 70, key_h};
-            DrawRectangleRec(clear_btn, SLIDER_BG);
-            DrawText("CLR", clear_btn.x + 18, clear_btn.y + 6, 14, TEXT_COLOR);
+            if (paint) {
+                DrawRectangleRec(space_btn, SLIDER_BG);
+                DrawText("SPACE", space_btn.x + 25, space_btn.y + 6, 14, TEXT_COLOR);
+                DrawRectangleRec(back_btn, SLIDER_BG);
+                DrawText("<DEL", back_btn.x + 18, back_btn.y + 6, 14, TEXT_COLOR);
+                DrawRectangleRec(done_btn, SLIDER_FG);
+                DrawText("DONE", done_btn.x + 18, done_btn.y + 6, 14, BG_COLOR);
+                DrawRectangleRec(clear_btn, SLIDER_BG);
+                DrawText("CLR", clear_btn.x + 18, clear_btn.y + 6, 14, TEXT_COLOR);
+            }
 
-            if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+            if (pressed(ui)) {
                 Vector2 mouse = GetTransformedTouch();
                 if (CheckCollisionPointRec(mouse, space_btn)) {
                     int len = strlen(ui->preset_name);
@@ -706,93 +928,296 @@ void ui_draw(UI *ui) {
 
     } else if (ui->current_page == 6) {
         // SETTINGS PAGE
-        DrawRectangle(panel_x, panel_y, PANEL_WIDTH + 100, content_height, PANEL_COLOR);
-        DrawText("SETTINGS", panel_x + 10, panel_y + 5, 16, TEXT_COLOR);
+        draw_panel(ui, panel_x, panel_y, PANEL_WIDTH + 100, content_height, "SETTINGS");
 
         // Buffer size selector
-        DrawText("Audio Buffer:", panel_x + 20, panel_y + 40, 14, TEXT_COLOR);
+        draw_label(ui, "Audio Buffer:", panel_x + 20, panel_y + 40, 14, TEXT_COLOR);
 
         int buf_x = panel_x + 130;
         int buf_y = panel_y + 35;
-        int buf_w = 60;
+        int buf_w = 46;
         int buf_h = 28;
 
-        for (int i = 0; i < 3; i++) {
-            Rectangle buf_btn = {buf_x + i * (buf_w + 5), buf_y, buf_w, buf_h};
-            Color btn_col = (ui->buffer_size == i) ? SLIDER_FG : SLIDER_BG;
-            DrawRectangleRec(buf_btn, btn_col);
-            int tw = MeasureText(BUFFER_NAMES[i], 14);
-            DrawText(BUFFER_NAMES[i], buf_btn.x + (buf_w - tw) / 2, buf_btn.y + 7, 14,
-                     (ui->buffer_size == i) ? BG_COLOR : TEXT_COLOR);
+        // Sizes, then AUTO (which starts again from the smallest)
+        bool paint = widget_begin(ui, (Rectangle){buf_x, buf_y, 260, buf_h},
+                                  hash_int(hash_int(0, ui->buffer_size), ui->buffer_auto));
+        for (int i = 0; i < 4; i++) {
+            Rectangle buf_btn = {buf_x + i * (buf_w + 4), buf_y, buf_w, buf_h};
+            bool lit = (i == 3) ? ui->buffer_auto : (ui->buffer_size == i);
+            bool current = (i == 3) ? ui->buffer_auto : (lit && !ui->buffer_auto);
+            if (paint) {
+                DrawRectangleRec(buf_btn, lit ? SLIDER_FG : SLIDER_BG);
+                int tw = MeasureText(BUFFER_NAMES[i], 14);
+                DrawText(BUFFER_NAMES[i], buf_btn.x + (buf_w - tw) / 2, buf_btn.y + 7, 14,
+                         lit ? BG_COLOR : TEXT_COLOR);
+            }
 
-            if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+            if (pressed(ui)) {
                 Vector2 mouse = GetTransformedTouch();
-                if (CheckCollisionPointRec(mouse, buf_btn) && ui->buffer_size != i) {
-                    ui->buffer_size = i;
+                if (CheckCollisionPointRec(mouse, buf_btn) && !current) {
+                    ui->buffer_auto = (i == 3);
+                    ui->buffer_size = (i == 3) ? 2 : i;
                     ui->buffer_changed = true;
                 }
             }
         }
 
         // Show latency info
-        const char *latency_info[] = {"~11.6ms", "~5.8ms", "~2.9ms"};
-        DrawText(latency_info[ui->buffer_size], buf_x + 200, buf_y + 7, 14, WAVE_COLOR);
+        if (paint) {
+            static const int buffer_frames[] = {512, 256, 128};
+            char latency_info[16];
+            snprintf(latency_info, sizeof(latency_info), "~%.1fms",
+                     buffer_frames[ui->buffer_size] * 1000.0f / sample_rate);
+            DrawText(latency_info, buf_x + 204, buf_y + 7, 14, WAVE_COLOR);
+        }
 
-        // Buffer changes apply immediately at runtime
+        // Buffer changes apply while playing (main moves the render-ahead)
+
+        // Engine state snapshot (exact running state, for A/B and bug reports)
+        draw_label(ui, "Engine State:", panel_x + 20, panel_y + 90, 14, TEXT_COLOR);
+        Rectangle snap_save_btn = {buf_x, panel_y + 85, 90, 28};
+        Rectangle snap_restore_btn = {buf_x + 95, panel_y + 85, 90, 28};
+        draw_static_button(ui, snap_save_btn, SLIDER_BG, "SAVE", 27, 7, 14, TEXT_COLOR);
+        draw_static_button(ui, snap_restore_btn, SLIDER_BG, "RESTORE", 14, 7, 14, TEXT_COLOR);
+
+        if (pressed(ui)) {
+            Vector2 mouse = GetTransformedTouch();
+            if (CheckCollisionPointRec(mouse, snap_save_btn)) ui->snapshot_save = true;
+            if (CheckCollisionPointRec(mouse, snap_restore_btn)) ui->snapshot_restore = true;
+        }
+
+        // UI cost (refreshed by main twice a second)
+        draw_label(ui, "UI Frame:", panel_x + 20, panel_y + 140, 14, TEXT_COLOR);
+        unsigned int stats_state = hash_add(0, &ui->frame_ms, sizeof(ui->frame_ms));
+        stats_state = hash_add(stats_state, &ui->frame_cpu, sizeof(ui->frame_cpu));
+        stats_state = hash_add(stats_state, &ui->frame_redrawn, sizeof(ui->frame_redrawn));
+        stats_state = hash_int(hash_int(stats_state, ui->idle_audio), ui->idle_ui);
+        if (widget_begin(ui, (Rectangle){buf_x, panel_y + 135, 260, 50}, stats_state)) {
+            char stats_str[48];
+            snprintf(stats_str, sizeof(stats_str), "%.2f ms  CPU %.1f%%", ui->frame_ms, ui->frame_cpu);
+            DrawText(stats_str, buf_x, panel_y + 140, 14, WAVE_COLOR);
+            snprintf(stats_str, sizeof(stats_str), "%.1f widgets redrawn", ui->frame_redrawn);
+            DrawText(stats_str, buf_x, panel_y + 156, 12, TEXT_COLOR);
+            snprintf(stats_str, sizeof(stats_str), "Audio %s  UI %s",
+                     ui->idle_audio ? "idle" : "running", ui->idle_ui ? "idle" : "active");
+            DrawText(stats_str, buf_x, panel_y + 170, 12, ui->idle_ui ? TEXT_COLOR : WAVE_COLOR);
+        }
 
         // Panic button
         panel_x += PANEL_WIDTH + 100 + PANEL_MARGIN;
-        DrawRectangle(panel_x, panel_y, PANEL_WIDTH, content_height, PANEL_COLOR);
-        DrawText("MIDI", panel_x + 10, panel_y + 5, 16, TEXT_COLOR);
+        draw_panel(ui, panel_x, panel_y, PANEL_WIDTH, content_height, "MIDI");
 
         Rectangle panic_btn = {panel_x + 20, panel_y + 40, 120, 50};
-        DrawRectangleRec(panic_btn, (Color){200, 60, 60, 255});
-        DrawText("PANIC", panic_btn.x + 30, panic_btn.y + 16, 18, WHITE);
+        draw_static_button(ui, panic_btn, (Color){200, 60, 60, 255}, "PANIC", 30, 16, 18, WHITE);
 
-        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        if (pressed(ui)) {
             Vector2 mouse = GetTransformedTouch();
             if (CheckCollisionPointRec(mouse, panic_btn)) {
                 ui->panic_triggered = true;
             }
         }
 
-        DrawText("All notes off", panel_x + 20, panel_y + 100, 12, TEXT_COLOR);
+        draw_label(ui, "All notes off", panel_x + 20, panel_y + 100, 12, TEXT_COLOR);
+
+        // MIDI learn toggle and mapping reset
+        Rectangle learn_btn = {panel_x + 160, panel_y + 40, 120, 50};
+        if (widget_begin(ui, learn_btn, hash_int(0, ui->midi_learn))) {
+            DrawRectangleRec(learn_btn, ui->midi_learn ? LEARN_COLOR : SLIDER_BG);
+            DrawText("LEARN", learn_btn.x + 30, learn_btn.y + 16, 18, ui->midi_learn ? BG_COLOR : TEXT_COLOR);
+        }
+
+        Rectangle reset_btn = {panel_x + 160, panel_y + 120, 120, 28};
+        draw_static_button(ui, reset_btn, SLIDER_BG, "RESET MAP", 18, 7, 14, TEXT_COLOR);
+
+        if (pressed(ui)) {
+            Vector2 mouse = GetTransformedTouch();
+            if (CheckCollisionPointRec(mouse, learn_btn)) {
+                ui->midi_learn = !ui->midi_learn;
+                ui->learn_param = -1;
+            }
+            if (CheckCollisionPointRec(mouse, reset_btn) && ui->midimap) {
+                midimap_init(ui->midimap);
+            }
+        }
+
+        unsigned int hint_state = hash_int(hash_int(0, ui->midi_learn), ui->learn_param >= 0);
+        if (widget_begin(ui, (Rectangle){panel_x + 160, panel_y + 100, 130, 14}, hint_state) &&
+            ui->midi_learn) {
+            DrawText(ui->learn_param >= 0 ? "Move a controller" : "Touch a control",
+                     panel_x + 160, panel_y + 100, 12, LEARN_COLOR);
+        }
+
+        // Preset crossfade toggle
+        panel_x += PANEL_WIDTH + PANEL_MARGIN;
+        draw_panel(ui, panel_x, panel_y, PANEL_WIDTH - 60, content_height, "PRESETS");
+        draw_label(ui, "Load Xfade:", panel_x + 20, panel_y + 40, 14, TEXT_COLOR);
+
+        Rectangle xf_on_btn = {panel_x + 120, panel_y + 35, 50, 28};
+        Rectangle xf_off_btn = {panel_x + 175, panel_y + 35, 50, 28};
+        if (widget_begin(ui, (Rectangle){xf_on_btn.x, xf_on_btn.y, 105, 28}, hash_int(0, ui->preset_xfade))) {
+            DrawRectangleRec(xf_on_btn, ui->preset_xfade ? SLIDER_FG : SLIDER_BG);
+            DrawText("ON", xf_on_btn.x + 15, xf_on_btn.y + 7, 14, ui->preset_xfade ? BG_COLOR : TEXT_COLOR);
+            DrawRectangleRec(xf_off_btn, !ui->preset_xfade ? SLIDER_FG : SLIDER_BG);
+            DrawText("OFF", xf_off_btn.x + 11, xf_off_btn.y + 7, 14, !ui->preset_xfade ? BG_COLOR : TEXT_COLOR);
+        }
+
+        if (pressed(ui)) {
+            Vector2 mouse = GetTransformedTouch();
+            if (CheckCollisionPointRec(mouse, xf_on_btn)) ui->preset_xfade = true;
+            if (CheckCollisionPointRec(mouse, xf_off_btn)) ui->preset_xfade = false;
+        }
+
+        // Tuning (presets/tuning.scl + .kbm, re-read on RELOAD)
+        draw_label(ui, "Tuning:", panel_x + 20, panel_y + 80, 14, TEXT_COLOR);
+        if (widget_begin(ui, (Rectangle){panel_x + 20, panel_y + 100, PANEL_WIDTH - 90, 16},
+                         hash_str(0, ui->tuning_name))) {
+            DrawText(ui->tuning_name, panel_x + 20, panel_y + 100, 14, WAVE_COLOR);
+        }
+        Rectangle tuning_btn = {panel_x + 20, panel_y + 125, 90, 28};
+        draw_static_button(ui, tuning_btn, SLIDER_BG, "RELOAD", 17, 7, 14, TEXT_COLOR);
+
+        if (pressed(ui)) {
+            Vector2 mouse = GetTransformedTouch();
+            if (CheckCollisionPointRec(mouse, tuning_btn)) ui->tuning_reload = true;
+        }
+
+        // Selected part: on/off, MIDI channel and effects send
+        if (ui->multi) {
+            Part *part = &ui->multi->parts[ui->selected_part];
+            panel_x += PANEL_WIDTH - 60 + PANEL_MARGIN;
+            draw_panel(ui, panel_x, panel_y, SCREEN_WIDTH - PANEL_MARGIN - panel_x, content_height, NULL);
+            if (widget_begin(ui, (Rectangle){panel_x + 10, panel_y + 5, 80, 18},
+                             hash_int(0, ui->selected_part))) {
+                char title[24];
+                snprintf(title, sizeof(title), "PART %d", ui->selected_part + 1);
+                DrawText(title, panel_x + 10, panel_y + 5, 16, TEXT_COLOR);
+            }
+
+            Rectangle on_btn = {panel_x + 10, panel_y + 35, 50, 28};
+            Rectangle off_btn = {panel_x + 65, panel_y + 35, 50, 28};
+            if (widget_begin(ui, (Rectangle){on_btn.x, on_btn.y, 105, 28}, hash_int(0, part->enabled))) {
+                DrawRectangleRec(on_btn, part->enabled ? SLIDER_FG : SLIDER_BG);
+                DrawText("ON", on_btn.x + 15, on_btn.y + 7, 14, part->enabled ? BG_COLOR : TEXT_COLOR);
+                DrawRectangleRec(off_btn, !part->enabled ? SLIDER_FG : SLIDER_BG);
+                DrawText("OFF", off_btn.x + 11, off_btn.y + 7, 14, !part->enabled ? BG_COLOR : TEXT_COLOR);
+            }
+
+            draw_label(ui, "Ch", panel_x + 10, panel_y + 80, 16, TEXT_COLOR);
+            Rectangle ch_prev = {panel_x + 60, panel_y + 75, 30, 28};
+            Rectangle ch_next = {panel_x + 170, panel_y + 75, 30, 28};
+            draw_static_button(ui, ch_prev, SLIDER_BG, "<", 10, 5, 18, TEXT_COLOR);
+            draw_static_button(ui, ch_next, SLIDER_BG, ">", 10, 5, 18, TEXT_COLOR);
+            if (widget_begin(ui, (Rectangle){panel_x + 95, panel_y + 75, 70, 28},
+                             hash_int(0, part->channel))) {
+                char ch_str[12];
+                if (part->channel == PART_OMNI) {
+                    snprintf(ch_str, sizeof(ch_str), "Omni");
+                } else {
+                    snprintf(ch_str, sizeof(ch_str), "%d", part->channel + 1);
+                }
+                DrawText(ch_str, panel_x + 100, panel_y + 80, 16, WAVE_COLOR);
+            }
+
+            if (pressed(ui)) {
+                Vector2 mouse = GetTransformedTouch();
+                if (CheckCollisionPointRec(mouse, on_btn)) part->enabled = 1;
+                if (CheckCollisionPointRec(mouse, off_btn)) {
+                    // Release held notes so the part does not resume mid-note
+                    part->enabled = 0;
+                    synth_panic(&part->synth);
+                    arp_clear(&part->arp);
+                }
+                // Channel steps through Omni, 1..16
+                if (CheckCollisionPointRec(mouse, ch_prev)) {
+                    part->channel = (part->channel <= PART_OMNI) ? 15 : part->channel - 1;
+                }
+                if (CheckCollisionPointRec(mouse, ch_next)) {
+                    part->channel = (part->channel >= 15) ? PART_OMNI : part->channel + 1;
+                }
+            }
+
+            part->fx_send = draw_slider(ui, "Send", part->fx_send, part->fx_send, false,
+                                        panel_x + 10, panel_y + 120, CTRL_PART_SEND);
+        }
     }
+}
 
-    // Waveform display (bottom area)
-    int wave_y = panel_y + content_height + 15;
+void ui_draw(UI *ui) {
+    // Anything that moves or replaces widgets repaints the whole screen, and
+    // without a chrome cache every frame is a full one
+    unsigned int layout = hash_int(hash_int(0, ui->current_page), ui->selected_part);
+    layout = hash_int(hash_int(layout, ui->editing_name), ui->midi_learn);
+    ui->full_redraw = ui->redraw_all || layout != ui->layout_key || !ui->chrome_cached;
+    ui->redraw_all = false;
+    ui->layout_key = layout;
+    ui->widget_count = 0;
+    ui->widgets_drawn = 0;
+
+    if (ui->full_redraw) {
+        if (ui->chrome_cached) {
+            Rectangle src = {0, 0, SCREEN_WIDTH, -UI_CHROME_HEIGHT};
+            DrawTextureRec(ui->chrome[ui->current_page].texture, src, (Vector2){0, 0}, WHITE);
+            DrawRectangle(0, UI_CHROME_HEIGHT, SCREEN_WIDTH, SCREEN_HEIGHT - UI_CHROME_HEIGHT, BG_COLOR);
+        } else {
+            ClearBackground(BG_COLOR);
+        }
+    }
+
+    draw_controls(ui);
+
+    // Scope (left) and spectrum (right) below the controls, live every frame
+    int wave_y = UI_CHROME_HEIGHT + 10;
     int wave_height = SCREEN_HEIGHT - wave_y - 10;
-    int wave_width = SCREEN_WIDTH - 40;
+    int wave_width = (SCREEN_WIDTH - 50) / 2;
 
-    DrawRectangle(20, wave_y, wave_width, wave_height, PANEL_COLOR);
+    draw_scope(ui, 20, wave_y, wave_width, wave_height);
+    draw_spectrum(ui, 30 + wave_width, wave_y, wave_width, wave_height);
 
-    // Draw waveform
-    int center_y = wave_y + wave_height / 2;
-    int prev_y = center_y;
+    // FPS counter (follows the frame rate, so not counted as a change)
+    int drawn = ui->widgets_drawn;
+    if (widget_begin(ui, (Rectangle){SCREEN_WIDTH - 80, 8, 75, 20}, hash_int(0, GetFPS()))) {
+        DrawFPS(SCREEN_WIDTH - 80, 8);
+    }
+    ui->widgets_drawn = drawn;
 
-    for (int i = 0; i < 256; i++) {
-        int idx = (ui->waveform_pos + i) % 256;
-        int y_pos = center_y - (int)(ui->waveform_buffer[idx] * (wave_height / 2 - 5));
-        int x_pos = 25 + (i * (wave_width - 10)) / 256;
+    // Widgets appeared or went away mid-page (e.g. the wavetable controls)
+    if (!ui->full_redraw && ui->widget_count != ui->last_widget_count) {
+        ui->redraw_all = true;
+    }
+    ui->last_widget_count = ui->widget_count;
+}
 
-        if (i > 0) {
-            DrawLine(25 + ((i - 1) * (wave_width - 10)) / 256, prev_y,
-                     x_pos, y_pos, WAVE_COLOR);
-        }
-        prev_y = y_pos;
+void ui_load_chrome(UI *ui) {
+    int page = ui->current_page;
+    ui->chrome_pass = true;
+    for (int i = 0; i < UI_PAGE_COUNT; i++) {
+        ui->chrome[i] = LoadRenderTexture(SCREEN_WIDTH, UI_CHROME_HEIGHT);
+        ui->current_page = i;
+        BeginTextureMode(ui->chrome[i]);
+        ClearBackground(BG_COLOR);
+        draw_controls(ui);
+        EndTextureMode();
     }
+    ui->chrome_pass = false;
+    ui->current_page = page;
+    ui->chrome_cached = true;
+    ui->redraw_all = true;
+}
 
-    // FPS counter
-    DrawFPS(SCREEN_WIDTH - 80, 8);
+void ui_unload_chrome(UI *ui) {
+    if (!ui->chrome_cached) return;
+    for (int i = 0; i < UI_PAGE_COUNT; i++) {
+        UnloadRenderTexture(ui->chrome[i]);
+    }
+    ui->chrome_cached = false;
+    ui->redraw_all = true;
 }
 
-void ui_add_sample(UI *ui, float sample) {
-    // Downsample for display (only update every ~172 samples for 256 point display at 44100Hz)
-    static int sample_count = 0;
-    sample_count++;
-    if (sample_count >= 172) {
-        ui->waveform_buffer[ui->waveform_pos] = sample;
-        ui->waveform_pos = (ui->waveform_pos + 1) % 256;
-        sample_count = 0;
+void ui_analyse(UI *ui) {
+    ui->scope_valid = ui->scope &&
+        scope_read(ui->scope, ui->scope_buffer, UI_SCOPE_SAMPLES) == UI_SCOPE_SAMPLES;
+    if (ui->scope_valid) {
+        spectrum_process(&ui->spectrum,
+                         ui->scope_buffer + UI_SCOPE_SAMPLES - SPECTRUM_SIZE, SCOPE_FALL_DB);
     }
 }
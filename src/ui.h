@@ -4,6 +4,12 @@
 #include "synth.h"
 #include "effects.h"
 #include "arp.h"
+#include "bank.h"
+#include "param.h"
+#include "midimap.h"
+#include "multi.h"
+#include "scope.h"
+#include "spectrum.h"
 #include "raylib.h"
 #include <stdbool.h>
 
@@ -11,44 +17,94 @@
 #define SCREEN_WIDTH  1280
 #define SCREEN_HEIGHT 400
 
+// Output samples fetched per frame for the scope and spectrum
+#define UI_SCOPE_SAMPLES (SCOPE_RING_SIZE / 2)
+
+// Dirty-region rendering
+#define UI_PAGE_COUNT    7
+#define UI_CHROME_HEIGHT 240    // Controls area held in the chrome cache
+#define UI_MAX_WIDGETS   96     // Widgets tracked per frame
+
 typedef struct {
     // Pointers to synth, effects, and arp for parameter control
     Synth *synth;
     Effects *effects;
     Arpeggiator *arp;
+    ParamContext params;    // Registry access to the three above
+    const Bank *bank;       // Compiled preset bank (may be empty)
+    MidiMap *midimap;       // CC assignments (saved with presets)
+    Multi *multi;           // Parts (synth/arp above point into the selected one)
+    int selected_part;      // Part being edited, 0-based
 
     // UI state
     int current_page;       // 0 = OSC, 1 = FLT, 2 = FX, 3 = MOD, 4 = PRESET
-    int selected_wave;
-    int selected_wave2;
-    int selected_filter;
-    int selected_lfo;
     int current_preset;     // 1-99
     char preset_name[32];   // Current preset name
     bool editing_name;      // True when editing preset name
 
     // Settings
     int buffer_size;        // 0=512, 1=256, 2=128
+    bool buffer_auto;       // Buffer size picked by main from underruns
     bool panic_triggered;   // True when panic button pressed
-    bool buffer_changed;    // True when buffer size changed (needs restart)
+    bool buffer_changed;    // True when buffer size changed (applied by main)
+    bool load_requested;    // True when LOAD pressed (handled by background loader)
+    bool preset_xfade;      // Crossfade between presets on load
+    bool midi_learn;        // Learn mode: touch a control, then move a MIDI controller
+    int learn_param;        // ParamId waiting for a controller, -1 = none
+    bool tuning_reload;     // True when RELOAD pressed (Scala files re-read by main)
+    bool snapshot_save;     // True when state SAVE pressed (engine snapshot by main)
+    bool snapshot_restore;  // True when state RESTORE pressed
+    char tuning_name[TUNING_NAME_LEN];  // Installed tuning
+
+    // Oscilloscope and spectrum display
+    const ScopeRing *scope; // Engine output tap (NULL = blank display)
+    float scope_buffer[UI_SCOPE_SAMPLES];  // Newest output, oldest first
+    bool scope_valid;       // scope_buffer holds a complete read
+    Spectrum spectrum;
+    float limiter_gr;       // Master limiter gain reduction, dB (set by main)
 
-    // Waveform display buffer
-    float waveform_buffer[256];
-    int waveform_pos;
+    // Dirty-region rendering: panel chrome is drawn once per page into a
+    // cached texture; widgets repaint only when what they show changes
+    RenderTexture2D chrome[UI_PAGE_COUNT];  // Static layer per page (ui_load_chrome)
+    bool chrome_cached;     // chrome[] is loaded
+    bool chrome_pass;       // Drawing into chrome[] (no widgets, no input)
+    bool full_redraw;       // This frame repaints every widget
+    bool redraw_all;        // Repaint everything next frame
+    unsigned int layout_key;                    // Page/part/mode of the last frame
+    unsigned int widget_state[UI_MAX_WIDGETS];  // What each widget last showed
+    int widget_count;       // Widgets visited this frame
+    int last_widget_count;
+    int widgets_drawn;      // Widgets repainted this frame
+
+    // Frame statistics (written by main, shown on the SET page)
+    float frame_ms;         // UI work per frame (analyse + draw)
+    float frame_cpu;        // UI thread CPU time, percent of one core
+    float frame_redrawn;    // Widgets repainted per frame
+    bool idle_audio;        // Engine is skipping silent blocks
+    bool idle_ui;           // Main loop is at the idle frame rate
+
+    int shown_preset;       // Slot whose name is in preset_name, -1 = reread
 
     // Touch state
-    int active_control;     // -1 = none
+    int active_control;     // ParamId being dragged, -1 = none
     float drag_start_value;
     float last_touch_x;     // Last known touch X position
     float last_touch_y;     // Last known touch Y position
     bool was_touching;      // Was touching last frame
 } UI;
 
-void ui_init(UI *ui, Synth *synth, Effects *effects, Arpeggiator *arp);
+void ui_init(UI *ui, Synth *synth, Effects *effects, Arpeggiator *arp, MidiMap *midimap);
 void ui_update(UI *ui);
 void ui_draw(UI *ui);
 
-// Add sample to waveform display
-void ui_add_sample(UI *ui, float sample);
+// Render every page's static chrome into cached textures (after the window
+// and ui->multi are set up, outside any texture mode). Without it, ui_draw
+// repaints the chrome on each full redraw.
+void ui_load_chrome(UI *ui);
+void ui_unload_chrome(UI *ui);
+
+// Fetch the newest output from ui->scope and analyse it. Needs no lock, so
+// call it before taking the engine lock for ui_draw.
+void ui_analyse(UI *ui);
 
 #endif // UI_H
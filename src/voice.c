@@ -1,4 +1,5 @@
 #include "voice.h"
+#include "smooth.h"  // for CONTROL_BLOCK
 
 void voice_init(Voice *v) {
     osc_init(&v->osc);
@@ -15,6 +16,14 @@ void voice_init(Voice *v) {
     v->osc_mix = 0.0f;      // Default to osc1 only
     v->osc2_detune = 0.0f;  // No detune by default
     v->sub_osc_mix = 0.0f;  // No sub by default
+    v->unison_width = 0.0f;
+    v->pan_spread = 0.0f;
+    v->key_pan = 0.0f;
+    v->placed_count = 0;    // Gains are set on the first voice_set_stereo
+    for (int i = 0; i < MAX_UNISON; i++) {
+        v->unison_gain[i] = stereo_mono(1.0f);
+    }
+    v->pan_gain = stereo_mono(1.0f);
     v->pulse_width = 0.5f;  // 50% duty cycle
     lfo_init(&v->pwm_lfo);
     env_init(&v->env);
@@ -24,32 +33,39 @@ void voice_init(Voice *v) {
     filter_init(&v->filter);
     v->base_filter_cutoff = 0.5f;
 
+    v->note_inc = 0.0f;
+    v->bend = 0.0f;
+    v->expr_gain = 1.0f;
+    v->expr_cutoff = 0.0f;
+
+    v->shed = 0;
+    v->mod_countdown = 0;
+    v->stolen = 0;
+
     v->note = -1;
     v->velocity = 0;
     v->age = 0;
 }
 
-// Need math.h for powf
+// Need math.h for sqrtf
 #include <math.h>
 
-void voice_note_on(Voice *v, int note, int velocity) {
-    v->note = note;
-    v->velocity = velocity;
-    v->age = 0;
-
-    // Set oscillator frequency from MIDI note
-    float freq = midi_to_freq(note);
-    osc_set_frequency(&v->osc, freq);
+// Set every oscillator's phase step from the note, bend and detune
+// (detune ratios come from the cents table, no powf)
+static void voice_tune(Voice *v) {
+    float inc = v->note_inc;
+    if (v->bend != 0.0f) {
+        inc *= cents_to_ratio(v->bend * 100.0f);
+    }
+    osc_set_increment(&v->osc, inc);
 
-    // Apply detune to osc2 (cents to frequency multiplier: 2^(cents/1200))
-    float detune_mult = powf(2.0f, v->osc2_detune / 1200.0f);
-    osc_set_frequency(&v->osc2, freq * detune_mult);
+    // Apply detune to osc2
+    osc_set_increment(&v->osc2, inc * cents_to_ratio(v->osc2_detune));
 
     // Sub-oscillator at octave down
-    osc_set_frequency(&v->sub_osc, freq * 0.5f);
+    osc_set_increment(&v->sub_osc, inc * 0.5f);
 
-    // Set up unison oscillators with spread detuning
-    // Spread oscillators symmetrically around the base frequency
+    // Spread unison oscillators symmetrically around the base frequency
     if (v->unison_count > 1) {
         int extra_oscs = v->unison_count - 1;
         for (int i = 0; i < extra_oscs; i++) {
@@ -63,12 +79,74 @@ void voice_note_on(Voice *v, int note, int velocity) {
                 // Spread evenly: -spread, ..., +spread
                 detune_cents = -v->unison_spread + (2.0f * v->unison_spread * i / (extra_oscs - 1));
             }
-            float uni_mult = powf(2.0f, detune_cents / 1200.0f);
-            osc_set_frequency(&v->unison_oscs[i], freq * uni_mult);
+            osc_set_increment(&v->unison_oscs[i], inc * cents_to_ratio(detune_cents));
+        }
+    }
+}
+
+// Pan gains for the unison copies and the voice. Copies sit across
+// -width..+width in detune order (osc1, undetuned, in the middle), and the
+// 1/sqrt(count) unison level is folded into their gains.
+static void voice_place(Voice *v) {
+    int count = v->unison_count;
+    float level = (count > 1) ? 1.0f / sqrtf((float)count) : 1.0f;
+    float width = v->unison_width;
+
+    if (count == 2) {
+        v->unison_gain[0] = stereo_pan(-width) * level;
+        v->unison_gain[1] = stereo_pan(width) * level;
+    } else {
+        v->unison_gain[0] = stereo_pan(0.0f) * level;
+        int extra_oscs = count - 1;
+        for (int i = 0; i < extra_oscs; i++) {
+            float position = -width + 2.0f * width * i / (extra_oscs - 1);
+            v->unison_gain[i + 1] = stereo_pan(position) * level;
+        }
+    }
+    v->pan_gain = stereo_pan(v->key_pan * v->pan_spread);
+    v->placed_count = count;
+}
+
+void voice_set_stereo(Voice *v, float unison_width, float pan_spread) {
+    if (unison_width == v->unison_width && pan_spread == v->pan_spread &&
+        v->unison_count == v->placed_count) {
+        return;
+    }
+    v->unison_width = unison_width;
+    v->pan_spread = pan_spread;
+    voice_place(v);
+}
+
+void voice_set_bend(Voice *v, float semitones) {
+    v->bend = semitones;
+    voice_tune(v);
+}
+
+void voice_note_on(Voice *v, int note, int velocity, uint32_t increment) {
+    v->note = note;
+    v->velocity = velocity;
+    v->age = 0;
+    v->stolen = 0;
+    v->mod_countdown = 0;
+
+    // Set oscillator pitches for the note (plus any bend already applied)
+    v->note_inc = (float)increment;
+    voice_tune(v);
+
+    // Place the note by key: two octaves either side of middle C reach the edges
+    v->key_pan = (note - 60) / 24.0f;
+    if (v->key_pan < -1.0f) v->key_pan = -1.0f;
+    if (v->key_pan > 1.0f) v->key_pan = 1.0f;
+    voice_place(v);
+
+    // Set up unison oscillators
+    if (v->unison_count > 1) {
+        int extra_oscs = v->unison_count - 1;
+        for (int i = 0; i < extra_oscs; i++) {
             osc_set_type(&v->unison_oscs[i], v->osc.type);
             osc_set_pulse_width(&v->unison_oscs[i], v->pulse_width);
             // Randomize phase for each unison osc for a fuller sound
-            v->unison_oscs[i].phase = (float)(i * 0.14159f);  // Spread phases
+            v->unison_oscs[i].phase = (uint32_t)(i * 0.14159f * PHASE_CYCLE);  // Spread phases
         }
     }
 
@@ -89,9 +167,9 @@ void voice_note_off(Voice *v) {
     v->note = -1;
 }
 
-float voice_process(Voice *v) {
+Stereo voice_process(Voice *v) {
     if (!voice_is_active(v)) {
-        return 0.0f;
+        return stereo_mono(0.0f);
     }
 
     // Apply PWM modulation to oscillators
@@ -102,47 +180,56 @@ float voice_process(Voice *v) {
     osc_set_pulse_width(&v->osc, mod_pw);
     osc_set_pulse_width(&v->osc2, mod_pw);
 
-    // Generate main oscillator with unison
-    float osc1_out = osc_generate(&v->osc);
+    // Generate main oscillator with unison, each copy at its own pan
+    // (the gains include the sqrt(count) normalization)
+    Stereo osc1_out;
+    int unison = v->unison_count > 1;
+    if (unison && (v->shed & VOICE_SHED_UNISON) && v->env.stage == ENV_RELEASE) {
+        // Under load a releasing voice keeps osc1 alone at the same power
+        osc1_out = stereo_mono(osc_generate(&v->osc));
+        unison = 0;
+    } else {
+        osc1_out = osc_generate(&v->osc) * v->unison_gain[0];
+    }
 
     // Add unison oscillators to osc1
-    if (v->unison_count > 1) {
+    if (unison) {
         int extra_oscs = v->unison_count - 1;
         for (int i = 0; i < extra_oscs; i++) {
             osc_set_pulse_width(&v->unison_oscs[i], mod_pw);
-            osc1_out += osc_generate(&v->unison_oscs[i]);
+            osc1_out += osc_generate(&v->unison_oscs[i]) * v->unison_gain[i + 1];
         }
-        // Gentle normalization using sqrt to preserve volume
-        osc1_out /= sqrtf((float)v->unison_count);
     }
 
     float osc2_out = osc_generate(&v->osc2);
     float sub_out = osc_generate(&v->sub_osc);
 
-    // Mix main oscillators, then add sub
-    float main_mix = osc1_out * (1.0f - v->osc_mix) + osc2_out * v->osc_mix;
-    float sample = main_mix * (1.0f - v->sub_osc_mix * 0.5f) + sub_out * v->sub_osc_mix * 0.5f;
+    // Mix main oscillators, then add sub (osc2 and sub sit in the centre)
+    float centre = osc2_out * v->osc_mix * (1.0f - v->sub_osc_mix * 0.5f) +
+                   sub_out * v->sub_osc_mix * 0.5f;
+    Stereo sample = osc1_out * ((1.0f - v->osc_mix) * (1.0f - v->sub_osc_mix * 0.5f)) +
+                    stereo_mono(centre);
 
     // Calculate filter modulation
     float filter_env_level = env_process(&v->filter_env);
     float filter_env_mod = filter_env_level * v->filter_env_amount;
     float lfo_mod = lfo_process(&v->filter_lfo);
 
-    // Apply modulation to filter cutoff
-    float mod_cutoff = v->base_filter_cutoff + filter_env_mod + lfo_mod;
-    if (mod_cutoff < 0.0f) mod_cutoff = 0.0f;
-    if (mod_cutoff > 1.0f) mod_cutoff = 1.0f;
-    filter_set_cutoff(&v->filter, mod_cutoff);
+    // Apply modulation to filter cutoff (every CONTROL_BLOCK samples under load)
+    if (!(v->shed & VOICE_SHED_MOD) || --v->mod_countdown <= 0) {
+        float mod_cutoff = v->base_filter_cutoff + filter_env_mod + lfo_mod + v->expr_cutoff;
+        if (mod_cutoff < 0.0f) mod_cutoff = 0.0f;
+        if (mod_cutoff > 1.0f) mod_cutoff = 1.0f;
+        filter_set_cutoff(&v->filter, mod_cutoff);
+        v->mod_countdown = CONTROL_BLOCK;
+    }
 
     // Apply filter
     sample = filter_process(&v->filter, sample);
 
-    // Apply envelope
+    // Apply envelope, velocity scaling and pressure, then the voice pan
     float env_level = env_process(&v->env);
-    sample *= env_level;
-
-    // Apply velocity scaling
-    sample *= (float)v->velocity / 127.0f;
+    sample *= v->pan_gain * (env_level * (float)v->velocity / 127.0f * v->expr_gain);
 
     // Check if envelope has finished
     if (!env_is_active(&v->env)) {
@@ -155,6 +242,19 @@ float voice_process(Voice *v) {
     return sample;
 }
 
-int voice_is_active(Voice *v) {
+int voice_is_active(const Voice *v) {
     return v->note >= 0 || env_is_active(&v->env);
 }
+
+void voice_steal(Voice *v) {
+    if (!voice_is_active(v)) return;
+    v->note = -1;
+    v->stolen = 1;
+    v->env.stage = ENV_RELEASE;
+    v->env.rate = v->env.level / (VOICE_STEAL_MS * 0.001f * sample_rate);
+    if (v->env.rate <= 0.0f) v->env.stage = ENV_IDLE;
+}
+
+float voice_level(const Voice *v) {
+    return v->env.level * (float)v->velocity / 127.0f * v->expr_gain;
+}
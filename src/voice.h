@@ -5,9 +5,16 @@
 #include "envelope.h"
 #include "filter.h"
 #include "lfo.h"
+#include "tuning.h"
 
 #define MAX_UNISON 7    // Maximum unison voices (including main)
 
+// Quality reductions under load (flags, set by the engine's governor)
+#define VOICE_SHED_UNISON   1   // Releasing voices play osc1 alone, centred
+#define VOICE_SHED_MOD      2   // Filter cutoff follows modulation at control rate
+
+#define VOICE_STEAL_MS 5.0f     // Fade of a voice stolen under load
+
 typedef struct {
     Oscillator osc;
     Oscillator osc2;    // Second oscillator for mixing
@@ -21,6 +28,14 @@ typedef struct {
     float osc2_detune;  // Detune in cents (-100 to +100)
     float sub_osc_mix;  // 0.0 = no sub, 1.0 = full sub
 
+    // Stereo placement (voice_set_stereo)
+    float unison_width;     // Unison copies spread across the field (0-1)
+    float pan_spread;       // Voices placed by key across the field (0-1)
+    float key_pan;          // This note's place at full spread (-1 to +1)
+    int placed_count;       // unison_count the gains below were set for
+    Stereo unison_gain[MAX_UNISON];  // Pan and level of osc1 and each copy
+    Stereo pan_gain;        // Pan of the whole voice
+
     // Pulse Width Modulation
     float pulse_width;      // Base pulse width (0.05-0.95)
     LFO pwm_lfo;            // LFO for pulse width modulation
@@ -32,15 +47,40 @@ typedef struct {
     SVFilter filter;
     float base_filter_cutoff;   // Original cutoff before modulation
 
+    // Per-note expression (set at control rate from the synth's lanes)
+    float note_inc;             // Phase step of the note before bend (from the tuning)
+    float bend;                 // Pitch offset in semitones
+    float expr_gain;            // Level multiplier from pressure
+    float expr_cutoff;          // Cutoff offset from timbre
+
+    // Load shedding
+    int shed;                   // VOICE_SHED_* flags
+    int mod_countdown;          // Samples until the next cutoff update (VOICE_SHED_MOD)
+    int stolen;                 // Fading out after voice_steal
+
     int note;           // MIDI note number (-1 = inactive)
     int velocity;       // MIDI velocity (0-127)
     unsigned int age;   // for voice stealing (older = higher)
 } Voice;
 
 void voice_init(Voice *v);
-void voice_note_on(Voice *v, int note, int velocity);
+// increment is the note's phase step from the synth's tuning table
+void voice_note_on(Voice *v, int note, int velocity, uint32_t increment);
 void voice_note_off(Voice *v);
-float voice_process(Voice *v);
-int voice_is_active(Voice *v);
+Stereo voice_process(Voice *v);
+
+// Retune a sounding voice (semitones from the note)
+void voice_set_bend(Voice *v, float semitones);
+
+// Set the unison width and key pan spread (recomputes the pan gains only
+// when they or the unison count changed)
+void voice_set_stereo(Voice *v, float unison_width, float pan_spread);
+int voice_is_active(const Voice *v);
+
+// Fade a voice out over VOICE_STEAL_MS to free its time (load governor)
+void voice_steal(Voice *v);
+
+// Current output level, for choosing which voice to steal
+float voice_level(const Voice *v);
 
 #endif // VOICE_H
@@ -1,12 +1,15 @@
 #include "wavetable.h"
+#include "arena.h"
 #include <math.h>
+#include <pthread.h>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+// Built once per process, then shared read-only by every oscillator
 static Wavetable wavetables[WT_COUNT];
-static int initialized = 0;
+static pthread_once_t wavetables_once = PTHREAD_ONCE_INIT;
 
 static const char *wt_names[] = {
     "Basic",
@@ -109,9 +112,7 @@ static void generate_formant_frame(float *frame, float formant_freq) {
     }
 }
 
-void wavetables_init(void) {
-    if (initialized) return;
-
+static void build_wavetables(void) {
     // WT_BASIC: Morph sine -> triangle -> saw -> square
     for (int f = 0; f < WT_NUM_FRAMES; f++) {
         float pos = (float)f / (WT_NUM_FRAMES - 1);
@@ -159,23 +160,25 @@ void wavetables_init(void) {
     }
     wavetables[WT_FORMANT].type = WT_FORMANT;
 
-    initialized = 1;
+    // Every voice reads these; keep them resident (best effort)
+    arena_lock_region(wavetables, sizeof(wavetables));
+}
+
+void wavetables_init(void) {
+    pthread_once(&wavetables_once, build_wavetables);
 }
 
-Wavetable* wavetable_get(WavetableType type) {
+const Wavetable* wavetable_get(WavetableType type) {
+    wavetables_init();
     if (type >= WT_COUNT) type = WT_BASIC;
     return &wavetables[type];
 }
 
-float wavetable_sample(Wavetable *wt, float position, float phase) {
+float wavetable_sample(const Wavetable *wt, float position, uint32_t phase) {
     // Clamp position
     if (position < 0.0f) position = 0.0f;
     if (position > 1.0f) position = 1.0f;
 
-    // Wrap phase
-    phase = phase - (int)phase;
-    if (phase < 0.0f) phase += 1.0f;
-
     // Calculate frame indices for interpolation
     float frame_pos = position * (WT_NUM_FRAMES - 1);
     int frame_lo = (int)frame_pos;
@@ -183,11 +186,10 @@ float wavetable_sample(Wavetable *wt, float position, float phase) {
     if (frame_hi >= WT_NUM_FRAMES) frame_hi = WT_NUM_FRAMES - 1;
     float frame_frac = frame_pos - frame_lo;
 
-    // Calculate sample index for interpolation
-    float sample_pos = phase * WT_FRAME_SIZE;
-    int sample_lo = (int)sample_pos;
-    int sample_hi = (sample_lo + 1) % WT_FRAME_SIZE;
-    float sample_frac = sample_pos - sample_lo;
+    // Sample index from the top bits of the phase, fraction from the rest
+    int sample_lo = phase >> 24;
+    int sample_hi = (sample_lo + 1) & (WT_FRAME_SIZE - 1);
+    float sample_frac = (phase & 0xFFFFFF) * (1.0f / 16777216.0f);
 
     // Bilinear interpolation (frame and sample)
     float s00 = wt->data[frame_lo][sample_lo];
@@ -1,7 +1,9 @@
 #ifndef WAVETABLE_H
 #define WAVETABLE_H
 
-#define WT_FRAME_SIZE 256    // Samples per frame
+#include <stdint.h>
+
+#define WT_FRAME_SIZE 256    // Samples per frame (top 8 bits of a phase)
 #define WT_NUM_FRAMES 64     // Frames per wavetable
 
 typedef enum {
@@ -17,15 +19,16 @@ typedef struct {
     WavetableType type;
 } Wavetable;
 
-// Initialize all wavetables (call once at startup)
+// Build the wavetables (thread-safe, runs once per process; wavetable_get
+// also triggers it)
 void wavetables_init(void);
 
-// Get pointer to a wavetable
-Wavetable* wavetable_get(WavetableType type);
+// Get pointer to a shared, read-only wavetable
+const Wavetable* wavetable_get(WavetableType type);
 
-// Sample a wavetable with position (0-1) and phase (0-1)
+// Sample a wavetable with position (0-1) and a 32-bit oscillator phase
 // Position selects frame (with interpolation), phase selects sample
-float wavetable_sample(Wavetable *wt, float position, float phase);
+float wavetable_sample(const Wavetable *wt, float position, uint32_t phase);
 
 // Get wavetable name for UI
 const char* wavetable_name(WavetableType type);
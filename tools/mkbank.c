@@ -0,0 +1,78 @@
+// Preset bank compiler
+// Converts the JSON presets in a directory into a binary bank file that the
+// synth memory-maps at startup.
+//
+// Usage: mkbank [preset_dir] [output]
+//   defaults: presets presets/bank.bsb
+
+#include "bank.h"
+#include "preset.h"
+#include "wavetable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char **argv) {
+    const char *dir = (argc > 1) ? argv[1] : PRESET_DIR;
+    const char *out = (argc > 2) ? argv[2] : BANK_FILE;
+
+    wavetables_init();
+    params_init();
+
+    // Keys missing from a preset get engine defaults, as in a JSON load
+    const Patch *defaults = patch_defaults();
+
+    Patch *patches = malloc(sizeof(Patch) * BANK_MAX_SLOT);
+    BankEntry *entries = calloc(BANK_MAX_SLOT, sizeof(BankEntry));
+    if (!patches || !entries) {
+        fprintf(stderr, "mkbank: out of memory\n");
+        return 1;
+    }
+
+    int count = 0;
+    int failed = 0;
+    for (int slot = 1; slot <= BANK_MAX_SLOT; slot++) {
+        char path[256];
+        snprintf(path, sizeof(path), "%s/%03d.json", dir, slot);
+
+        FILE *f = fopen(path, "r");
+        if (!f) continue;
+        fclose(f);
+
+        BankEntry *e = &entries[count];
+        patches[count] = *defaults;
+        if (preset_read(path, e->name, sizeof(e->name), &patches[count]) < 0) {
+            fprintf(stderr, "mkbank: %s: parse error\n", path);
+            failed++;
+            continue;
+        }
+        preset_read_string(path, "tags", e->tags, sizeof(e->tags));
+        e->slot = slot;
+
+        printf("%03d  %-32s %s\n", slot, e->name, e->tags);
+        count++;
+    }
+
+    if (failed > 0) {
+        fprintf(stderr, "mkbank: %d preset(s) failed, bank not written\n", failed);
+        return 1;
+    }
+
+    if (bank_write(out, patches, entries, count) < 0) {
+        fprintf(stderr, "mkbank: failed to write %s\n", out);
+        return 1;
+    }
+
+    // Verify by mapping the result back
+    Bank bank;
+    if (bank_open(&bank, out) < 0) {
+        fprintf(stderr, "mkbank: %s failed verification\n", out);
+        return 1;
+    }
+    printf("Wrote %s: %d presets, %zu bytes\n", out, bank_count(&bank), bank.size);
+    bank_close(&bank);
+
+    free(patches);
+    free(entries);
+    return 0;
+}
@@ -0,0 +1,160 @@
+// Preset load benchmark
+// Times parsing (file read + tokenize into a Patch) and applying each preset
+// in the presets/ directory. Run from the repository root: make bench
+// A build with make PERF=1 then plays a chord through each preset and reports
+// its hardware counters per block (see perfctr.h).
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "preset.h"
+#include "wavetable.h"
+#include "engine.h"
+#include "perfctr.h"
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_ITERATIONS 200
+#define BENCH_BLOCK      256
+#define BENCH_BLOCKS     200    // Blocks measured per preset (chord held)
+#define BENCH_TAIL       400    // Blocks after the release, so presets start quiet
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void play(Engine *e, int type, int velocity) {
+    static const int chord[3] = {60, 64, 67};
+    for (int k = 0; k < 3; k++) {
+        MidiEvent ev = {type, 0, chord[k], velocity};
+        engine_queue_midi(e, &ev);
+    }
+}
+
+static void render(Engine *e, int blocks) {
+    static float buffer[BENCH_BLOCK * 2];
+    for (int i = 0; i < blocks; i++) {
+        engine_render(e, buffer, BENCH_BLOCK);
+    }
+}
+
+static void column(int mask, PerfEvent event, double value, int width) {
+    if (mask & (1 << event)) {
+        printf(" %*.0f", width, value);
+    } else {
+        printf(" %*s", width, "n/a");
+    }
+}
+
+// Cost of rendering each preset, from the hardware counters
+static void bench_counters(void) {
+    int mask = perf_available();
+    if (!mask) {
+        perf_report(stdout);
+        return;
+    }
+    Engine *e = engine_create(DEFAULT_SAMPLE_RATE);
+    if (!e) return;
+    e->govern = 0;      // Measure the presets at full quality
+
+    printf("\n%-5s %-20s %12s %6s %10s %10s\n", "slot", "name", "cycles/blk", "IPC",
+           "L1D/blk", "br/blk");
+    for (int slot = 1; slot <= MAX_PRESETS; slot++) {
+        char path[64];
+        preset_filename(slot, path, sizeof(path));
+        if (!preset_exists(slot) || engine_load_preset(e, 0, path) < 0) continue;
+
+        PerfStats before, after;
+        play(e, MIDI_NOTE_ON, 100);
+        perf_stats(PERF_BLOCK, &before);
+        render(e, BENCH_BLOCKS);
+        perf_stats(PERF_BLOCK, &after);
+        play(e, MIDI_NOTE_OFF, 0);
+        render(e, BENCH_TAIL);
+
+        double blocks = (double)(after.calls - before.calls);
+        double per[PERF_EVENT_COUNT];
+        for (int k = 0; k < PERF_EVENT_COUNT; k++) {
+            per[k] = blocks > 0 ? (after.total[k] - before.total[k]) / blocks : 0.0;
+        }
+        printf("%03d   %-20s", slot, e->multi.parts[0].preset_name);
+        column(mask, PERF_CYCLES, per[PERF_CYCLES], 12);
+        int ipc = (1 << PERF_CYCLES) | (1 << PERF_INSTRUCTIONS);
+        if ((mask & ipc) == ipc && per[PERF_CYCLES] > 0) {
+            printf(" %6.2f", per[PERF_INSTRUCTIONS] / per[PERF_CYCLES]);
+        } else {
+            printf(" %6s", "n/a");
+        }
+        column(mask, PERF_L1D_MISSES, per[PERF_L1D_MISSES], 10);
+        column(mask, PERF_BRANCH_MISSES, per[PERF_BRANCH_MISSES], 10);
+        printf("\n");
+    }
+
+    // Every block rendered above, release tails included
+    printf("\n");
+    perf_report(stdout);
+    engine_destroy(e);
+}
+
+int main(void) {
+    static Synth synth;
+    static Effects effects;
+    Arpeggiator arp;
+
+    wavetables_init();
+    params_init();
+    synth_init(&synth);
+    effects_init(&effects);
+    arp_init(&arp);
+
+    printf("%-5s %-20s %10s %10s %10s\n", "slot", "name", "read us", "max us", "apply us");
+
+    int count = 0;
+    double total_read = 0.0;
+    double total_apply = 0.0;
+
+    for (int slot = 1; slot <= MAX_PRESETS; slot++) {
+        if (!preset_exists(slot)) continue;
+
+        char path[64];
+        char name[PRESET_NAME_LEN];
+        preset_filename(slot, path, sizeof(path));
+
+        Patch patch;
+        patch_capture(&patch, &synth, &effects, &arp);
+
+        double read_sum = 0.0, read_max = 0.0, apply_sum = 0.0;
+        for (int i = 0; i < BENCH_ITERATIONS; i++) {
+            double t0 = now_us();
+            if (preset_read(path, name, sizeof(name), &patch) < 0) {
+                printf("%03d   failed to read %s\n", slot, path);
+                break;
+            }
+            double t1 = now_us();
+            patch_apply(&patch, &synth, &effects, &arp);
+            double t2 = now_us();
+
+            read_sum += t1 - t0;
+            apply_sum += t2 - t1;
+            if (t1 - t0 > read_max) read_max = t1 - t0;
+        }
+
+        printf("%03d   %-20s %10.2f %10.2f %10.2f\n", slot, name,
+               read_sum / BENCH_ITERATIONS, read_max, apply_sum / BENCH_ITERATIONS);
+        total_read += read_sum / BENCH_ITERATIONS;
+        total_apply += apply_sum / BENCH_ITERATIONS;
+        count++;
+    }
+
+    if (count > 0) {
+        printf("\n%d presets, mean read %.2f us, mean apply %.2f us\n",
+               count, total_read / count, total_apply / count);
+    } else {
+        printf("No presets found in %s/\n", PRESET_DIR);
+    }
+
+    bench_counters();
+
+    return 0;
+}
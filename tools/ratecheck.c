@@ -0,0 +1,287 @@
+// Cross-rate check
+// Compares headless renders of the same sequence made at different sample
+// rates (see make check-rates). Each file is cut into the chords
+// buttery-render plays, one per second, and every chord is measured in the
+// Hz domain so the rates line up: its level, the pitch of its strongest
+// partial and its octave band spectrum. The first file is the reference;
+// any other that differs by more than the tolerances fails.
+//
+// The bands stop under the filter's highest cutoff: above it the Chamberlin
+// response (and any aliasing) depends on how close Nyquist is, by design.
+// Pitch is the power-weighted centre of the partial, so detuned unison
+// voices beating differently at each rate do not move it.
+//
+//   ./buttery-ratecheck reference.wav other.wav...
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define CHECK_CHORDS     3          // buttery-render's chords, one per second
+#define CHECK_START      0.25       // Measured part of each second (after the attack)
+#define CHECK_LENGTH     0.5
+#define CHECK_PEAK_LO    80.0       // Strongest partial searched in this range (Hz)
+#define CHECK_PEAK_HI    2000.0
+#define CHECK_PEAK_WIDTH 1.03       // Partial measured within 3% (about half a semitone)
+#define CHECK_PEAK_FIND  1.1        // Other files: the partial is looked for within 10%
+#define CHECK_BAND_LO    63.0       // Octave bands compared (Hz)
+#define CHECK_BANDS      7          // 63 Hz .. 4 kHz
+#define CHECK_BAND_RANGE 30.0       // Bands this far under the loudest are not compared (dB)
+
+#define TOL_LEVEL        1.0        // dB
+#define TOL_PITCH        5.0        // cents
+#define TOL_BAND         4.0        // dB
+
+typedef struct {
+    int rate;
+    long frames;
+    float *mono;
+} Wav;
+
+typedef struct {
+    double level;                   // RMS, dBFS
+    double peak;                    // Centre of the strongest partial, Hz
+    double bands[CHECK_BANDS];      // dB relative to the chord's total
+} Measure;
+
+static uint32_t get_u32(const unsigned char *b) {
+    return b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+// 32-bit float stereo, as buttery-render writes it
+static int wav_read(const char *path, Wav *w) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+
+    unsigned char h[12];
+    if (fread(h, 1, 12, f) != 12 || memcmp(h, "RIFF", 4) != 0 || memcmp(h + 8, "WAVE", 4) != 0) {
+        fclose(f);
+        return -1;
+    }
+
+    int format = 0, channels = 0, bits = 0;
+    w->rate = 0;
+    for (;;) {
+        unsigned char c[8];
+        if (fread(c, 1, 8, f) != 8) break;
+        uint32_t size = get_u32(c + 4);
+        if (memcmp(c, "fmt ", 4) == 0 && size >= 16) {
+            unsigned char fmt[16];
+            if (fread(fmt, 1, 16, f) != 16) break;
+            format = fmt[0] | (fmt[1] << 8);
+            channels = fmt[2] | (fmt[3] << 8);
+            w->rate = (int)get_u32(fmt + 4);
+            bits = fmt[14] | (fmt[15] << 8);
+            fseek(f, size - 16, SEEK_CUR);
+        } else if (memcmp(c, "data", 4) == 0) {
+            if (format != 3 || channels != 2 || bits != 32 || w->rate <= 0) break;
+            w->frames = size / (2 * sizeof(float));
+            float *stereo = malloc(w->frames * 2 * sizeof(float));
+            w->mono = malloc(w->frames * sizeof(float));
+            if (!stereo || !w->mono || fread(stereo, 2 * sizeof(float), w->frames, f) != (size_t)w->frames) {
+                free(stereo);
+                free(w->mono);
+                break;
+            }
+            for (long i = 0; i < w->frames; i++) {
+                w->mono[i] = 0.5f * (stereo[2 * i] + stereo[2 * i + 1]);
+            }
+            free(stereo);
+            fclose(f);
+            return 0;
+        } else {
+            fseek(f, size + (size & 1), SEEK_CUR);
+        }
+    }
+    fclose(f);
+    return -1;
+}
+
+// In-place radix-2 complex FFT (n a power of two)
+static void fft(double *re, double *im, int n) {
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j |= bit;
+        if (i < j) {
+            double t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+    for (int len = 2; len <= n; len <<= 1) {
+        double a = -2.0 * M_PI / len;
+        for (int i = 0; i < n; i += len) {
+            for (int k = 0; k < len / 2; k++) {
+                double wr = cos(a * k), wi = sin(a * k);
+                int p = i + k, q = p + len / 2;
+                double tr = re[q] * wr - im[q] * wi;
+                double ti = re[q] * wi + im[q] * wr;
+                re[q] = re[p] - tr;
+                im[q] = im[p] - ti;
+                re[p] += tr;
+                im[p] += ti;
+            }
+        }
+    }
+}
+
+static double band_centre(int b) {
+    return CHECK_BAND_LO * pow(2.0, b);
+}
+
+// Level, partial and band spectrum of one chord. The partial is the
+// strongest bin near the reference's (anywhere in the search range when
+// centre_hz is 0), measured around that bin. The
+// transform is zero-padded to a power of two, so bins differ per rate but
+// stay near 1 Hz.
+static int measure(const Wav *w, int chord, double centre_hz, Measure *m) {
+    long start = (long)((chord + CHECK_START) * w->rate);
+    int count = (int)(CHECK_LENGTH * w->rate);
+    if (start + count > w->frames) return -1;
+
+    int n = 1;
+    while (n < 2 * count) n <<= 1;
+    double *re = calloc(n, sizeof(double));
+    double *im = calloc(n, sizeof(double));
+    double *power = malloc((n / 2 + 1) * sizeof(double));
+    if (!re || !im || !power) {
+        free(re);
+        free(im);
+        free(power);
+        return -1;
+    }
+
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) {
+        double x = w->mono[start + i];
+        sum += x * x;
+        re[i] = x * (0.5 - 0.5 * cos(2.0 * M_PI * i / count));
+    }
+    m->level = 10.0 * log10(sum / count + 1e-20);
+
+    fft(re, im, n);
+    double bin = (double)w->rate / n;
+    double total = 0.0;
+    for (int k = 0; k <= n / 2; k++) {
+        power[k] = re[k] * re[k] + im[k] * im[k];
+        total += power[k];
+    }
+
+    double find_lo = (centre_hz > 0.0) ? centre_hz / CHECK_PEAK_FIND : CHECK_PEAK_LO;
+    double find_hi = (centre_hz > 0.0) ? centre_hz * CHECK_PEAK_FIND : CHECK_PEAK_HI;
+    int best = (int)(find_lo / bin);
+    for (int k = best; k <= (int)(find_hi / bin); k++) {
+        if (power[k] > power[best]) best = k;
+    }
+    centre_hz = best * bin;
+    double weight = 0.0, moment = 0.0;
+    for (int k = (int)ceil(centre_hz / CHECK_PEAK_WIDTH / bin); k * bin <= centre_hz * CHECK_PEAK_WIDTH; k++) {
+        weight += power[k];
+        moment += power[k] * k * bin;
+    }
+    m->peak = (weight > 0.0) ? moment / weight : centre_hz;
+
+    for (int i = 0; i < CHECK_BANDS; i++) {
+        double lo = band_centre(i) / sqrt(2.0), hi = band_centre(i) * sqrt(2.0);
+        double e = 0.0;
+        for (int k = (int)ceil(lo / bin); k <= n / 2 && k * bin < hi; k++) e += power[k];
+        m->bands[i] = 10.0 * log10(e / (total + 1e-30) + 1e-20);
+    }
+
+    free(re);
+    free(im);
+    free(power);
+    return 0;
+}
+
+static int compare(const char *path, int chord, const Measure *ref, const Measure *m) {
+    int failed = 0;
+
+    double level = m->level - ref->level;
+    double cents = 1200.0 * log2(m->peak / ref->peak);
+    double worst = 0.0;
+    int worst_band = -1;
+    double loudest = -1e9;
+    for (int i = 0; i < CHECK_BANDS; i++) {
+        if (ref->bands[i] > loudest) loudest = ref->bands[i];
+    }
+    for (int i = 0; i < CHECK_BANDS; i++) {
+        if (ref->bands[i] < loudest - CHECK_BAND_RANGE) continue;
+        double d = fabs(m->bands[i] - ref->bands[i]);
+        if (d > worst) {
+            worst = d;
+            worst_band = i;
+        }
+    }
+
+    printf("%-24s chord %d  level %+6.2f dB  pitch %7.2f Hz %+6.2f cents  spectrum %5.2f dB",
+           path, chord + 1, level, m->peak, cents, worst);
+    if (worst_band >= 0) printf(" (%.0f Hz)", band_centre(worst_band));
+
+    if (fabs(level) > TOL_LEVEL) failed |= 1;
+    if (fabs(cents) > TOL_PITCH) failed |= 2;
+    if (worst > TOL_BAND) failed |= 4;
+    if (failed) {
+        printf("  FAIL:%s%s%s\n", (failed & 1) ? " level" : "", (failed & 2) ? " pitch" : "",
+               (failed & 4) ? " spectrum" : "");
+    } else {
+        printf("  ok\n");
+    }
+    return failed;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: buttery-ratecheck reference.wav other.wav...\n");
+        return 1;
+    }
+
+    Wav ref;
+    Measure ref_m[CHECK_CHORDS];
+    if (wav_read(argv[1], &ref) < 0) {
+        fprintf(stderr, "cannot read %s (float stereo WAV from buttery-render)\n", argv[1]);
+        return 1;
+    }
+    for (int c = 0; c < CHECK_CHORDS; c++) {
+        if (measure(&ref, c, 0.0, &ref_m[c]) < 0) {
+            fprintf(stderr, "%s: too short (render at least %d seconds)\n", argv[1], CHECK_CHORDS + 1);
+            return 1;
+        }
+        printf("%-24s chord %d  level %6.2f dBFS  pitch %7.2f Hz  (reference, %d Hz)\n",
+               argv[1], c + 1, ref_m[c].level, ref_m[c].peak, ref.rate);
+    }
+
+    int failures = 0;
+    for (int i = 2; i < argc; i++) {
+        Wav w;
+        if (wav_read(argv[i], &w) < 0) {
+            fprintf(stderr, "cannot read %s\n", argv[i]);
+            failures++;
+            continue;
+        }
+        for (int c = 0; c < CHECK_CHORDS; c++) {
+            Measure m;
+            if (measure(&w, c, ref_m[c].peak, &m) < 0) {
+                fprintf(stderr, "%s: too short\n", argv[i]);
+                failures++;
+                break;
+            }
+            if (compare(argv[i], c, &ref_m[c], &m)) failures++;
+        }
+        free(w.mono);
+    }
+    free(ref.mono);
+
+    if (failures) {
+        printf("%d mismatch%s across rates\n", failures, failures == 1 ? "" : "es");
+        return 1;
+    }
+    printf("rates match\n");
+    return 0;
+}
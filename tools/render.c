@@ -0,0 +1,169 @@
+// Headless render
+// Plays a short chord sequence through the engine and writes a 32-bit float
+// stereo WAV, then prints the engine statistics. Needs no display or audio
+// device, so it runs on servers and in test harnesses. With -i it starts
+// from a captured engine state (see snapshot.h) instead of a fresh engine.
+// With -t, a build with make TRACE=1 also writes the render's trace as a
+// Chrome trace JSON file (see trace.h). A build with make PERF=1 ends with
+// the hardware counter report (see perfctr.h).
+//
+//   ./buttery-render [-r rate] [-b block] [-s seconds] [-p preset.json]
+//                    [-i state.bsnap] [-t trace.json] out.wav
+
+#include "engine.h"
+#include "snapshot.h"
+#include "trace.h"
+#include "perfctr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define RENDER_MAX_BLOCK PART_MAX_FRAMES
+
+static void write_u32(FILE *f, uint32_t v) {
+    unsigned char b[4] = {v & 0xff, (v >> 8) & 0xff, (v >> 16) & 0xff, (v >> 24) & 0xff};
+    fwrite(b, 1, 4, f);
+}
+
+static void write_u16(FILE *f, uint16_t v) {
+    unsigned char b[2] = {v & 0xff, (v >> 8) & 0xff};
+    fwrite(b, 1, 2, f);
+}
+
+// WAVE_FORMAT_IEEE_FLOAT, 2 channels
+static void write_wav_header(FILE *f, int rate, uint32_t frames) {
+    uint32_t data_size = frames * 2 * sizeof(float);
+    fwrite("RIFF", 1, 4, f);
+    write_u32(f, 36 + data_size);
+    fwrite("WAVEfmt ", 1, 8, f);
+    write_u32(f, 16);
+    write_u16(f, 3);
+    write_u16(f, 2);
+    write_u32(f, rate);
+    write_u32(f, rate * 2 * sizeof(float));
+    write_u16(f, 2 * sizeof(float));
+    write_u16(f, 32);
+    fwrite("data", 1, 4, f);
+    write_u32(f, data_size);
+}
+
+static void queue(Engine *e, int type, int data1, int data2) {
+    MidiEvent ev = {type, 0, data1, data2};
+    engine_queue_midi(e, &ev);
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: buttery-render [-r rate] [-b block] [-s seconds] [-p preset.json] "
+                    "[-i state.bsnap] [-t trace.json] out.wav\n");
+}
+
+int main(int argc, char **argv) {
+    int rate = DEFAULT_SAMPLE_RATE;
+    int block = 256;
+    float seconds = 4.0f;
+    const char *preset = NULL;
+    const char *state = NULL;
+    const char *trace = NULL;
+    const char *out_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            rate = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            block = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seconds = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            preset = argv[++i];
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            state = argv[++i];
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            trace = argv[++i];
+        } else if (argv[i][0] != '-' && !out_path) {
+            out_path = argv[i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (!out_path || block < 1 || block > RENDER_MAX_BLOCK || seconds <= 0.0f) {
+        usage();
+        return 1;
+    }
+
+    Engine *e = engine_create(rate);
+    if (!e) {
+        fprintf(stderr, "engine initialization failed\n");
+        return 1;
+    }
+    rate = (int)sample_rate;
+    TRACE_THREAD("render");
+
+    // Offline there is no deadline, and the output must not depend on timing
+    e->govern = 0;
+
+    if (preset && engine_load_preset(e, 0, preset) < 0) {
+        fprintf(stderr, "cannot read %s\n", preset);
+        engine_destroy(e);
+        return 1;
+    }
+
+    // A snapshot only restores at the rate it was captured at
+    if (state && snapshot_load(e, state) < 0) {
+        fprintf(stderr, "cannot restore %s (damaged, other build, or not %d Hz)\n", state, rate);
+        engine_destroy(e);
+        return 1;
+    }
+
+    FILE *f = fopen(out_path, "wb");
+    if (!f) {
+        fprintf(stderr, "cannot write %s\n", out_path);
+        engine_destroy(e);
+        return 1;
+    }
+
+    uint32_t total = (uint32_t)(seconds * rate);
+    write_wav_header(f, rate, total);
+
+    // C minor, F minor, G major: one chord per second, released for the tail
+    static const int chords[3][3] = {{60, 63, 67}, {65, 68, 72}, {67, 71, 74}};
+    int chord = -1;
+    float buffer[RENDER_MAX_BLOCK * 2];
+
+    for (uint32_t done = 0; done < total; done += block) {
+        int n = (total - done < (uint32_t)block) ? (int)(total - done) : block;
+
+        int step = (int)(done / rate);
+        int want = (seconds - done / (float)rate > 1.0f) ? step % 3 : -1;
+        if (want != chord) {
+            for (int k = 0; chord >= 0 && k < 3; k++) queue(e, MIDI_NOTE_OFF, chords[chord][k], 0);
+            for (int k = 0; want >= 0 && k < 3; k++) queue(e, MIDI_NOTE_ON, chords[want][k], 100);
+            chord = want;
+        }
+
+        engine_render(e, buffer, n);
+        fwrite(buffer, sizeof(float), n * 2, f);
+    }
+    fclose(f);
+
+    EngineStats st;
+    engine_stats(e, &st);
+    printf("%s: %u frames at %d Hz, block %d\n", out_path, total, rate, block);
+    printf("blocks %lu  load %.1f%%  peak %.1f%%  idle %lu  midi dropped %lu\n",
+           st.blocks, st.load * 100.0f, st.peak_load * 100.0f, st.idle_blocks, st.midi_dropped);
+
+    perf_report(stdout);
+
+    if (trace) {
+        int events = trace_dump(trace);
+        if (events >= 0) {
+            printf("%s: %d trace events\n", trace, events);
+        } else {
+            fprintf(stderr, "cannot write %s (tracing needs make TRACE=1)\n", trace);
+        }
+    }
+
+    engine_destroy(e);
+    return 0;
+}
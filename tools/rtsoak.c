@@ -0,0 +1,208 @@
+#define _POSIX_C_SOURCE 199309L
+
+// Real-time safety soak
+// Drives the engine offline through every MIDI path, every preset slot (as
+// the background loader hands them over), the preset bank and the output
+// ring, in a build with the real-time checker on (make rtcheck). Anything
+// the audio path allocates, locks or does I/O for is reported with a
+// backtrace, and the exit status is 1.
+//
+//   ./buttery-rtsoak [-r rate]
+
+#include "engine.h"
+#include "renderer.h"
+#include "bank.h"
+#include "rtcheck.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SOAK_BLOCK 256
+#define SOAK_PARTS 3                // Parts listening on channels 1-3
+#define SOAK_MPE_MEMBERS 4          // Member channels in the MPE zone
+#define SOAK_LOAD_BLOCKS 2000       // Longest wait for a preset handover
+
+static float buffer[SOAK_BLOCK * 2];
+
+static void send(Engine *e, int type, int channel, int data1, int data2) {
+    MidiEvent ev = {type, channel, data1, data2};
+    engine_queue_midi(e, &ev);
+}
+
+static void render(Engine *e, int blocks) {
+    for (int i = 0; i < blocks; i++) {
+        engine_render(e, buffer, SOAK_BLOCK);
+    }
+}
+
+static void chord(Engine *e, int channel, int root, int velocity) {
+    send(e, MIDI_NOTE_ON, channel, root, velocity);
+    send(e, MIDI_NOTE_ON, channel, root + 4, velocity);
+    send(e, MIDI_NOTE_ON, channel, root + 7, velocity);
+}
+
+static void release(Engine *e, int channel, int root) {
+    send(e, MIDI_NOTE_OFF, channel, root, 0);
+    send(e, MIDI_NOTE_ON, channel, root + 4, 0);   // Running-status style off
+    send(e, MIDI_NOTE_OFF, channel, root + 7, 64);
+}
+
+static void rpn(Engine *e, int channel, int number, int value) {
+    send(e, MIDI_CONTROL, channel, CC_RPN_MSB, number >> 7);
+    send(e, MIDI_CONTROL, channel, CC_RPN_LSB, number & 127);
+    send(e, MIDI_CONTROL, channel, CC_DATA_ENTRY_MSB, value);
+}
+
+// Notes, expression, every controller, RPNs and NRPNs on every part
+static void soak_midi(Engine *e) {
+    // Every parameter behind a learned controller, so the CC sweep reaches
+    // each setter from the audio thread
+    engine_lock(e);
+    for (int id = 0; id < PARAM_COUNT; id++) {
+        midimap_learn(&e->midimap, id / 32, 16 + id % 32, (ParamId)id);
+    }
+    for (int i = 0; i < SOAK_PARTS; i++) {
+        e->multi.parts[i].enabled = 1;
+        e->multi.parts[i].channel = i;
+    }
+    engine_unlock(e);
+
+    for (int channel = 0; channel < SOAK_PARTS; channel++) {
+        chord(e, channel, 48 + channel * 5, 100);
+        render(e, 20);
+        for (int cc = 0; cc < 128; cc++) {
+            for (int value = 0; value < 128; value += 42) {
+                send(e, MIDI_CONTROL, channel, cc, value);
+            }
+            render(e, 1);
+        }
+        for (int bend = 0; bend <= 16383; bend += 2048) {
+            send(e, MIDI_PITCH_BEND, channel, 0, bend);
+            send(e, MIDI_CHANNEL_PRESSURE, channel, bend >> 7, 0);
+            send(e, MIDI_POLY_PRESSURE, channel, 48 + channel * 5, bend >> 7);
+            render(e, 2);
+        }
+        rpn(e, channel, RPN_PITCH_BEND_RANGE, 12);
+        send(e, MIDI_CONTROL, channel, CC_NRPN_MSB, 1);
+        send(e, MIDI_CONTROL, channel, CC_NRPN_LSB, 8);
+        send(e, MIDI_CONTROL, channel, CC_DATA_ENTRY_MSB, 90);
+        send(e, MIDI_CONTROL, channel, CC_DATA_ENTRY_LSB, 10);
+        release(e, channel, 48 + channel * 5);
+        render(e, 200);
+    }
+
+    // MPE lower zone on the first part: per-note bend, pressure and timbre
+    rpn(e, 0, RPN_MPE_CONFIG, SOAK_MPE_MEMBERS);
+    render(e, 2);
+    for (int m = 1; m <= SOAK_MPE_MEMBERS; m++) {
+        send(e, MIDI_NOTE_ON, m, 55 + m * 3, 90);
+        send(e, MIDI_PITCH_BEND, m, 0, 8192 + m * 900);
+        send(e, MIDI_CHANNEL_PRESSURE, m, 30 * m, 0);
+        send(e, MIDI_CONTROL, m, CC_MPE_TIMBRE, 20 * m);
+        render(e, 4);
+    }
+    for (int m = 1; m <= SOAK_MPE_MEMBERS; m++) send(e, MIDI_NOTE_OFF, m, 55 + m * 3, 0);
+    rpn(e, 0, RPN_MPE_CONFIG, 0);
+    render(e, 200);
+
+    // Flood the queue past capacity
+    for (int i = 0; i < ENGINE_MIDI_QUEUE * 2; i++) {
+        send(e, (i & 1) ? MIDI_NOTE_OFF : MIDI_NOTE_ON, i % SOAK_PARTS, 36 + i % 48, 80);
+    }
+    render(e, 400);
+}
+
+// Hand a load to the audio thread while a chord plays, and wait for it
+static int handover(Engine *e, int part) {
+    int applied_part, applied_slot;
+    char name[PART_NAME_LEN];
+    chord(e, part, 60, 100);
+    for (int i = 0; i < SOAK_LOAD_BLOCKS; i++) {
+        render(e, 1);
+        if (loader_poll_applied(&e->loader, &applied_part, &applied_slot, name, sizeof(name))) {
+            render(e, 40);     // Through the crossfade
+            release(e, part, 60);
+            render(e, 40);
+            return 1;
+        }
+    }
+    release(e, part, 60);
+    return 0;
+}
+
+// Every preset slot through the background loader, then the compiled bank
+static int soak_presets(Engine *e) {
+    int loaded = 0;
+    for (int slot = 1; slot <= 99; slot++) {
+        if (!preset_exists(slot)) continue;
+        int part = slot % SOAK_PARTS;
+        loader_request(&e->loader, part, slot, patch_defaults());
+        loaded += handover(e, part);
+    }
+
+    Bank bank;
+    if (bank_open(&bank, BANK_FILE) == 0) {
+        for (int i = 0; i < bank_count(&bank); i++) {
+            Patch patch;
+            bank_get(&bank, i, &patch);
+            loader_request_patch(&e->loader, i % SOAK_PARTS, bank_entry(&bank, i)->slot, &patch,
+                                 bank_entry(&bank, i)->name);
+            loaded += handover(e, i % SOAK_PARTS);
+        }
+        bank_close(&bank);
+    }
+    return loaded;
+}
+
+// The audio callback side: the render thread fills the ring, this thread
+// takes it out a device period at a time
+static void soak_ring(Engine *e) {
+    Renderer *r = malloc(sizeof(Renderer));
+    if (!r || renderer_start(r, e, 512) < 0) {
+        free(r);
+        return;
+    }
+    struct timespec period = {0, 1000000};
+    chord(e, 0, 57, 110);
+    for (int i = 0; i < 500; i++) {
+        if (i == 250) release(e, 0, 57);
+        renderer_read(r, buffer, 128);
+        nanosleep(&period, NULL);
+    }
+    renderer_stop(r);
+    free(r);
+}
+
+int main(int argc, char **argv) {
+    int rate = DEFAULT_SAMPLE_RATE;
+    if (argc == 3 && strcmp(argv[1], "-r") == 0) {
+        rate = atoi(argv[2]);
+    } else if (argc != 1) {
+        fprintf(stderr, "usage: buttery-rtsoak [-r rate]\n");
+        return 1;
+    }
+
+    Engine *e = engine_create(rate);
+    if (!e) {
+        fprintf(stderr, "engine initialization failed\n");
+        return 1;
+    }
+
+    // The telemetry page is written at the end of every block
+    e->telemetry = telemetry_create("/buttery-rtsoak", rate);
+
+    soak_midi(e);
+    int presets = soak_presets(e);
+    soak_ring(e);
+
+    EngineStats st;
+    engine_stats(e, &st);
+    telemetry_destroy(e->telemetry, "/buttery-rtsoak");
+    engine_destroy(e);
+
+    printf("rtsoak: %lu blocks, %d presets handed over, %lu MIDI events dropped\n",
+           st.blocks, presets, st.midi_dropped);
+    rtcheck_report(stdout);
+    return rtcheck_violations() > 0 ? 1 : 0;
+}
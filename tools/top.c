@@ -0,0 +1,129 @@
+#define _POSIX_C_SOURCE 199309L
+
+// Live monitor for a running synth
+// Maps the telemetry page the synth publishes every block (see telemetry.h)
+// and redraws its statistics a few times a second, for a second terminal or
+// an SSH session. Reads shared memory only: nothing is asked of the synth
+// process, which does not know it is being watched. Waits for a synth to
+// start, and picks up a restarted one.
+//
+//   ./buttersynth-top [-d seconds] [-n updates]
+
+#include "telemetry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TOP_DELAY   0.25        // Seconds between updates (default)
+#define TOP_STALE   1.0         // No block for this long: the audio has stopped
+#define TOP_BAR     30          // Load bar width
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void sleep_seconds(double seconds) {
+    struct timespec ts = {(time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9)};
+    nanosleep(&ts, NULL);
+}
+
+static void bar(float load) {
+    int n = (int)(load * TOP_BAR + 0.5f);
+    if (n > TOP_BAR) n = TOP_BAR;
+    if (n < 0) n = 0;
+    printf("[");
+    for (int i = 0; i < TOP_BAR; i++) putchar(i < n ? '#' : '.');
+    printf("]");
+}
+
+static void draw(const Telemetry *t, const Telemetry *last, double interval) {
+    double now = now_seconds();
+    const char *state = (now - t->time > TOP_STALE) ? "STALLED" : t->idle ? "idle" : "running";
+    unsigned long up = t->rate > 0 ? (unsigned long)(t->frames / (uint64_t)t->rate) : 0;
+
+    // Home and clear, then one screen
+    printf("\033[H\033[2J");
+    printf("buttersynth-top   pid %d   %d Hz   audio %02lu:%02lu:%02lu   %s\n\n", t->pid, t->rate,
+           up / 3600, up / 60 % 60, up % 60, state);
+
+    printf("DSP load   %5.1f%%  ", t->load * 100.0f);
+    bar(t->load);
+    printf("  peak %.1f%%\n", t->peak_load * 100.0f);
+    printf("Voices     %d in %d part%s\n", t->active_voices, t->active_parts,
+           t->active_parts == 1 ? "" : "s");
+
+    printf("Governor   %s   restored %llu   stolen %llu\n", governor_level_name(t->quality),
+           (unsigned long long)t->quality_restores, (unsigned long long)t->voices_stolen);
+    printf("           entered");
+    for (int i = 1; i < QUALITY_LEVELS; i++) {
+        printf("  %s %llu", governor_level_name(i), (unsigned long long)t->quality_steps[i]);
+    }
+    printf("\n");
+    printf("Limiter    %.1f dB\n", t->limiter_gr);
+
+    printf("MIDI       latency %.2f ms (peak %.2f)   queue %d (peak %d)   dropped %llu\n",
+           t->midi_latency, t->midi_latency_peak, t->midi_queue, t->midi_queue_peak,
+           (unsigned long long)t->midi_dropped);
+
+    double ms = t->rate > 0 ? 1000.0 / t->rate : 0.0;
+    printf("Output     ring %d/%d frames (%.1f ms)   xruns %u",
+           t->ring_frames, t->ring_depth, t->ring_depth * ms, t->underruns);
+    if (last) printf(" (+%u)", t->underruns - last->underruns);
+    printf("\n");
+
+    printf("Blocks     %llu", (unsigned long long)t->blocks);
+    if (last && interval > 0.0) {
+        printf("   %.0f/s", (double)(t->blocks - last->blocks) / interval);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    double delay = TOP_DELAY;
+    long updates = -1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            delay = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            updates = atol(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: buttersynth-top [-d seconds] [-n updates]\n");
+            return 1;
+        }
+    }
+    if (delay < 0.01) delay = 0.01;
+
+    const Telemetry *page = NULL;
+    Telemetry current, last;
+    int have_last = 0;
+    double last_time = 0.0;
+
+    for (long n = 0; updates < 0 || n < updates; n++) {
+        // Attach when a synth appears; let go when it exits (or restarts)
+        if (page && __atomic_load_n(&page->magic, __ATOMIC_ACQUIRE) != TELEMETRY_MAGIC) {
+            telemetry_detach(page);
+            page = NULL;
+            have_last = 0;
+        }
+        if (!page) page = telemetry_attach(TELEMETRY_NAME);
+
+        if (!page) {
+            printf("\033[H\033[2Jbuttersynth-top   waiting for the synth (/dev/shm%s)\n", TELEMETRY_NAME);
+            fflush(stdout);
+        } else if (telemetry_read(page, &current) == 0) {
+            double now = now_seconds();
+            draw(&current, have_last ? &last : NULL, now - last_time);
+            last = current;
+            last_time = now;
+            have_last = 1;
+        }
+        if (updates < 0 || n + 1 < updates) sleep_seconds(delay);
+    }
+
+    telemetry_detach(page);
+    return 0;
+}